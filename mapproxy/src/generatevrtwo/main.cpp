@@ -29,12 +29,21 @@
 #include <functional>
 #include <map>
 #include <numeric>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <exception>
+#include <fstream>
 
 #include <boost/optional.hpp>
 #include <boost/utility/in_place_factory.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
 #include <boost/thread.hpp>
 #include <boost/format.hpp>
 #include <boost/range/adaptor/reversed.hpp>
@@ -55,6 +64,7 @@
 
 #include "geo/geodataset.hpp"
 #include "geo/gdal.hpp"
+#include "geo/csconvertor.hpp"
 
 #include "gdal-drivers/register.hpp"
 #include "gdal-drivers/solid.hpp"
@@ -210,6 +220,11 @@ struct Config {
     math::Size2 minOvrSize;
     boost::optional<int> wrapx;
     bool overwrite;
+    bool pipelined;
+    std::size_t pipelineLimit;
+    bool update;
+    std::vector<math::Extents2> changed;
+    std::vector<fs::path> changedFiles;
     Color::optional background;
     std::vector<std::string> co;
 
@@ -222,6 +237,9 @@ struct Config {
         : tileSize(def::tileSize)
         , minOvrSize(def::minOvrSize)
         , overwrite(false)
+        , pipelined(false)
+        , pipelineLimit(16)
+        , update(false)
     {}
 };
 
@@ -271,6 +289,30 @@ void VrtWo::configuration(po::options_description &cmdline
         ("overwrite", po::value(&config_.overwrite)->required()
          ->default_value(false)->implicit_value(true)
         , "Overwrite existing dataset.")
+        ("pipelined", po::value(&config_.pipelined)->required()
+         ->default_value(false)->implicit_value(true)
+        , "Generate all overviews in one pass. Overview tiles are warped "
+         "from in-memory tiles of previous overview as soon as they are "
+         "available instead of reading whole previous overview back "
+         "from disk.")
+        ("pipelineLimit", po::value(&config_.pipelineLimit)
+         ->default_value(config_.pipelineLimit)->required()
+        , "Soft limit of number of whole tiles held in memory in pipelined "
+         "mode; new tiles are not started when reached unless there is "
+         "nothing else to do. 0 means no limit.")
+        ("update", po::value(&config_.update)->required()
+         ->default_value(false)->implicit_value(true)
+        , "Update existing output incrementally: regenerate only overview "
+         "tiles affected by regions given by --changed and --changedFile. "
+         "All other options must be the same as when the output was "
+         "generated.")
+        ("changed", po::value<std::vector<std::string>>()
+        , "Changed region of input dataset in its SRS as llx,lly,urx,ury; "
+         "can be used multiple times. Used only in update mode.")
+        ("changedFile", po::value(&config_.changedFiles)
+        , "Changed (or added) source file of the input dataset, its extents "
+         "are used as a changed region; can be used multiple times. Used only "
+         "in update mode.")
         ("wrapx", po::value<int>()
          ->implicit_value(0)
         , "Wrap dataset in X direction. Optional. Value indicates number "
@@ -311,6 +353,43 @@ void VrtWo::configure(const po::variables_map &vars)
         config_.wrapx = vars["wrapx"].as<int>();
     }
 
+    if (vars.count("changed")) {
+        for (const auto &raw
+                 : vars["changed"].as<std::vector<std::string>>())
+        {
+            std::vector<std::string> parts;
+            ba::split(parts, raw, ba::is_any_of(","));
+            if (parts.size() != 4) {
+                throw po::validation_error
+                    (po::validation_error::invalid_option_value
+                     , "changed", raw);
+            }
+
+            try {
+                config_.changed.emplace_back
+                    (boost::lexical_cast<double>(parts[0])
+                     , boost::lexical_cast<double>(parts[1])
+                     , boost::lexical_cast<double>(parts[2])
+                     , boost::lexical_cast<double>(parts[3]));
+            } catch (const boost::bad_lexical_cast&) {
+                throw po::validation_error
+                    (po::validation_error::invalid_option_value
+                     , "changed", raw);
+            }
+        }
+    }
+
+    if (config_.update) {
+        if (config_.changed.empty() && config_.changedFiles.empty()) {
+            throw po::error("Update mode needs at least one --changed "
+                            "or --changedFile.");
+        }
+        if (config_.pipelined) {
+            throw po::error("--update and --pipelined are mutually "
+                            "exclusive.");
+        }
+    }
+
     if (!vars.count("co")) {
         config_.co = def::createOptions;
     }
@@ -364,6 +443,9 @@ void VrtWo::configure(const po::variables_map &vars)
                 if (config_.wrapx) { return os << "true, " << *config_.wrapx; }
                 return os << "false";
             })
+        << "\n\tpipelined = " << std::boolalpha << config_.pipelined
+        << "\n\tpipelineLimit = " << config_.pipelineLimit
+        << "\n\tupdate = " << config_.update
         << "\n\tbackground = " << config_.background
         << "\n\tco = " << utility::join(config_.co, ", ")
         << utility::LManip([&](std::ostream &os) -> std::ostream& {
@@ -1044,6 +1126,217 @@ void createOutputDataset(const geo::GeoDataset &original
     dst.flush();
 }
 
+/** Pixel layout of one overview level.
+ */
+struct LevelLayout {
+    math::Extents2 extents;
+    math::Size2 size;
+    math::Size2 tiled;
+    math::Size2 ts;
+
+    /** Tile size in real extents.
+     */
+    math::Size2f tileSize;
+
+    /** Pixel size in real extents.
+     */
+    math::Size2f pixelSize;
+
+    /** Extent's upper-left corner is origin for tile calculations.
+     */
+    math::Point2 origin;
+
+    /** Size of last tile in row/column.
+     */
+    math::Size2 lts;
+
+    LevelLayout(const math::Extents2 &extents, const math::Size2 &size
+                , const math::Size2 &tiled, const math::Size2 &ts)
+        : extents(extents), size(size), tiled(tiled), ts(ts)
+        , origin(ul(extents))
+        , lts(size.width - (tiled.width - 1) * ts.width
+              , size.height - (tiled.height - 1) * ts.height)
+    {
+        auto es(math::size(extents));
+        tileSize = math::Size2f((es.width * ts.width) / size.width
+                                , (es.height * ts.height) / size.height);
+        pixelSize = math::Size2f(es.width / size.width
+                                 , es.height / size.height);
+    }
+
+    math::Point2i tile(int index) const {
+        return math::Point2i(index % tiled.width, index / tiled.width);
+    }
+
+    int index(const math::Point2i &tile) const {
+        return tile(1) * tiled.width + tile(0);
+    }
+
+    math::Size2 pxSize(const math::Point2i &tile) const {
+        bool lastX(tile(0) == (tiled.width - 1));
+        bool lastY(tile(1) == (tiled.height - 1));
+        return math::Size2(lastX ? lts.width : ts.width
+                           , lastY ? lts.height : ts.height);
+    }
+
+    math::Extents2 tileExtents(const math::Point2i &tile) const {
+        bool lastX(tile(0) == (tiled.width - 1));
+        bool lastY(tile(1) == (tiled.height - 1));
+
+        math::Point2 ul(origin(0) + tileSize.width * tile(0)
+                        , origin(1) - tileSize.height * tile(1));
+        math::Point2 lr(lastX ? extents.ur(0) : ul(0) + tileSize.width
+                        , lastY ? extents.ll(1): ul(1) - tileSize.height);
+
+        return math::Extents2(ul(0), lr(1), lr(0), ul(1));
+    }
+
+    /** Tile's rectangle in level's pixel space.
+     */
+    Rect tileRect(const math::Point2i &tile) const {
+        return Rect(math::Point2i(tile(0) * ts.width, tile(1) * ts.height)
+                    , pxSize(tile));
+    }
+};
+
+/** Sets PREDICTOR create option based on source data type if present but
+ *  not specified by user.
+ */
+void adjustPredictor(geo::Options &createOptions, const geo::GeoDataset &src)
+{
+    // If create options contain PREDICTOR, check/set its value based on
+    // original dataset type.
+    auto &opts(createOptions.options);
+    auto it(std::find_if( opts.begin(), opts.end()
+                         , [](const geo::Options::Option &op)
+                           {
+                                return op.first == "PREDICTOR";
+                           }));
+
+    if (it == opts.end()) { return; }
+
+    // find out what the value of predictor should be
+    auto predictor([&]() -> std::string {
+        switch (src.descriptor().dataType) {
+        case ::GDT_Float32:
+        case ::GDT_Float64:
+            return "3";
+        default:
+            break;
+        }
+        return "2";
+    }());
+
+    // set predictor to optimal
+    if (it->second.empty()) {
+        it->second = predictor;
+
+    // leave it if predictor is turned off
+    } else if (it->second == "1") {
+
+    // if predictor is set, check if the value is right
+    } else if (it->second != predictor) {
+        LOGTHROW(err2, std::runtime_error)
+            << "PREDICTOR value and bandtype mismatch. Use 2 for "
+            << "integer and 3 for floating point or leave without "
+            << "value to be determined automatically.";
+    }
+}
+
+/** Creates overview VRT dataset. Sets PREDICTOR create option based on
+ *  source data type if not specified by user.
+ */
+VrtDs createOverviewVrt(const Config &config, const fs::path &srcPath
+                        , const fs::path &dir, const fs::path &ovrPath
+                        , const math::Size2 &size
+                        , geo::Options &createOptions
+                        , MaskType maskType)
+{
+    VrtDs ovr([&]() -> VrtDs
+    {
+        auto src(geo::GeoDataset::open(srcPath));
+
+        adjustPredictor(createOptions, src);
+
+        return VrtDs(ovrPath, src.srs(), src.extents()
+                     , size, src.getFormat(), src.rawNodataValue()
+                     , maskType);
+    }());
+
+    ovr.addBackground(config.output / dir, config.background, fs::path());
+
+    return ovr;
+}
+
+fs::path tileName(const math::Point2i &tile)
+{
+    return str(boost::format("%d-%d.tif") % tile(0) % tile(1));
+}
+
+/** Writes warped tile to given path unless it is empty. Returns false for
+ *  empty tile (any previous version of the tile is left intact).
+ *
+ *  Tile is written into a temporary file that atomically replaces previous
+ *  version so readers never see incomplete file.
+ */
+bool writeTile(const Config &config, const geo::GeoDataset &src
+               , const geo::GeoDataset &tmp, const fs::path &tilePath
+               , const geo::Options &createOptions, MaskType maskType)
+{
+    // check result and skip if no need to store
+    if (emptyTile(config, tmp)) { return false; }
+
+    // make room for output file
+    const auto tmpPath(utility::addExtension(tilePath, ".tmp"));
+    fs::remove(tmpPath);
+
+    // strore result to file
+    createOutputDataset(src, tmp, tmpPath
+                        , createOptions // use modified options
+                        , maskType);
+    fs::rename(tmpPath, tilePath);
+    return true;
+}
+
+/** Stores warped tile in the overview unless it is empty. Returns false for
+ *  empty tile.
+ */
+bool storeTile(const Config &config, const geo::GeoDataset &src
+               , const geo::GeoDataset &tmp, VrtDs &ovr
+               , const fs::path &dir, const math::Point2i &tile
+               , const Rect &drect, const geo::Options &createOptions
+               , MaskType maskType)
+{
+    const auto name(tileName(tile));
+    if (!writeTile(config, src, tmp, config.output / dir / name
+                   , createOptions, maskType))
+    {
+        return false;
+    }
+
+    // store result
+    UTILITY_OMP(critical(createOverwiew_addSimpleSource))
+        for (std::size_t b(0), eb(ovr.bandCount()); b != eb; ++b) {
+            ovr.addSimpleSource(b, name, tmp, b, boost::none, drect);
+        }
+
+    return true;
+}
+
+void logTile(const utility::DurationMeter &timer, int id, int total
+             , int ovrIndex, const math::Point2i &tile
+             , const math::Size2 &pxSize, const math::Extents2 &te
+             , bool valid)
+{
+    LOG(info3)
+        << std::fixed
+        << "Processed tile #" << id << '/' << total << ' ' << ovrIndex
+        << '-' << tile(0) << '-' << tile(1) << " (size: " << pxSize
+        << ", extents: " << te << ") [" << (valid ? "valid" : "empty") << "]"
+        << "; duration: "
+        << utility::formatDuration(timer.duration()) << ".";
+}
+
 fs::path createOverview(const Config &config, int ovrIndex
                         , const fs::path &srcPath
                         , const fs::path &dir
@@ -1054,7 +1347,6 @@ fs::path createOverview(const Config &config, int ovrIndex
 {
     auto ovrName(dir / "ovr.vrt");
     auto ovrPath(config.output / ovrName);
-    const auto &ts(config.tileSize);
 
     LOG(info3)
         << "Creating overview #" << ovrIndex
@@ -1064,101 +1356,26 @@ fs::path createOverview(const Config &config, int ovrIndex
     // copy options so that the PREDICTOR can be possibly modified
     geo::Options createOptions(config.createOptions);
 
-    VrtDs ovr([&]() -> VrtDs
-    {
-        auto src(geo::GeoDataset::open(srcPath));
-
-        // If create options contain PREDICTOR, check/set its value based on
-        // original dataset type.
-        auto &opts(createOptions.options);
-        auto it(std::find_if( opts.begin(), opts.end()
-                             , [](const geo::Options::Option &op)
-                               {
-                                    return op.first == "PREDICTOR";
-                               }));
-
-        if (it != opts.end()) {
-            // find out what the value of predictor should be
-            auto predictor([&]() -> std::string {
-                switch (src.descriptor().dataType) {
-                case ::GDT_Float32:
-                case ::GDT_Float64:
-                    return "3";
-                default:
-                    break;
-                }
-                return "2";
-            }());
-
-            // set predictor to optimal
-            if (it->second.empty()) {
-                it->second = predictor;
-
-            // leave it if predictor is turned off
-            } else if (it->second == "1") {
-
-            // if predictor is set, check if the value is right
-            } else if (it->second != predictor) {
-                LOGTHROW(err2, std::runtime_error)
-                    << "PREDICTOR value and bandtype mismatch. Use 2 for "
-                    << "integer and 3 for floating point or leave without "
-                    << "value to be determined automatically.";
-            }
-        }
-
-        return VrtDs(ovrPath, src.srs(), src.extents()
-                     , size, src.getFormat(), src.rawNodataValue()
-                     , maskType);
-    }());
+    auto ovr(createOverviewVrt(config, srcPath, dir, ovrPath, size
+                               , createOptions, maskType));
 
-    (void) maskType;
-
-    auto extents(ovr.dataset().extents());
-    ovr.addBackground(config.output / dir, config.background, fs::path());
-
-
-    // compute tile size in real extents
-    auto tileSize([&]() -> math::Size2f
-    {
-        auto es(math::size(extents));
-        return math::Size2f((es.width * ts.width) / size.width
-                            , (es.height * ts.height) / size.height);
-    }());
-    // extent's upper-left corner is origin for tile calculations
-    math::Point2 origin(ul(extents));
+    const LevelLayout layout(ovr.dataset().extents(), size, tiled
+                             , config.tileSize);
 
     auto tc(math::area(tiled));
 
-    // last tile size
-    math::Size2 lts(size.width - (tiled.width - 1) * ts.width
-                    , size.height - (tiled.height - 1) * ts.height);
-
-    // Dataset dataset(srcPath.string());
-
     // use full dataset and distable safe-chunking
     geo::GeoDataset::WarpOptions warpOptions;
     warpOptions.overview = geo::GeoDataset::Overview();
     warpOptions.safeChunks = false;
 
-    // UTILITY_OMP(parallel for firstprivate(dataset) schedule(dynamic))
     UTILITY_OMP(parallel for schedule(dynamic))
         for (int i = 0; i < tc; ++i) {
             utility::DurationMeter timer;
-            math::Point2i tile(i % tiled.width, i / tiled.width);
-
-            bool lastX(tile(0) == (tiled.width - 1));
-            bool lastY(tile(1) == (tiled.height - 1));
-
-            math::Size2 pxSize(lastX ? lts.width : ts.width
-                               , lastY ? lts.height : ts.height);
-
-            // calculate extents
-            math::Point2 ul(origin(0) + tileSize.width * tile(0)
-                            , origin(1) - tileSize.height * tile(1));
-            math::Point2 lr(lastX ? extents.ur(0) : ul(0) + tileSize.width
-                            , lastY ? extents.ll(1): ul(1) - tileSize.height);
+            const auto tile(layout.tile(i));
+            const auto pxSize(layout.pxSize(tile));
+            const auto te(layout.tileExtents(tile));
 
-            math::Extents2 te(ul(0), lr(1), lr(0), ul(1));
             TIDGuard tg(str(boost::format("tile:%d-%d-%d")
                             % ovrIndex % tile(0) % tile(1)));
 
@@ -1171,71 +1388,1104 @@ fs::path createOverview(const Config &config, int ovrIndex
             // try warp
             auto src(geo::GeoDataset::open(srcPath));
 
-            // auto &src(dataset.ds());
-
-            // strore result to file
-            fs::path tileName(str(boost::format("%d-%d.tif")
-                                  % tile(0) % tile(1)));
-            fs::path tilePath(config.output / dir / tileName);
-
             auto tmp(createTmpDataset(src, te, pxSize, maskType));
 
             src.warpInto(tmp, config.resampling, warpOptions);
 
-            // check result and skip if no need to store
-            if (emptyTile(config, tmp)) {
-                auto id(++progress);
-                LOG(info3)
-                    << std::fixed
-                    << "Processed tile #" << id << '/' << total << ' '
-                    << ovrIndex
-                    << '-' << tile(0) << '-' << tile(1) << " (size: " << pxSize
-                    << ", extents: " << te << ") [empty]"
-                    << "; duration: "
-                    << utility::formatDuration(timer.duration()) << ".";
-                continue;
+            const auto valid(storeTile(config, src, tmp, ovr, dir, tile
+                                       , layout.tileRect(tile)
+                                       , createOptions, maskType));
+
+            logTile(timer, ++progress, total, ovrIndex, tile, pxSize, te
+                    , valid);
+        }
+
+    ovr.flush();
+
+    return ovrName;
+}
+
+/** Pipelined overview generation.
+ *
+ *  All overview levels are generated at once. Tile at level N + 1 is warped
+ *  from in-memory tiles of level N as soon as they are available, i.e.
+ *  previous level is never read back from disk. Source region of a tile is
+ *  its 2x2 block of previous level's tiles plus a margin covering the
+ *  resampling kernel; the margin makes the tile depend on up to 4x4 tiles.
+ *
+ *  Finished tile is kept in memory in full only until the tile it is part of
+ *  (its owner) is done; then only the margin strips needed by other
+ *  dependents are kept. Everything is released once all dependents are done.
+ *
+ *  Ready tiles from higher levels are preferred. Level 0 tiles needed by
+ *  partially satisfied tiles go next, then fresh level 0 tiles in Z-order.
+ *  Fresh tiles are not started when number of full tiles held in memory
+ *  reaches the limit (--pipelineLimit) unless there is nothing else to do,
+ *  i.e. the limit is soft.
+ */
+class OverviewPipeline {
+public:
+    OverviewPipeline(const Config &config, const Setup &setup
+                     , std::atomic<int> &progress, int total);
+
+    /** Generates all overviews, returns their paths relative to output.
+     */
+    std::vector<fs::path> run();
+
+private:
+    /** Part of warped tile kept in memory.
+     */
+    struct Piece {
+        /** Rectangle in level's pixel space.
+         */
+        Rect rect;
+        cv::Mat data;
+
+        Piece(const Rect &rect, const cv::Mat &data)
+            : rect(rect), data(data) {}
+
+        typedef std::vector<Piece> list;
+    };
+
+    struct Tile {
+        typedef std::unique_ptr<Tile> pointer;
+        typedef std::vector<pointer> list;
+
+        /** Tiles at previous level this tile is warped from.
+         */
+        std::vector<int> deps;
+
+        /** Tiles at next level warped from this tile.
+         */
+        std::vector<int> dependents;
+
+        /** Tile at next level this tile is part of, -1 if none.
+         */
+        int owner;
+
+        /** Region of previous level needed by this tile (pixel space).
+         */
+        Rect region;
+
+        /** Number of unfinished tiles in deps.
+         */
+        int missing;
+
+        /** Number of unfinished tiles in dependents.
+         */
+        int consumers;
+
+        /** Tile has been started.
+         */
+        bool started;
+
+        /** Tile has been finished.
+         */
+        bool done;
+
+        /** Pieces of warped non-empty tile kept for dependents: whole tile
+         *  first, then only strips needed by unfinished dependents.
+         */
+        Piece::list pieces;
+
+        /** Pieces hold whole tile.
+         */
+        bool full;
+
+        /** Guards pieces.
+         */
+        std::mutex mutex;
+
+        Tile()
+            : owner(-1), missing(), consumers(), started(), done()
+            , full()
+        {}
+    };
+
+    struct Level {
+        fs::path dir;
+        fs::path ovrName;
+        LevelLayout layout;
+        geo::Options createOptions;
+        std::unique_ptr<VrtDs> ovr;
+        Tile::list tiles;
+
+        Level(const fs::path &dir, const LevelLayout &layout
+              , const geo::Options &createOptions)
+            : dir(dir), ovrName(dir / "ovr.vrt"), layout(layout)
+            , createOptions(createOptions)
+        {}
+    };
+
+    struct Job {
+        int level;
+        std::uint64_t order;
+        int index;
+
+        Job(int level, std::uint64_t order, int index)
+            : level(level), order(order), index(index) {}
+
+        // priority queue pops largest element: higher level first, then
+        // lower Z-order
+        bool operator<(const Job &o) const {
+            if (level != o.level) { return level < o.level; }
+            return order > o.order;
+        }
+    };
+
+    void link(int level);
+
+    Job makeJob(int level, int index) const;
+
+    /** Picks next job to run. Must be called under lock.
+     */
+    boost::optional<Job> next();
+
+    void worker();
+
+    void process(const Job &job);
+
+    /** Finishes processing of tile. Must be called under lock.
+     */
+    void finish(const Job &job);
+
+    /** Keeps only parts of tile needed by unfinished dependents. Must be
+     *  called under lock.
+     */
+    void trim(int level, int index);
+
+    /** Builds in-memory source for tile at given level from tiles of previous
+     *  level.
+     */
+    geo::GeoDataset assemble(int level, const Tile &tile
+                             , const geo::GeoDataset &base);
+
+    const Config &config_;
+    const Setup &setup_;
+    std::atomic<int> &progress_;
+    const int total_;
+
+    std::vector<Level> levels_;
+
+    /** Level 0 tiles in Z-order.
+     */
+    std::vector<int> fresh_;
+    std::size_t nextFresh_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+
+    /** Ready tiles from levels > 0.
+     */
+    std::priority_queue<Job> ready_;
+
+    /** Level 0 tiles needed by partially satisfied level 1 tiles.
+     */
+    std::priority_queue<Job> wanted_;
+
+    std::size_t remaining_;
+    std::size_t running_;
+
+    /** Number of running level 0 tiles.
+     */
+    std::size_t runningLevel0_;
+
+    /** Number of tiles held in memory in full.
+     */
+    std::size_t resident_;
+    std::exception_ptr exception_;
+};
+
+/** Margin in source pixels covering resampling kernel.
+ */
+const int ResamplingMargin(16);
+
+std::uint64_t zorder(const math::Point2i &tile)
+{
+    std::uint64_t z(0);
+    for (int bit(0); bit < 32; ++bit) {
+        z |= (std::uint64_t((tile(0) >> bit) & 1) << (2 * bit));
+        z |= (std::uint64_t((tile(1) >> bit) & 1) << (2 * bit + 1));
+    }
+    return z;
+}
+
+/** Intersection of two rectangles, empty if they do not overlap.
+ */
+Rect intersect(const Rect &a, const Rect &b)
+{
+    const int x0(std::max(a.origin(0), b.origin(0)));
+    const int y0(std::max(a.origin(1), b.origin(1)));
+    const int x1(std::min(a.origin(0) + a.size.width
+                          , b.origin(0) + b.size.width));
+    const int y1(std::min(a.origin(1) + a.size.height
+                          , b.origin(1) + b.size.height));
+
+    if ((x0 >= x1) || (y0 >= y1)) { return Rect(); }
+    return Rect(math::Point2i(x0, y0), math::Size2(x1 - x0, y1 - y0));
+}
+
+/** Reads whole MEM dataset (organized in full-width single-row blocks) into
+ *  a matrix in native data type.
+ */
+cv::Mat readAll(const geo::GeoDataset &ds)
+{
+    const auto size(ds.size());
+    cv::Mat data;
+    for (int j(0); j != size.height; ++j) {
+        const auto row(ds.readBlock(math::Point2i(0, j), true).data);
+        if (data.empty()) {
+            data.create(size.height, size.width, row.type());
+        }
+        row.copyTo(data.row(j));
+    }
+    return data;
+}
+
+OverviewPipeline::OverviewPipeline(const Config &config, const Setup &setup
+                                   , std::atomic<int> &progress, int total)
+    : config_(config), setup_(setup), progress_(progress), total_(total)
+    , nextFresh_(), remaining_(), running_(), runningLevel0_(), resident_()
+{
+    const auto extents(geo::GeoDataset::open(config_.outputDataset)
+                       .extents());
+
+    for (std::size_t i(0); i != setup_.ovrSizes.size(); ++i) {
+        const auto &size(setup_.ovrSizes[i]);
+        const auto &tiled(setup_.ovrTiled[i]);
+
+        auto dir(str(boost::format("%d") % i));
+        fs::create_directories(config_.output / dir);
+
+        levels_.emplace_back
+            (dir, LevelLayout(extents, size, tiled, config_.tileSize)
+             , config_.createOptions);
+        auto &level(levels_.back());
+
+        LOG(info3)
+            << "Creating overview #" << i
+            << " of " << math::area(tiled) << " tiles in "
+            << (config_.output / level.ovrName) << " (pipelined).";
+
+        // all levels share srs, extents, format and nodata with the base
+        // dataset
+        level.ovr.reset(new VrtDs
+                        (createOverviewVrt
+                         (config_, config_.outputDataset, dir
+                          , config_.output / level.ovrName, size
+                          , level.createOptions, setup_.maskType)));
+
+        for (int t(0), et(math::area(tiled)); t != et; ++t) {
+            level.tiles.emplace_back(new Tile());
+        }
+
+        if (i) { link(i); }
+        remaining_ += level.tiles.size();
+    }
+
+    if (levels_.empty()) { return; }
+
+    // level 0 tiles in Z-order
+    const auto &layout(levels_.front().layout);
+    for (int t(0), et(levels_.front().tiles.size()); t != et; ++t) {
+        fresh_.push_back(t);
+    }
+    std::sort(fresh_.begin(), fresh_.end(), [&](int l, int r)
+    {
+        return zorder(layout.tile(l)) < zorder(layout.tile(r));
+    });
+}
+
+void OverviewPipeline::link(int li)
+{
+    auto &prevLevel(levels_[li - 1]);
+    const auto &prev(prevLevel.layout);
+    auto &level(levels_[li]);
+    const auto &layout(level.layout);
+
+    for (int t(0), et(level.tiles.size()); t != et; ++t) {
+        auto &tile(*level.tiles[t]);
+        const auto te(layout.tileExtents(layout.tile(t)));
+
+        // tile extents in previous level's pixel space plus margin, clipped
+        // to previous level
+        const auto &ps(prev.pixelSize);
+        int x0(std::floor((te.ll(0) - prev.origin(0)) / ps.width));
+        int x1(std::ceil((te.ur(0) - prev.origin(0)) / ps.width));
+        int y0(std::floor((prev.origin(1) - te.ur(1)) / ps.height));
+        int y1(std::ceil((prev.origin(1) - te.ll(1)) / ps.height));
+
+        x0 = std::max(x0 - ResamplingMargin, 0);
+        y0 = std::max(y0 - ResamplingMargin, 0);
+        x1 = std::min(x1 + ResamplingMargin, prev.size.width);
+        y1 = std::min(y1 + ResamplingMargin, prev.size.height);
+
+        tile.region = Rect(math::Point2i(x0, y0)
+                           , math::Size2(x1 - x0, y1 - y0));
+
+        for (int y(y0 / prev.ts.height), ey((y1 - 1) / prev.ts.height);
+             y <= ey; ++y)
+        {
+            for (int x(x0 / prev.ts.width), ex((x1 - 1) / prev.ts.width);
+                 x <= ex; ++x)
+            {
+                const auto dep(prev.index(math::Point2i(x, y)));
+                tile.deps.push_back(dep);
+                prevLevel.tiles[dep]->dependents.push_back(t);
             }
+        }
 
-            // make room for output file
-            fs::remove(tilePath);
+        tile.missing = tile.deps.size();
+    }
 
-            createOutputDataset(src, tmp, tilePath
-                                , createOptions // use modified options
-                                , maskType);
+    for (int t(0), et(prevLevel.tiles.size()); t != et; ++t) {
+        auto &tile(*prevLevel.tiles[t]);
+        tile.consumers = tile.dependents.size();
 
-            // store result
-            Rect drect(math::Point2i(tile(0) * ts.width, tile(1) * ts.height)
-                       , pxSize);
+        // tile is part of the tile covering its 2x2 block
+        const auto owner(prev.tile(t) / 2);
+        if ((owner(0) < layout.tiled.width)
+            && (owner(1) < layout.tiled.height))
+        {
+            tile.owner = layout.index(owner);
+        }
+    }
+}
 
-            UTILITY_OMP(critical(createOverwiew_addSimpleSource))
-                for (std::size_t b(0), eb(ovr.bandCount()); b != eb; ++b) {
-                    ovr.addSimpleSource(b, tileName, tmp, b
-                                        , boost::none, drect);
+OverviewPipeline::Job OverviewPipeline::makeJob(int level, int index) const
+{
+    return Job(level, zorder(levels_[level].layout.tile(index)), index);
+}
+
+boost::optional<OverviewPipeline::Job> OverviewPipeline::next()
+{
+    if (!ready_.empty()) {
+        const auto job(ready_.top());
+        ready_.pop();
+        return job;
+    }
+
+    auto &tiles(levels_.front().tiles);
+
+    // level 0 tiles completing partially satisfied tiles
+    while (!wanted_.empty()) {
+        const auto job(wanted_.top());
+        wanted_.pop();
+
+        auto &tile(*tiles[job.index]);
+        if (tile.started) { continue; }
+
+        tile.started = true;
+        ++runningLevel0_;
+        return job;
+    }
+
+    // fresh level 0 tiles
+    while ((nextFresh_ < fresh_.size())
+           && tiles[fresh_[nextFresh_]]->started)
+    {
+        ++nextFresh_;
+    }
+    if (nextFresh_ == fresh_.size()) { return boost::none; }
+
+    // limit number of full tiles in memory unless there is nothing else to
+    // do
+    if (config_.pipelineLimit
+        && ((resident_ + runningLevel0_) >= config_.pipelineLimit)
+        && running_)
+    {
+        return boost::none;
+    }
+
+    const auto index(fresh_[nextFresh_++]);
+    tiles[index]->started = true;
+    ++runningLevel0_;
+    return makeJob(0, index);
+}
+
+std::vector<fs::path> OverviewPipeline::run()
+{
+    if (levels_.empty()) { return {}; }
+
+    UTILITY_OMP(parallel)
+        worker();
+
+    if (exception_) { std::rethrow_exception(exception_); }
+
+    std::vector<fs::path> ovrNames;
+    for (auto &level : levels_) {
+        level.ovr->flush();
+        ovrNames.push_back(level.ovrName);
+    }
+    return ovrNames;
+}
+
+void OverviewPipeline::worker()
+{
+    for (;;) {
+        boost::optional<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                if (!remaining_ || exception_) { return; }
+                if ((job = next())) { break; }
+                cond_.wait(lock);
+            }
+            ++running_;
+        }
+
+        try {
+            process(*job);
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!exception_) { exception_ = std::current_exception(); }
+            cond_.notify_all();
+            return;
+        }
+    }
+}
+
+void OverviewPipeline::process(const Job &job)
+{
+    utility::DurationMeter timer;
+
+    auto &level(levels_[job.level]);
+    const auto &layout(level.layout);
+    auto &tile(*level.tiles[job.index]);
+
+    const auto ti(layout.tile(job.index));
+    const auto pxSize(layout.pxSize(ti));
+    const auto te(layout.tileExtents(ti));
+
+    TIDGuard tg(str(boost::format("tile:%d-%d-%d")
+                    % job.level % ti(0) % ti(1)));
+
+    LOG(info2)
+        << std::fixed
+        << "Processing tile " << job.level
+        << '-' << ti(0) << '-' << ti(1) << " (size: " << pxSize
+        << ", extents: " << te << ").";
+
+    // base dataset provides format for temporary datasets
+    auto base(geo::GeoDataset::open(config_.outputDataset));
+
+    // use full dataset and distable safe-chunking
+    geo::GeoDataset::WarpOptions warpOptions;
+    warpOptions.overview = geo::GeoDataset::Overview();
+    warpOptions.safeChunks = false;
+
+    auto tmp(createTmpDataset(base, te, pxSize, setup_.maskType));
+    if (!job.level) {
+        base.warpInto(tmp, config_.resampling, warpOptions);
+    } else {
+        assemble(job.level, tile, base)
+            .warpInto(tmp, config_.resampling, warpOptions);
+    }
+
+    const auto valid(storeTile(config_, base, tmp, *level.ovr, level.dir, ti
+                               , layout.tileRect(ti), level.createOptions
+                               , setup_.maskType));
+
+    logTile(timer, ++progress_, total_, job.level, ti, pxSize, te, valid);
+
+    // keep data for next level
+    if (valid && tile.consumers) {
+        tile.pieces.emplace_back(layout.tileRect(ti), readAll(tmp));
+        tile.full = true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    finish(job);
+    cond_.notify_all();
+}
+
+void OverviewPipeline::finish(const Job &job)
+{
+    auto &level(levels_[job.level]);
+    auto &tile(*level.tiles[job.index]);
+
+    tile.done = true;
+    --running_;
+    --remaining_;
+    if (tile.full) { ++resident_; }
+
+    if (job.level) {
+        // release previous level's tiles nobody needs anymore and trim those
+        // owned by this tile
+        auto &prev(levels_[job.level - 1]);
+        for (auto dep : tile.deps) {
+            auto &d(*prev.tiles[dep]);
+            if (!--d.consumers) {
+                std::unique_lock<std::mutex> lock(d.mutex);
+                d.pieces.clear();
+                if (d.full) { --resident_; }
+                d.full = false;
+            } else if (d.owner == job.index) {
+                trim(job.level - 1, dep);
+            }
+        }
+    } else {
+        --runningLevel0_;
+    }
+
+    if (job.level + 1 == int(levels_.size())) { return; }
+
+    // wake up next level's tiles
+    auto &next(levels_[job.level + 1]);
+    for (auto dependent : tile.dependents) {
+        auto &d(*next.tiles[dependent]);
+        if (!--d.missing) {
+            ready_.push(makeJob(job.level + 1, dependent));
+            continue;
+        }
+
+        // first finished dependency of level 1 tile: ask for the rest
+        if (!job.level && (d.missing + 1 == int(d.deps.size()))) {
+            for (auto dep : d.deps) {
+                if (!level.tiles[dep]->started) {
+                    wanted_.push(makeJob(0, dep));
                 }
+            }
+        }
+    }
+}
 
-            auto id(++progress);
-            LOG(info3)
-                << std::fixed
-                << "Processed tile #" << id << '/' << total << ' ' << ovrIndex
-                << '-' << tile(0) << '-' << tile(1) << " (size: " << pxSize
-                << ", extents: " << te << ") [valid]"
-                << "; duration: "
-                << utility::formatDuration(timer.duration()) << ".";
+void OverviewPipeline::trim(int li, int index)
+{
+    auto &level(levels_[li]);
+    auto &tile(*level.tiles[index]);
+    if (!tile.full) { return; }
+
+    const auto &full(tile.pieces.front());
+    const auto &next(levels_[li + 1]);
+
+    Piece::list pieces;
+    for (auto dependent : tile.dependents) {
+        const auto &d(*next.tiles[dependent]);
+        if (d.done) { continue; }
+
+        const auto r(intersect(d.region, full.rect));
+        if (!r.size.width) { continue; }
+
+        pieces.emplace_back
+            (r, full.data(cv::Rect(r.origin(0) - full.rect.origin(0)
+                                   , r.origin(1) - full.rect.origin(1)
+                                   , r.size.width, r.size.height))
+             .clone());
+    }
+
+    std::unique_lock<std::mutex> lock(tile.mutex);
+    tile.pieces.swap(pieces);
+    tile.full = false;
+    --resident_;
+}
+
+geo::GeoDataset OverviewPipeline::assemble(int li, const Tile &tile
+                                           , const geo::GeoDataset &base)
+{
+    auto &prev(levels_[li - 1]);
+    const auto &layout(prev.layout);
+    const auto &region(tile.region);
+
+    const math::Extents2 re
+        (layout.origin(0) + region.origin(0) * layout.pixelSize.width
+         , layout.origin(1) - ((region.origin(1) + region.size.height)
+                               * layout.pixelSize.height)
+         , layout.origin(0) + ((region.origin(0) + region.size.width)
+                               * layout.pixelSize.width)
+         , layout.origin(1) - region.origin(1) * layout.pixelSize.height);
+
+    auto ds(createTmpDataset(base, re, region.size, setup_.maskType));
+
+    // grab pieces of source tiles; matrices are shared so the pieces stay
+    // valid even if the tile is trimmed meanwhile
+    Piece::list pieces;
+    for (auto dep : tile.deps) {
+        auto &d(*prev.tiles[dep]);
+        std::unique_lock<std::mutex> lock(d.mutex);
+        for (const auto &piece : d.pieces) {
+            const auto r(intersect(piece.rect, region));
+            if (!r.size.width) { continue; }
+            pieces.emplace_back
+                (r, piece.data(cv::Rect(r.origin(0) - piece.rect.origin(0)
+                                        , r.origin(1) - piece.rect.origin(1)
+                                        , r.size.width, r.size.height)));
         }
+    }
 
-    ovr.flush();
+    // value of pixels not covered by any stored tile: background if used
+    // (the same as provided by overview VRT) or nodata
+    const int bands(ds.bandCount());
+    cv::Mat fillValue(1, bands, CV_64F, cv::Scalar(0.0));
+    if (config_.background) {
+        auto background(*config_.background);
+        background.resize(bands);
+        for (int b(0); b != bands; ++b) {
+            fillValue.at<double>(b) = background[b];
+        }
+    } else if (const auto nodata = ds.rawNodataValue()) {
+        fillValue = cv::Scalar(*nodata);
+    }
 
-    return ovrName;
+    // data type of temporary datasets
+    const auto type(pieces.empty()
+                    ? ds.readBlock(math::Point2i(0, 0), true).data.type()
+                    : pieces.front().data.type());
+
+    cv::Mat value;
+    fillValue.convertTo(value, CV_MAT_DEPTH(type));
+
+    cv::Mat data;
+    cv::repeat(value.reshape(CV_MAT_CN(type), 1)
+               , region.size.height, region.size.width, data);
+
+    for (const auto &piece : pieces) {
+        piece.data.copyTo
+            (data(cv::Rect(piece.rect.origin(0) - region.origin(0)
+                           , piece.rect.origin(1) - region.origin(1)
+                           , piece.rect.size.width
+                           , piece.rect.size.height)));
+    }
+
+    // MEM datasets are organized in full-width single-row blocks
+    for (int j(0); j != region.size.height; ++j) {
+        ds.writeBlock(math::Point2i(0, j), data.row(j));
+    }
+
+    return ds;
+}
+
+/** Parameters that determine layout and content of generated output. They
+ *  are stored in the output and update is allowed only with the same
+ *  parameters.
+ */
+std::string generationParams(const Config &config)
+{
+    std::ostringstream os;
+    os.precision(17);
+    os << "input = " << config.input.string()
+       << "\ntileSize = " << config.tileSize
+       << "\nresampling = " << config.resampling
+       << "\nminOvrSize = " << config.minOvrSize
+       << "\nwrapx = ";
+    if (config.wrapx) { os << *config.wrapx; } else { os << "none"; }
+    os << "\nbackground = " << config.background
+       << "\nnodata = ";
+    if (!config.nodata) {
+        os << "input";
+    } else if (*config.nodata) {
+        os << **config.nodata;
+    } else {
+        os << "none";
+    }
+    os << '\n';
+    return os.str();
+}
+
+fs::path generationParamsPath(const Config &config)
+{
+    return config.output / "generatevrtwo.params";
+}
+
+/** Stores generation parameters in the output. Called after successful
+ *  generation only so incomplete output is never updated.
+ */
+void saveGenerationParams(const Config &config)
+{
+    const auto path(generationParamsPath(config));
+    const auto tmpPath(utility::addExtension(path, ".tmp"));
+    {
+        std::ofstream f;
+        f.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+        f.open(tmpPath.string(), std::ios_base::out | std::ios_base::trunc);
+        f << generationParams(config);
+        f.close();
+    }
+    fs::rename(tmpPath, path);
+}
+
+/** Checks that output was generated with the same parameters.
+ */
+void checkGenerationParams(const Config &config)
+{
+    const auto path(generationParamsPath(config));
+    if (!fs::exists(path)) {
+        LOGTHROW(err2, std::runtime_error)
+            << "No generation parameters found in " << config.output
+            << " (output was not generated completely or by an older "
+            "version); full regeneration needed.";
+    }
+
+    std::ifstream f;
+    f.exceptions(std::ios_base::badbit);
+    f.open(path.string());
+    std::ostringstream stored;
+    stored << f.rdbuf();
+
+    const auto current(generationParams(config));
+    if (stored.str() != current) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Output in " << config.output << " was generated with "
+            "different parameters:\n" << stored.str()
+            << "current parameters:\n" << current
+            << "full regeneration needed.";
+    }
+}
+
+/** New sources of regenerated tiles, indexed by tile file name. Empty list
+ *  for tiles that became empty.
+ */
+typedef std::map<fs::path, BandDescriptor::list> TileSources;
+
+/** Replaces sources of regenerated tiles in given VRT band.
+ */
+void replaceSources(::CPLXMLNode *band, const TileSources &sources
+                    , int index, bool mask)
+{
+    // drop all sources of regenerated tiles
+    for (auto child(band->psChild); child; ) {
+        auto next(child->psNext);
+        if ((child->eType == ::CXT_Element)
+            && ba::ends_with(child->pszValue, "Source")
+            && sources.count(::CPLGetXMLValue(child, "SourceFilename", "")))
+        {
+            ::CPLRemoveXMLChild(band, child);
+            ::CPLDestroyXMLNode(child);
+        }
+        child = next;
+    }
+
+    // add sources of non-empty tiles
+    for (const auto &item : sources) {
+        if (item.second.empty()) { continue; }
+
+        std::ostringstream os;
+        item.second[index].serialize(os, mask);
+        ::CPLAddXMLChild(band, ::CPLCloneXMLTree
+                         (xmlNodeFromString(os.str()).get()));
+    }
+}
+
+/** Updates sources of regenerated tiles (manually by manipulating the XML),
+ *  all other sources are left intact.
+ */
+void updateOverviewSources(const fs::path &vrtPath
+                           , const TileSources &sources)
+{
+    auto root(xmlNode(vrtPath));
+
+    for (NodeIterator ni(root.get(), "VRTRasterBand"); ni; ++ni) {
+        NodeIterator bandNode(*ni, "band");
+        if (!bandNode) {
+            LOG(warn3) << "Cannot find band attribute in VRTRasterBand.";
+            continue;
+        }
+
+        // get band number
+        const auto band(std::atoi(bandNode->psChild->pszValue) - 1);
+        replaceSources(*ni, sources, band, false);
+    }
+
+    // per-dataset mask (only first band is mapped there)
+    for (NodeIterator mi(root.get(), "MaskBand"); mi; ++mi) {
+        for (NodeIterator ni(*mi, "VRTRasterBand"); ni; ++ni) {
+            replaceSources(*ni, sources, 0, true);
+        }
+    }
+
+    // replace VRT atomically
+    const auto tmpPath(utility::addExtension(vrtPath, ".tmp"));
+    auto res(::CPLSerializeXMLTreeToFile(root.get(), tmpPath.c_str()));
+    if (!res) {
+        LOGTHROW(err3, std::runtime_error)
+            << "Cannot save updated VRT file into " << tmpPath << ".";
+    }
+    fs::rename(tmpPath, vrtPath);
+}
+
+/** Converts extents between SRSs. Extents' border is sampled since corners
+ *  alone are not enough for curved edges.
+ */
+math::Extents2 convertExtents(const math::Extents2 &e
+                              , const geo::SrsDefinition &srcSrs
+                              , const geo::SrsDefinition &dstSrs)
+{
+    const geo::CsConvertor conv(srcSrs, dstSrs);
+
+    const int samples(16);
+    const auto es(math::size(e));
+    math::Extents2 extents(math::InvalidExtents{});
+    for (int i(0); i <= samples; ++i) {
+        const auto x(e.ll(0) + (i * es.width) / samples);
+        const auto y(e.ll(1) + (i * es.height) / samples);
+        math::update(extents, conv(math::Point2(x, e.ll(1))));
+        math::update(extents, conv(math::Point2(x, e.ur(1))));
+        math::update(extents, conv(math::Point2(e.ll(0), y)));
+        math::update(extents, conv(math::Point2(e.ur(0), y)));
+    }
+    return extents;
+}
+
+/** Collects changed regions in input dataset's SRS.
+ */
+std::vector<math::Extents2> changedRegions(const Config &config
+                                           , const geo::GeoDataset &in)
+{
+    auto changed(config.changed);
+
+    for (const auto &file : config.changedFiles) {
+        if (!fs::exists(file)) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Changed file " << file << " does not exist; use "
+                "--changed to specify region of removed file.";
+        }
+
+        const auto ds(geo::GeoDataset::open(file));
+        changed.push_back(convertExtents(ds.extents(), ds.srs(), in.srs()));
+    }
+
+    if (!config.wrapx) { return changed; }
+
+    // wrapped dataset: changes near one edge are mirrored in the strip added
+    // to the other side
+    const auto pw(math::size(in.extents()).width / in.size().width);
+    const auto offset((in.size().width - *config.wrapx) * pw);
+
+    const auto count(changed.size());
+    for (std::size_t i(0); i != count; ++i) {
+        for (auto shift : { -offset, offset }) {
+            auto e(changed[i]);
+            e.ll(0) += shift;
+            e.ur(0) += shift;
+            changed.push_back(e);
+        }
+    }
+
+    return changed;
+}
+
+bool overlaps(const math::Extents2 &a, const math::Extents2 &b)
+{
+    return ((a.ll(0) < b.ur(0)) && (b.ll(0) < a.ur(0))
+            && (a.ll(1) < b.ur(1)) && (b.ll(1) < a.ur(1)));
+}
+
+/** Incremental overview update.
+ *
+ *  Only tiles touching changed regions are regenerated at each level; changed
+ *  region grows by resampling margin (in source pixels) on the way up. Sources
+ *  of regenerated tiles are replaced in overview VRT XML, all other tiles and
+ *  sources are left untouched.
+ *
+ *  Output must have been generated from the same input with the same
+ *  parameters (stored in the output) and input dataset must keep its size
+ *  and extents, otherwise full regeneration is needed.
+ */
+void updateOverviews(const Config &config)
+{
+    const fs::path inputDatasetSymlink(config.output / "original");
+    if (!fs::exists(config.outputDataset)
+        || !fs::exists(inputDatasetSymlink))
+    {
+        LOGTHROW(err2, std::runtime_error)
+            << "There is no generated dataset in " << config.output
+            << " to update.";
+    }
+
+    // output must have been generated from this input...
+    if (fs::read_symlink(inputDatasetSymlink) != config.input) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Output in " << config.output << " was generated from "
+            << fs::read_symlink(inputDatasetSymlink) << " not from "
+            << config.input << "; full regeneration needed.";
+    }
+
+    // ... with the same parameters
+    checkGenerationParams(config);
+
+    const auto in(geo::GeoDataset::open(inputDatasetSymlink));
+    const auto setup(makeSetup(in.descriptor(), config));
+
+    // input must keep its georeferencing
+    {
+        const auto out(geo::GeoDataset::open(config.outputDataset));
+        const auto es(math::size(setup.extents));
+        const auto tolerance(1e-3 * es.width / setup.size.width);
+        const auto &e(out.extents());
+        if ((out.size() != setup.size)
+            || (std::abs(e.ll(0) - setup.extents.ll(0)) > tolerance)
+            || (std::abs(e.ll(1) - setup.extents.ll(1)) > tolerance)
+            || (std::abs(e.ur(0) - setup.extents.ur(0)) > tolerance)
+            || (std::abs(e.ur(1) - setup.extents.ur(1)) > tolerance))
+        {
+            LOGTHROW(err2, std::runtime_error)
+                << "Input dataset size or extents have changed; full "
+                "regeneration needed.";
+        }
+    }
+
+    struct Level {
+        fs::path dir;
+        fs::path ovrName;
+        LevelLayout layout;
+        std::vector<int> tiles;
+
+        Level(const fs::path &dir, const LevelLayout &layout)
+            : dir(dir), ovrName(dir / "ovr.vrt"), layout(layout)
+        {}
+    };
+
+    // plan tiles to regenerate at each level
+    std::vector<Level> levels;
+    auto dirty(changedRegions(config, in));
+    auto srcPixelSize([&]() -> math::Size2f
+    {
+        auto es(math::size(setup.extents));
+        return math::Size2f(es.width / setup.size.width
+                            , es.height / setup.size.height);
+    }());
+
+    int total(0);
+    for (std::size_t i(0); i != setup.ovrSizes.size(); ++i) {
+        auto dir(str(boost::format("%d") % i));
+        const auto ovrPath(config.output / dir / "ovr.vrt");
+        if (!fs::exists(ovrPath)) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Overview " << ovrPath << " does not exist; full "
+                "regeneration needed.";
+        }
+
+        const auto ovr(geo::GeoDataset::open(ovrPath));
+        if (ovr.size() != setup.ovrSizes[i]) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Overview " << ovrPath << " has different size than "
+                "expected; full regeneration needed.";
+        }
+
+        levels.emplace_back(dir, LevelLayout(ovr.extents(), setup.ovrSizes[i]
+                                             , setup.ovrTiled[i]
+                                             , config.tileSize));
+        auto &level(levels.back());
+
+        // grow changed regions by the resampling kernel
+        for (auto &e : dirty) {
+            e.ll(0) -= ResamplingMargin * srcPixelSize.width;
+            e.ll(1) -= ResamplingMargin * srcPixelSize.height;
+            e.ur(0) += ResamplingMargin * srcPixelSize.width;
+            e.ur(1) += ResamplingMargin * srcPixelSize.height;
+        }
+
+        for (int t(0), et(math::area(level.layout.tiled)); t != et; ++t) {
+            const auto te(level.layout.tileExtents(level.layout.tile(t)));
+            for (const auto &e : dirty) {
+                if (overlaps(te, e)) {
+                    level.tiles.push_back(t);
+                    break;
+                }
+            }
+        }
+
+        total += level.tiles.size();
+        srcPixelSize = level.layout.pixelSize;
+    }
+
+    LOG(info3) << "About to regenerate " << total << " tiles in "
+               << levels.size() << " overviews.";
+
+    std::atomic<int> progress(0);
+
+    // use full dataset and distable safe-chunking
+    geo::GeoDataset::WarpOptions warpOptions;
+    warpOptions.overview = geo::GeoDataset::Overview();
+    warpOptions.safeChunks = false;
+
+    fs::path srcPath(config.outputDataset);
+    for (std::size_t i(0); i != levels.size(); ++i) {
+        const auto &level(levels[i]);
+        const auto &layout(level.layout);
+        const auto ovrPath(config.output / level.ovrName);
+
+        LOG(info3)
+            << "Updating " << level.tiles.size() << " of "
+            << math::area(layout.tiled) << " tiles in overview #" << i
+            << " in " << ovrPath << " from " << srcPath << ".";
+
+        // copy options so that the PREDICTOR can be possibly modified
+        geo::Options createOptions(config.createOptions);
+        adjustPredictor(createOptions, geo::GeoDataset::open(srcPath));
+
+        TileSources sources;
+        const int tc(level.tiles.size());
+
+        UTILITY_OMP(parallel for schedule(dynamic))
+            for (int t = 0; t < tc; ++t) {
+                utility::DurationMeter timer;
+                const auto tile(layout.tile(level.tiles[t]));
+                const auto pxSize(layout.pxSize(tile));
+                const auto te(layout.tileExtents(tile));
+
+                TIDGuard tg(str(boost::format("tile:%d-%d-%d")
+                                % i % tile(0) % tile(1)));
+
+                auto src(geo::GeoDataset::open(srcPath));
+                auto tmp(createTmpDataset(src, te, pxSize, setup.maskType));
+                src.warpInto(tmp, config.resampling, warpOptions);
+
+                const auto name(tileName(tile));
+                const auto valid(writeTile(config, src, tmp
+                                           , config.output / level.dir / name
+                                           , createOptions, setup.maskType));
+
+                BandDescriptor::list bands;
+                if (valid) {
+                    for (std::size_t b(0), eb(tmp.bandCount()); b != eb; ++b)
+                    {
+                        bands.emplace_back(name, tmp, b, boost::none
+                                           , layout.tileRect(tile));
+                    }
+                }
+
+                UTILITY_OMP(critical(updateOverviews_sources))
+                    sources.emplace(name, std::move(bands));
+
+                logTile(timer, ++progress, total, i, tile, pxSize, te
+                        , valid);
+            }
+
+        // must be done before the next level reads this one
+        updateOverviewSources(ovrPath, sources);
+
+        // tiles that became empty are not referenced anymore
+        for (const auto &item : sources) {
+            if (item.second.empty()) {
+                fs::remove(config.output / level.dir / item.first);
+            }
+        }
+
+        // use this level in the next round
+        srcPath = ovrPath;
+    }
 }
 
 int VrtWo::run()
 {
+    if (config_.update) {
+        updateOverviews(config_);
+
+        LOG(info4) << "VRT overviews in " << config_.output
+                   << " successfully updated.";
+        return EXIT_SUCCESS;
+    }
+
     if (!fs::create_directories(config_.output) && !config_.overwrite) {
         LOG(fatal) << "Destination directory already exits. Use --overwrite "
             "to force existing output overwrite.";
         return EXIT_FAILURE;
     }
 
+    // output is updatable only when completely generated
+    fs::remove(generationParamsPath(config_));
+
     auto setup(buildDatasetBase(config_));
 
     auto total(std::accumulate(setup.ovrTiled.begin(), setup.ovrTiled.end()
@@ -1250,6 +2500,23 @@ int VrtWo::run()
 
     std::atomic<int> progress(0);
 
+    if (config_.pipelined) {
+        // generate all overviews at once
+        const auto paths(OverviewPipeline(config_, setup, progress, total)
+                         .run());
+
+        // add overviews (manually by manipulating the XML)
+        for (const auto &path : paths) {
+            addOverview(config_.outputDataset, path);
+        }
+
+        saveGenerationParams(config_);
+
+        LOG(info4) << "VRT with overviews in " << config_.output
+                   << " successfully generated.";
+        return EXIT_SUCCESS;
+    }
+
     // generate overviews
     fs::path inputPath(config_.outputDataset);
     for (std::size_t i(0); i != setup.ovrSizes.size(); ++i) {
@@ -1268,6 +2535,8 @@ int VrtWo::run()
         inputPath = config_.output / path;
     }
 
+    saveGenerationParams(config_);
+
     LOG(info4) << "VRT with overviews in " << config_.output
                << " successfully generated.";
     return EXIT_SUCCESS;
@@ -25,9 +25,14 @@
  */
 
 #include <thread>
+#include <vector>
 
 #include <boost/format.hpp>
 #include <boost/asio.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/classification.hpp>
 
 #include "utility/raise.hpp"
 
@@ -42,16 +47,19 @@
 #include "./sink.hpp"
 
 namespace asio = boost::asio;
+namespace ba = boost::algorithm;
 namespace vts = vtslibs::vts;
 namespace vr = vtslibs::registry;
 
 class Core::Detail : boost::noncopyable {
 public:
     Detail(Generators &generators, GdalWarper &warper
-           , unsigned int threadCount, http::ContentFetcher &contentFetcher)
+           , unsigned int threadCount, http::ContentFetcher &contentFetcher
+           , const UpstreamFetcher::Options &upstreamOptions)
         : resourceFetcher_(contentFetcher, &ios_)
+        , upstream_(resourceFetcher_, upstreamOptions)
         , generators_(generators)
-        , arsenal_(warper, resourceFetcher_)
+        , arsenal_(warper, resourceFetcher_, upstream_)
         , work_(ios_)
     {
         generators_.start(arsenal_);
@@ -85,6 +93,7 @@ private:
 
     asio::io_service ios_;
     http::ResourceFetcher resourceFetcher_;
+    UpstreamFetcher upstream_;
 
     Generators &generators_;
     Arsenal arsenal_;
@@ -156,9 +165,11 @@ void Core::Detail::post(const Generator::Task &task, Sink sink)
 }
 
 Core::Core(Generators &generators, GdalWarper &warper
-           , unsigned int threadCount, http::ContentFetcher &contentFetcher)
+           , unsigned int threadCount, http::ContentFetcher &contentFetcher
+           , const UpstreamFetcher::Options &upstreamOptions)
     : detail_(std::make_shared<Detail>
-              (generators, warper, threadCount, contentFetcher))
+              (generators, warper, threadCount, contentFetcher
+               , upstreamOptions))
 {}
 
 void Core::generate_impl(const http::Request &request
@@ -220,12 +231,34 @@ buildListing(const Container &container
     return buildListing<true, Container>(container, bootstrap);
 }
 
+/** Checks whether If-None-Match header value matches given entity tag. Weak
+ *  comparison is used as mandated by RFC 7232.
+ */
+bool etagMatches(const std::string &ifNoneMatch, const std::string &etag)
+{
+    if (ifNoneMatch.empty()) { return false; }
+
+    auto bare(etag);
+    if (ba::starts_with(bare, "W/")) { bare.erase(0, 2); }
+
+    std::vector<std::string> tags;
+    ba::split(tags, ifNoneMatch, ba::is_any_of(","));
+    for (auto &tag : tags) {
+        ba::trim(tag);
+        if (tag == "*") { return true; }
+        if (ba::starts_with(tag, "W/")) { tag.erase(0, 2); }
+        if (tag == bare) { return true; }
+    }
+    return false;
+}
+
 } // namespace
 
 void Core::Detail::generate(const http::Request &request, Sink sink)
 {
     try {
         FileInfo fi(request, generators_.config().fileFlags);
+        sink.assignAcceptEncoding(fi.acceptEncoding);
 
         switch (fi.type) {
         case FileInfo::Type::resourceFile:
@@ -269,6 +302,17 @@ void Core::Detail::generateResourceFile(const FileInfo &fi, Sink &sink)
     // assign file class stuff
     sink.assignFileClassSettings(generator->resource().fileClassSettings);
 
+    // conditional GET: content is fully determined by entity tag, no need
+    // to generate anything; only tiles are tagged
+    const auto etag(generator->etag(fi, generators_.servingTag()));
+    if (!etag.empty()) {
+        sink.assignETag(etag);
+        if (generator->ready() && etagMatches(fi.ifNoneMatch, etag)) {
+            sink.notModified(FileClass::data);
+            return;
+        }
+    }
+
     // run machinery
     post(generator->generateFile(fi, sink), sink);
 }
@@ -36,7 +36,8 @@ class Core : boost::noncopyable
 {
 public:
     Core(Generators &generators, GdalWarper &warper
-         , unsigned int threadCount, http::ContentFetcher &contentFetcher);
+         , unsigned int threadCount, http::ContentFetcher &contentFetcher
+         , const UpstreamFetcher::Options &upstreamOptions);
 
     struct Detail;
 
@@ -83,5 +83,6 @@ typedef http::ServiceUnavailable Unavailable;
 typedef http::InternalServerError InternalError;
 typedef http::RequestAborted RequestAborted;
 typedef http::BadRequest BadRequest;
+typedef http::NotModified NotModified;
 
 #endif // mapproxy_error_hpp_included_
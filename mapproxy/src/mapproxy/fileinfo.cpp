@@ -27,6 +27,9 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/range/iterator.hpp>
 
 #include "utility/streams.hpp"
@@ -62,6 +65,8 @@ namespace constants {
     } // namespace tileset
 
     const std::string DisableBrowserHeader("X-Mapproxy-Disable-Browser");
+    const std::string IfNoneMatchHeader("If-None-Match");
+    const std::string AcceptEncodingHeader("Accept-Encoding");
 } // namesapce constants
 
 namespace {
@@ -97,6 +102,51 @@ const std::string& checkReferenceFrame(const std::string &referenceFrame)
     throw;
 }
 
+/** Parses Accept-Encoding header value. Codings with zero quality are
+ *  refused, wildcard accepts anything not mentioned explicitly.
+ */
+ContentEncodings parseAcceptEncoding(const std::string &value)
+{
+    ContentEncodings accepted, mentioned;
+    accepted.set(static_cast<int>(ContentEncoding::identity));
+    bool wildcard(false);
+
+    std::vector<std::string> codings;
+    ba::split(codings, value, ba::is_any_of(","));
+    for (const auto &item : codings) {
+        std::vector<std::string> params;
+        ba::split(params, item, ba::is_any_of(";"));
+
+        auto name(ba::to_lower_copy(ba::trim_copy(params.front())));
+        if (name.empty()) { continue; }
+        if (name == "x-gzip") { name = "gzip"; }
+
+        double q(1.0);
+        for (auto iparams(params.begin() + 1); iparams != params.end();
+             ++iparams)
+        {
+            const auto param(ba::trim_copy(*iparams));
+            if (!ba::istarts_with(param, "q=")) { continue; }
+            try {
+                q = boost::lexical_cast<double>(param.substr(2));
+            } catch (const boost::bad_lexical_cast&) {}
+        }
+
+        if (name == "*") {
+            wildcard = (q > 0.0);
+            continue;
+        }
+
+        ContentEncoding ce;
+        if (!asEnum(name, ce)) { continue; }
+        mentioned.set(static_cast<int>(ce));
+        accepted.set(static_cast<int>(ce), (q > 0.0));
+    }
+
+    if (wildcard) { accepted |= ~mentioned; }
+    return accepted;
+}
+
 } // namespace
 
 FileInfo::FileInfo(const http::Request &request, int f)
@@ -110,6 +160,20 @@ FileInfo::FileInfo(const http::Request &request, int f)
         }
     }
 
+    if (const auto *ifNoneMatch = request.getHeader
+        (constants::IfNoneMatchHeader))
+    {
+        this->ifNoneMatch = *ifNoneMatch;
+    }
+
+    if (const auto *acceptEncoding = request.getHeader
+        (constants::AcceptEncodingHeader))
+    {
+        this->acceptEncoding = parseAcceptEncoding(*acceptEncoding);
+    } else {
+        this->acceptEncoding.set(static_cast<int>(ContentEncoding::identity));
+    }
+
     auto end(path.end());
 
     std::vector<std::string> components;
@@ -65,6 +65,15 @@ struct FileInfo {
      */
     int flags;
 
+    /** Value of If-None-Match header, empty if not present.
+     */
+    std::string ifNoneMatch;
+
+    /** Content encodings acceptable by client (from Accept-Encoding header).
+     *  Identity only if header is not present.
+     */
+    ContentEncodings acceptEncoding;
+
     enum class Type {
         dirRedir
         , referenceFrameListing, typeListing, groupListing, idListing
@@ -108,6 +108,11 @@ public:
          *       inflated by half pixel in each direction and raster size is
          *       incremented by one.
          *
+         * * demOptimalPow2:
+         *       same as demOptimal but computed size is rounded up to power
+         *       of two (as needed by RTIN mesher); provided size must be
+         *       power of two as well
+         *
          * * valueMinMax:
          *       warps dataset using given filter, dataset.min by minimum filter
          *       and dataset.max by maximum filter
@@ -117,7 +122,7 @@ public:
          */
         enum class Operation {
             image, imageNoOpt, mask, maskNoOpt, detailMask, dem
-            , demOptimal, valueMinMax
+            , demOptimal, demOptimalPow2, valueMinMax
         };
 
         Operation operation;
@@ -164,6 +169,14 @@ public:
     typedef std::vector<std::string> OpenOptions;
 
     /** Heightcode vector ds using raster ds
+     *
+     *  If localDemExtents (in config.workingSrs) are provided, raster datasets
+     *  are first warped into single in-memory DEM covering these extents and
+     *  vertices are sampled from it; original datasets are used only for
+     *  vertices outside of it.
+     *
+     *  If cacheVector is set, opened vector dataset is kept in worker's cache
+     *  for subsequent requests (useful for tiled sources only).
      */
     Heightcoded::pointer
     heightcode(const std::string &vectorDs
@@ -172,7 +185,10 @@ public:
                , const boost::optional<std::string> &vectorGeoidGrid
                , const OpenOptions &openOptions
                , const LayerEnhancer::map &layerEnancers
-               , Aborter &aborter);
+               , Aborter &aborter
+               , const boost::optional<math::Extents2> &localDemExtents
+               = boost::none
+               , bool cacheVector = false);
 
     /** Do housekeeping. Must be called in the process where internals are being
      * run.
@@ -24,9 +24,35 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+
+#include <ogrsf_frmts.h>
+#include <cpl_vsi.h>
+
 #include "../error.hpp"
 #include "./datasetcache.hpp"
 
+namespace {
+
+/** Number of opened vector datasets kept in the cache.
+ */
+const std::size_t VectorCacheSize(16);
+
+/** Stats file via GDAL's VSI layer, works for /vsi* paths as well.
+ */
+std::pair<long, long> fileStamp(const std::string &path)
+{
+    VSIStatBufL buf;
+    if (::VSIStatExL(path.c_str(), &buf, VSI_STAT_EXISTS_FLAG
+                     | VSI_STAT_SIZE_FLAG))
+    {
+        return { -1, -1 };
+    }
+    return { long(buf.st_mtime), long(buf.st_size) };
+}
+
+} // namespace
+
 geo::GeoDataset& DatasetCache::operator()(const std::string &path)
 {
     ++hits_;
@@ -38,6 +64,45 @@ geo::GeoDataset& DatasetCache::operator()(const std::string &path)
                             (path, geo::GeoDataset::open(path))).first->second;
 }
 
+VectorDataset DatasetCache::vector(const std::string &path
+                                   , const OpenOptions &openOptions
+                                   , const VectorOpener &opener)
+{
+    const VectorKey key(path, openOptions);
+    const auto stamp(fileStamp(path));
+
+    auto ivectorDatasets(std::find_if(vectorDatasets_.begin()
+                                      , vectorDatasets_.end()
+                                      , [&](const VectorCache::value_type &v)
+    {
+        return v.key == key;
+    }));
+
+    if (ivectorDatasets != vectorDatasets_.end()) {
+        if (ivectorDatasets->stamp == stamp) {
+            // hit: move to front and rewind all layers
+            vectorDatasets_.splice(vectorDatasets_.begin(), vectorDatasets_
+                                   , ivectorDatasets);
+            auto &ds(vectorDatasets_.front().ds);
+            for (int i(0), e(ds->GetLayerCount()); i < e; ++i) {
+                ds->GetLayer(i)->ResetReading();
+            }
+            return ds;
+        }
+
+        // file has changed, drop stale entry
+        vectorDatasets_.erase(ivectorDatasets);
+    }
+
+    // miss: open (may throw) and remember
+    auto ds(opener());
+    vectorDatasets_.emplace_front(key, stamp, ds);
+    if (vectorDatasets_.size() > VectorCacheSize) {
+        vectorDatasets_.pop_back();
+    }
+    return ds;
+}
+
 bool DatasetCache::worn()
 {
     return false;
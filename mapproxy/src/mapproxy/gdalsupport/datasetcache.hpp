@@ -28,15 +28,41 @@
 #define mapproxy_datasetcache_hpp_included_
 
 #include <map>
+#include <list>
+#include <vector>
+#include <memory>
+#include <functional>
 
 #include "geo/geodataset.hpp"
 
+class GDALDataset;
+
+typedef std::shared_ptr< ::GDALDataset> VectorDataset;
+
 class DatasetCache {
 public:
+    typedef std::vector<std::string> OpenOptions;
+    typedef std::function<VectorDataset()> VectorOpener;
+
     DatasetCache() : hits_() {}
 
     geo::GeoDataset& operator()(const std::string &path);
 
+    /** Returns opened (i.e. parsed) vector dataset identified by path and
+     *  open options. Dataset is opened by provided opener on cache miss. All
+     *  layers of returned dataset are rewound.
+     *
+     *  Only a few most recently used vector datasets are kept; this is
+     *  targeted at tiled sources where one source tile is used by all its
+     *  descendants.
+     *
+     *  Cached dataset is reused only if file's modification time and size
+     *  are unchanged since it has been opened.
+     */
+    VectorDataset vector(const std::string &path
+                         , const OpenOptions &openOptions
+                         , const VectorOpener &opener);
+
     bool worn();
 
 private:
@@ -44,6 +70,26 @@ private:
 
     Cache datasets_;
 
+    typedef std::pair<std::string, OpenOptions> VectorKey;
+
+    /** File modification time and size, (-1, -1) if not available.
+     */
+    typedef std::pair<long, long> FileStamp;
+
+    struct VectorEntry {
+        VectorKey key;
+        FileStamp stamp;
+        VectorDataset ds;
+
+        VectorEntry(const VectorKey &key, const FileStamp &stamp
+                    , const VectorDataset &ds)
+            : key(key), stamp(stamp), ds(ds) {}
+    };
+
+    typedef std::list<VectorEntry> VectorCache;
+
+    VectorCache vectorDatasets_;
+
     std::size_t hits_;
 };
 
@@ -98,13 +98,16 @@ public:
               , const boost::optional<std::string> &vectorGeoidGrid
               , const GdalWarper::OpenOptions &openOptions
               , const LayerEnhancer::map &layerEnhancers
+              , const boost::optional<math::Extents2> &localDemExtents
+              , bool cacheVector
               , ManagedBuffer &sm)
         : sm_(sm)
         , raster_()
         , heightcode_(sm.construct<ShHeightCode>
                       (bi::anonymous_instance)
                       (vectorDs, rasterDs, config, vectorGeoidGrid
-                       , openOptions, layerEnhancers, sm, this))
+                       , openOptions, layerEnhancers, localDemExtents
+                       , cacheVector, sm, this))
         , done_(false)
         , error_(sm.get_allocator<char>())
         , errorType_(ErrorType::none)
@@ -150,12 +153,16 @@ public:
                           , const boost::optional<std::string> &vectorGeoidGrid
                           , const std::vector<std::string> &openOptions
                           , const LayerEnhancer::map &layerEnhancers
+                          , const boost::optional<math::Extents2>
+                          &localDemExtents
+                          , bool cacheVector
                           , ManagedBuffer &mb)
     {
         return pointer(mb.construct<ShRequest>
                        (bi::anonymous_instance)
                        (vectorDs, rasterDs, config, vectorGeoidGrid
-                        , openOptions, layerEnhancers, mb)
+                        , openOptions, layerEnhancers, localDemExtents
+                        , cacheVector, mb)
                        , mb.get_allocator<void>()
                        , mb.get_deleter<ShRequest>());
     }
@@ -197,7 +204,9 @@ void ShRequest::process(bi::interprocess_mutex &mutex
                                  , heightcode_->config()
                                  , heightcode_->vectorGeoidGrid()
                                  , heightcode_->openOptions()
-                                 , heightcode_->layerEnhancers()));
+                                 , heightcode_->layerEnhancers()
+                                 , heightcode_->localDemExtents()
+                                 , heightcode_->cacheVector()));
         return;
     }
 
@@ -442,7 +451,9 @@ public:
                , const boost::optional<std::string> &vectorGeoidGrid
                , const GdalWarper::OpenOptions &openOptions
                , const LayerEnhancer::map &layerEnhancers
-               , Aborter &aborter);
+               , Aborter &aborter
+               , const boost::optional<math::Extents2> &localDemExtents
+               , bool cacheVector);
 
     void housekeeping();
 
@@ -495,10 +506,14 @@ GdalWarper::heightcode(const std::string &vectorDs
                        , const boost::optional<std::string> &vectorGeoidGrid
                        , const GdalWarper::OpenOptions &openOptions
                        , const LayerEnhancer::map &layerEnhancers
-                       , Aborter &aborter)
+                       , Aborter &aborter
+                       , const boost::optional<math::Extents2>
+                       &localDemExtents
+                       , bool cacheVector)
 {
     return detail().heightcode(vectorDs, rasterDs, config, vectorGeoidGrid
-                               , openOptions, layerEnhancers, aborter);
+                               , openOptions, layerEnhancers, aborter
+                               , localDemExtents, cacheVector);
 }
 
 void GdalWarper::housekeeping()
@@ -858,12 +873,15 @@ GdalWarper::Heightcoded::pointer GdalWarper::Detail
              , const boost::optional<std::string> &vectorGeoidGrid
              , const GdalWarper::OpenOptions &openOptions
              , const LayerEnhancer::map &layerEnhancers
-             , Aborter &aborter)
+             , Aborter &aborter
+             , const boost::optional<math::Extents2> &localDemExtents
+             , bool cacheVector)
 {
     Lock lock(mutex());
     ShRequest::pointer shReq
         (ShRequest::create(vectorDs, rasterDs, config, vectorGeoidGrid
-                           , openOptions, layerEnhancers, mb_));
+                           , openOptions, layerEnhancers, localDemExtents
+                           , cacheVector, mb_));
     queue_->push_back(shReq);
     cond().notify_one();
 
@@ -27,6 +27,7 @@
 #include <new>
 #include <algorithm>
 #include <cstring>
+#include <cmath>
 
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/iostreams/device/array.hpp>
@@ -45,6 +46,7 @@
 
 #include "../error.hpp"
 #include "../support/geo.hpp"
+#include "../support/heightgrid.hpp"
 #include "./operations.hpp"
 
 namespace bio = boost::iostreams;
@@ -200,46 +202,8 @@ cv::Mat* warpValueMinMax(DatasetCache &cache, ManagedBuffer &mb
 
     // combine data
     auto *tile(allocateMat(mb, size, CV_64FC3));
-    *tile = cv::Scalar(*ForcedNodata, *ForcedNodata, *ForcedNodata);
-
-    {
-        // TODO: use masks (get them as a byte matrices)
-        const auto &d(dst.cdata());
-        const auto &dmin(minDst.cdata());
-        const auto &dmax(maxDst.cdata());
-
-        auto id(d.begin<double>());
-        auto idmin(dmin.begin<double>());
-        auto idmax(dmax.begin<double>());
-
-        for (auto itile(tile->begin<cv::Vec3d>())
-                 , etile(tile->end<cv::Vec3d>());
-             itile != etile; ++itile, ++id, ++idmin, ++idmax)
-        {
-            // skip invalid value
-            auto value(*id);
-            if (value == ForcedNodata) { continue; }
-
-            auto &sample(*itile);
-            sample[0] = value;
-
-            if ((*idmin == ForcedNodata) || (*idmin > value)) {
-                // clone value into minimum if minimum is invalid or above value
-                sample[1] = value;
-            } else {
-                // copy min
-                sample[1] = *idmin;
-            }
-
-            if ((*idmax == ForcedNodata) || (*idmax < value)) {
-                // clone value into maximum if maximum is invalid or below value
-                sample[2] = value;
-            } else {
-                // copy max
-                sample[2] = *idmax;
-            }
-        }
-    }
+    combineValueMinMax(dst.cdata(), minDst.cdata(), maxDst.cdata()
+                       , *ForcedNodata, *tile);
 
     return tile;
 }
@@ -249,7 +213,7 @@ cv::Mat* warpDem(DatasetCache &cache, ManagedBuffer &mb
                  , const geo::SrsDefinition &srs
                  , const math::Extents2 &extents
                  , const math::Size2 &requestedSize
-                 , bool optimize)
+                 , bool optimize, bool pow2 = false)
 {
     auto &src(cache(dataset));
 
@@ -263,6 +227,12 @@ cv::Mat* warpDem(DatasetCache &cache, ManagedBuffer &mb
         // 2) use 12 samples per one souce pixel
         // 4) clip result to requesed size and 2
         int samples(std::round(12.0 * pxc / 4.0));
+        if (pow2) {
+            // 3b) round up to power of two
+            int p2(2);
+            while (p2 < samples) { p2 <<= 1; }
+            samples = p2;
+        }
         return math::Size2
             (std::max(std::min(samples, requestedSize.width), 2)
              , std::max(std::min(samples, requestedSize.height), 2));
@@ -315,9 +285,11 @@ cv::Mat* warp(DatasetCache &cache, ManagedBuffer &mb
 
     case Operation::dem:
     case Operation::demOptimal:
+    case Operation::demOptimalPow2:
         return warpDem
             (cache, mb, req.dataset, req.srs, req.extents, req.size
-             , (req.operation == Operation::demOptimal));
+             , (req.operation != Operation::dem)
+             , (req.operation == Operation::demOptimalPow2));
 
     case Operation::valueMinMax:
         return warpValueMinMax
@@ -329,8 +301,6 @@ cv::Mat* warp(DatasetCache &cache, ManagedBuffer &mb
 
 namespace {
 
-typedef std::shared_ptr< ::GDALDataset> VectorDataset;
-
 class OptionsWrapper {
 public:
     OptionsWrapper() : opts_() {}
@@ -561,6 +531,77 @@ heightcode(ManagedBuffer &mb, const VectorDataset &vds
     return allocateHc(mb, os.str(), metadata);
 }
 
+/** Warps raster dataset stack into one in-memory DEM covering given extents
+ *  (in working SRS).
+ *
+ *  DEM is created in SRS of the last (fallback) dataset so vertical handling
+ *  (geoid grid) in heightcoding stays the same. Datasets are combined in stack
+ *  order, i.e. first valid value wins. Raster resolution is derived from the
+ *  native resolution of the first dataset.
+ */
+geo::GeoDataset warpLocalDem(const std::vector<const geo::GeoDataset*> &rds
+                             , const geo::SrsDefinition &workingSrs
+                             , const math::Extents2 &workingExtents)
+{
+    const auto &fallback(*rds.back());
+    const auto srs(fallback.srs());
+
+    // working extents in DEM SRS, sample tile border
+    math::Extents2 extents(math::InvalidExtents{});
+    {
+        const int samples(16);
+        const geo::CsConvertor conv(workingSrs, srs);
+        const auto es(math::size(workingExtents));
+        const math::Size2f step(es.width / samples, es.height / samples);
+        for (int i(0); i <= samples; ++i) {
+            const auto x(workingExtents.ll(0) + i * step.width);
+            const auto y(workingExtents.ll(1) + i * step.height);
+            math::update(extents, conv(math::Point2(x, workingExtents.ll(1))));
+            math::update(extents, conv(math::Point2(x, workingExtents.ur(1))));
+            math::update(extents, conv(math::Point2(workingExtents.ll(0), y)));
+            math::update(extents, conv(math::Point2(workingExtents.ur(0), y)));
+        }
+
+        // add some margin for features slightly crossing the tile border
+        const auto des(math::size(extents));
+        const math::Point2 margin(des.width / 16.0, des.height / 16.0);
+        extents.ll -= margin;
+        extents.ur += margin;
+    }
+
+    // use native resolution of the first (most detailed) dataset
+    const auto size([&]() -> math::Size2
+    {
+        const auto pxc(tileCircumference(workingExtents, workingSrs
+                                         , *rds.front()));
+        const int samples(std::isfinite(pxc) ? std::round(pxc / 4.0) : 256);
+        const int side(std::max(std::min(samples, 1024), 2));
+        return math::Size2(side, side);
+    }());
+
+    auto dem(geo::GeoDataset::deriveInMemory
+             (fallback, srs, size, extents, ::GDT_Float32, ForcedNodata));
+
+    // warp from the fallback to the first dataset, overwrite valid values
+    for (auto irds(rds.rbegin()), erds(rds.rend()); irds != erds; ++irds) {
+        if (irds == rds.rbegin()) {
+            fallback.warpInto(dem, geo::GeoDataset::Resampling::dem);
+            continue;
+        }
+
+        auto tmp(geo::GeoDataset::deriveInMemory
+                 (**irds, srs, size, extents, ::GDT_Float32, ForcedNodata));
+        (*irds)->warpInto(tmp, geo::GeoDataset::Resampling::dem);
+
+        const auto &src(tmp.cdata());
+        const auto valid(heightValidity(src));
+        src.copyTo(dem.data(), valid);
+    }
+
+    dem.flush();
+    return dem;
+}
+
 } // namespace
 
 GdalWarper::Heightcoded*
@@ -570,15 +611,36 @@ heightcode(DatasetCache &cache, ManagedBuffer &mb
            , geo::heightcoding::Config config
            , const boost::optional<std::string> &vectorGeoidGrid
            , const GdalWarper::OpenOptions &openOptions
-           , const LayerEnhancer::map &layerEnancers)
+           , const LayerEnhancer::map &layerEnancers
+           , const boost::optional<math::Extents2> &localDemExtents
+           , bool cacheVector)
 {
     std::vector<const geo::GeoDataset*> rasterDsStack;
     for (const auto &ds : rasterDs) {
         rasterDsStack.push_back(&cache(ds.dataset));
     }
 
-    return heightcode(mb, openVectorDataset(vectorDs, config, openOptions)
-                      , rasterDsStack
+    // tile-local DEM: single warp instead of random reads from all datasets
+    // for each vertex; original stack is kept as a fallback for vertices
+    // outside local DEM
+    boost::optional<geo::GeoDataset> localDem;
+    if (localDemExtents && config.workingSrs) {
+        localDem = warpLocalDem(rasterDsStack, *config.workingSrs
+                                , *localDemExtents);
+        rasterDsStack.insert(rasterDsStack.begin(), &*localDem);
+    }
+
+    // vector dataset is cached only for tiled sources: they are cut into many
+    // descendant tiles from the same source tile; monolithic datasets can be
+    // huge and are heightcoded only once per revision
+    const auto opener([&]()
+    {
+        return openVectorDataset(vectorDs, config, openOptions);
+    });
+    const auto vds(cacheVector ? cache.vector(vectorDs, openOptions, opener)
+                   : opener());
+
+    return heightcode(mb, vds, rasterDsStack
                       , config, rasterDs.back().geoidGrid
                       , vectorGeoidGrid, layerEnancers);
 }
@@ -41,6 +41,8 @@ heightcode(DatasetCache &cache, ManagedBuffer &mb
            , geo::heightcoding::Config config
            , const boost::optional<std::string> &vectorGeoidGrid
            , const GdalWarper::OpenOptions &openOptions
-           , const LayerEnhancer::map &layerEnancers);
+           , const LayerEnhancer::map &layerEnancers
+           , const boost::optional<math::Extents2> &localDemExtents
+           , bool cacheVector);
 
 #endif // mapproxy_gdalsupport_operations_hpp_included_
@@ -187,6 +187,8 @@ ShHeightCode
                , const boost::optional<std::string> &vectorGeoidGrid
                , const std::vector<std::string> &openOptions
                , const LayerEnhancer::map &layerEnhancers
+               , const boost::optional<math::Extents2> &localDemExtents
+               , bool cacheVector
                , ManagedBuffer &sm, ShRequestBase *owner)
     : sm_(sm), owner_(owner)
     , vectorDs_(vectorDs.data(), vectorDs.size()
@@ -195,6 +197,8 @@ ShHeightCode
     , config_(config, sm)
     , vectorGeoidGrid_(sm.get_allocator<char>())
     , layerEnhancers_(sm.get_allocator<char>())
+    , localDemExtents_(localDemExtents)
+    , cacheVector_(cacheVector)
     , response_()
 {
     // copy strings to shared memory
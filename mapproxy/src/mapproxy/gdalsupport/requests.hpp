@@ -120,6 +120,8 @@ public:
                  , const boost::optional<std::string> &vectorGeoidGrid
                  , const std::vector<std::string> &openOptions
                  , const LayerEnhancer::map &layerEnhancers
+                 , const boost::optional<math::Extents2> &localDemExtents
+                 , bool cacheVector
                  , ManagedBuffer &sm, ShRequestBase *owner);
 
     ~ShHeightCode();
@@ -136,6 +138,12 @@ public:
 
     LayerEnhancer::map layerEnhancers() const;
 
+    boost::optional<math::Extents2> localDemExtents() const {
+        return localDemExtents_;
+    }
+
+    bool cacheVector() const { return cacheVector_; }
+
     /** Steals response.
      */
     GdalWarper::Heightcoded* response();
@@ -152,6 +160,8 @@ private:
     String vectorGeoidGrid_;
     boost::optional<StringVector> openOptions_;
     StringVector layerEnhancers_; // NB: encoded as 3 strings each
+    boost::optional<math::Extents2> localDemExtents_;
+    bool cacheVector_;
 
     // response memory block
     GdalWarper::Heightcoded *response_;
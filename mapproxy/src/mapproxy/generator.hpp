@@ -30,8 +30,11 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <tuple>
+#include <mutex>
 #include <iostream>
 #include <atomic>
+#include <functional>
 
 #include <boost/noncopyable.hpp>
 #include <boost/any.hpp>
@@ -39,6 +42,8 @@
 
 #include "utility/resourcefetcher.hpp"
 
+#include "jsoncpp/json.hpp"
+
 #include "vts-libs/storage/support.hpp"
 #include "vts-libs/vts/mapconfig.hpp"
 
@@ -47,6 +52,8 @@
 #include "./fileinfo.hpp"
 #include "./gdalsupport.hpp"
 #include "./sink.hpp"
+#include "./support/upstream.hpp"
+#include "./support/mmapped/memory.hpp"
 
 #include "./generator/demregistry.hpp"
 
@@ -56,9 +63,11 @@ namespace vts = vtslibs::vts;
 struct Arsenal {
     GdalWarper &warper;
     const utility::ResourceFetcher &fetcher;
+    UpstreamFetcher &upstream;
 
-    Arsenal(GdalWarper &warper, const utility::ResourceFetcher &fetcher)
-        : warper(warper), fetcher(fetcher)
+    Arsenal(GdalWarper &warper, const utility::ResourceFetcher &fetcher
+            , UpstreamFetcher &upstream)
+        : warper(warper), fetcher(fetcher), upstream(upstream)
     {}
 };
 
@@ -99,10 +108,29 @@ public:
         double defaultFov;
         std::set<Resource::Generator::Type> freezeResourceTypes;
 
+        /** Per-resource memory limit of heightcoded geodata cache (in MB, 0
+         *  disables caching completely, disk cache included).
+         */
+        std::size_t geodataCacheSize;
+
+        /** Keep heightcoded geodata on disk as well.
+         */
+        bool geodataDiskCache;
+
+        /** Per-resource disk limit of heightcoded geodata cache (in MB).
+         */
+        std::size_t geodataDiskCacheSize;
+
+        /** Memory mapping options for tile indices.
+         */
+        mmapped::MapOptions mmapOptions;
+
         Config()
             : fileFlags(), variables(), defaults()
             , defaultFov(vr::Position::naturalFov())
             , freezeResourceTypes{Resource::Generator::Type::surface}
+            , geodataCacheSize(64), geodataDiskCache(false)
+            , geodataDiskCacheSize(1024)
         {}
 
         bool freezes(Resource::Generator::Type type) const {
@@ -146,6 +174,37 @@ public:
      */
     void prepare(Arsenal &arsenal);
 
+    /** Resource this generator refers to (generator type and resource ID).
+     */
+    typedef std::pair<Resource::Generator::Type, Resource::Id> Dependency;
+    typedef std::vector<Dependency> Dependencies;
+
+    /** Resources this generator refers to (e.g. via introspection). Prepare
+     *  scheduler prepares dependencies first when possible.
+     */
+    Dependencies dependencies() const { return dependencies_impl(); }
+
+    /** Estimated cost of prepare, roughly in seconds. Used by prepare
+     *  scheduler to let cheap resources go first.
+     */
+    double prepareCost() const { return prepareCost_impl(); }
+
+    /** Number of requests received while not ready yet.
+     */
+    unsigned int demand() const { return demand_; }
+
+    /** Prepare progress in range [0, 1], negative if unknown.
+     */
+    double prepareProgress() const { return progress_; }
+
+    /** Tries to restore state prepared by previous run instead of calling
+     *  prepare(). Saved state is used only if it was created for the same
+     *  resource definition and revision. Makes generator ready on success.
+     *
+     * \return true if generator is ready
+     */
+    bool restore();
+
     const Resource& resource() const { return resource_; }
     const Resource::Id& id() const { return resource_.id; }
     const std::string& group() const { return resource_.id.group; }
@@ -169,6 +228,15 @@ public:
 
     Task generateFile(const FileInfo &fileInfo, Sink sink) const;
 
+    /** Computes weak entity tag of given tile file from resource ID,
+     *  generator, resource revision and definition, file path, query and
+     *  serving tag (see Generators::servingTag()). Returns empty string for
+     *  non-tile files and if generated content is not fully determined by
+     *  these.
+     */
+    std::string etag(const FileInfo &fileInfo
+                     , std::uint64_t servingTag) const;
+
     void stat(std::ostream &os) const;
 
     /** Pointer to original generator this one replaces.
@@ -182,6 +250,11 @@ public:
      */
     void commitEnforcedChange();
 
+    /** Drops cached serialized mapConfig. Must be called whenever set of
+     *  serving resources changes since mapConfig can refer to other resources.
+     */
+    void invalidateMapConfig() const;
+
 protected:
     Generator(const Params &params);
 
@@ -190,6 +263,22 @@ protected:
 
     void mapConfig(std::ostream &os, ResourceRoot root) const;
 
+    /** Sends serialized mapConfig to the client. Gzipped serialization is
+     *  cached until invalidated.
+     */
+    void sendMapConfig(Sink &sink, const Sink::FileInfo &stat
+                       , ResourceRoot root) const;
+
+    typedef std::function<void(std::ostream&)> Serializer;
+
+    /** Sends serialized configuration file (mapConfig, definition) to the
+     *  client. Gzipped serialization is cached per file name and root until
+     *  invalidated; serializer is called only on cache miss.
+     */
+    void sendConfig(Sink &sink, const Sink::FileInfo &stat
+                    , const std::string &name, ResourceRoot root
+                    , const Serializer &serializer) const;
+
     std::string absoluteDataset(const std::string &path) const;
     boost::filesystem::path
     absoluteDataset(const boost::filesystem::path &path) const;
@@ -228,6 +317,10 @@ protected:
      */
     bool changeEnforced() const { return changeEnforced_; }
 
+    /** Reports prepare progress (in range [0, 1]) from prepare_impl.
+     */
+    void prepareProgress(double progress) { progress_ = progress; }
+
 private:
     virtual void prepare_impl(Arsenal &arsenal) = 0;
     virtual vts::MapConfig mapConfig_impl(ResourceRoot root) const = 0;
@@ -235,6 +328,35 @@ private:
     virtual Task generateFile_impl(const FileInfo &fileInfo
                                    , Sink &sink) const = 0;
 
+    /** Generator specific statistics.
+     */
+    virtual void stat_impl(std::ostream&) const {}
+
+    /** Fills in state computed by prepare_impl to be persisted for next run.
+     *  Returns false if there is nothing worth saving (default).
+     */
+    virtual bool savePrepared_impl(Json::Value&) const { return false; }
+
+    /** Restores state saved by savePrepared_impl. Returns false if state
+     *  cannot be used and generator must be prepared.
+     */
+    virtual bool loadPrepared_impl(const Json::Value&) { return false; }
+
+    std::string preparedDigest() const;
+
+    virtual Dependencies dependencies_impl() const { return {}; }
+
+    virtual double prepareCost_impl() const { return 1.0; }
+
+    /** Returns false if mapConfig changes in time and must not be cached.
+     */
+    virtual bool mapConfigCacheable_impl() const { return true; }
+
+    /** Returns false if generated content can change without revision bump
+     *  (e.g. time-dependent or proxied data) -> no entity tags.
+     */
+    virtual bool stableContent_impl() const { return true; }
+
     const GeneratorFinder *generatorFinder_;
     Config config_;
     Resource resource_;
@@ -243,8 +365,30 @@ private:
     bool system_;
     bool changeEnforced_;
     std::atomic<bool> ready_;
+    mutable std::atomic<unsigned int> demand_;
+    std::atomic<double> progress_;
     DemRegistry::pointer demRegistry_;
     Generator::pointer replace_;
+
+    /** Serialized config cache, key: (file name, revision, root depth, root
+     *  backup).
+     */
+    typedef std::tuple<std::string, unsigned int, int, int> MapConfigKey;
+    typedef std::map<MapConfigKey, std::shared_ptr<const std::string>>
+    MapConfigCache;
+    mutable std::mutex mapConfigLock_;
+    mutable MapConfigCache mapConfigCache_;
+
+    /** Bumped on each invalidation; serialization started before
+     *  invalidation is not stored in the cache.
+     */
+    mutable unsigned long mapConfigGeneration_;
+
+    /** Digest of resource definition (see preparedDigest()), mixed into
+     *  entity tags: safe definition changes do not bump revision but can
+     *  change generated content.
+     */
+    std::string definitionDigest_;
 };
 
 /** Set of dataset generators.
@@ -296,6 +440,12 @@ public:
      */
     void update();
 
+    /** Digest of current set of serving resources (IDs, revisions and
+     *  readiness). Changes whenever any resource is added, removed, updated
+     *  or becomes ready.
+     */
+    std::uint64_t servingTag() const;
+
     void stat(std::ostream &os) const;
 
     // internals
@@ -309,16 +459,6 @@ private:
 
 // inlines
 
-inline void Generator::prepare(Arsenal &arsenal)
-{
-    // prepare only when not ready
-    if (ready_) { return; }
-
-    // prepare and make ready
-    prepare_impl(arsenal);
-    makeReady();
-}
-
 inline vts::MapConfig Generator::mapConfig(ResourceRoot root) const
 {
     return mapConfig_impl(root);
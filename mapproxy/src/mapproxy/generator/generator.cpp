@@ -26,12 +26,16 @@
 
 #include <thread>
 #include <condition_variable>
+#include <cctype>
 #include <sstream>
 #include <deque>
+#include <fstream>
+#include <iomanip>
+#include <cstdint>
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
-#include <boost/asio.hpp>
+#include <boost/crc.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/identity.hpp>
@@ -43,18 +47,39 @@
 #include "utility/path.hpp"
 #include "utility/gccversion.hpp"
 
+#include "jsoncpp/io.hpp"
+
 #include "../error.hpp"
 #include "../generator.hpp"
+#include "../support/gzip.hpp"
 #include "./factory.hpp"
+#include "./preparescheduler.hpp"
 
 namespace fs = boost::filesystem;
-namespace asio = boost::asio;
 namespace bmi = boost::multi_index;
 namespace ba = boost::algorithm;
 
 namespace {
 
 const std::string ResourceFile("resource.json");
+const std::string PreparedFile("prepared.json");
+
+/** Bump whenever generated output changes without resource revision bump to
+ *  invalidate all entity tags.
+ */
+const unsigned int ETagVersion(1);
+
+/** 64-bit FNV-1a hash, stable between runs.
+ */
+std::uint64_t fnv1a(const std::string &str)
+{
+    std::uint64_t hash(0xcbf29ce484222325ull);
+    for (unsigned char c : str) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
 
 typedef std::map<Resource::Generator, Generator::Factory::pointer> Registry;
 Registry registry;
@@ -99,9 +124,9 @@ Generator::Generator(const Params &params)
     , resource_(params.resource), savedResource_(params.resource)
     , fresh_(false), system_(params.system)
     , changeEnforced_(false)
-    , ready_(false)
+    , ready_(false), demand_(0), progress_(-1.0)
     , demRegistry_(params.demRegistry)
-    , replace_(params.replace)
+    , replace_(params.replace), mapConfigGeneration_(0)
 {
     config_.root = (config_.root / resource_.id.referenceFrame
                     / resource_.id.group / resource_.id.id);
@@ -169,6 +194,9 @@ Generator::Generator(const Params &params)
             }
         }
     }
+
+    // resource is final now
+    definitionDigest_ = preparedDigest();
 }
 
 Changed Generator::changed(const Resource &resource) const
@@ -201,6 +229,112 @@ void Generator::makeReady()
                << "> (type <" << resource().generator << ">).";
 }
 
+void Generator::prepare(Arsenal &arsenal)
+{
+    // prepare only when not ready
+    if (ready_) { return; }
+
+    // saved state (if any) is invalid from now on
+    const auto path(root() / PreparedFile);
+    {
+        boost::system::error_code ec;
+        fs::remove(path, ec);
+    }
+
+    // prepare
+    prepare_impl(arsenal);
+
+    // persist prepared state for next run; failure is not fatal
+    try {
+        Json::Value state;
+        if (savePrepared_impl(state)) {
+            Json::Value value(Json::objectValue);
+            value["digest"] = preparedDigest();
+            value["revision"] = resource_.revision;
+            value["state"] = state;
+
+            const auto tmpPath(utility::addExtension(path, ".tmp"));
+            {
+                std::ofstream f;
+                f.exceptions(std::ios::badbit | std::ios::failbit);
+                f.open(tmpPath.string(), std::ios_base::out
+                       | std::ios_base::trunc);
+                Json::write(f, value);
+                f.close();
+            }
+            fs::rename(tmpPath, path);
+        }
+    } catch (const std::exception &e) {
+        LOG(warn2) << "Unable to save prepared state of <" << id()
+                   << ">: <" << e.what() << ">.";
+    }
+
+    // and make ready
+    makeReady();
+}
+
+bool Generator::restore()
+{
+    if (ready_) { return true; }
+
+    // enforced change must go through prepare
+    if (changeEnforced_) { return false; }
+
+    const auto path(root() / PreparedFile);
+    if (!fs::exists(path)) { return false; }
+
+    try {
+        std::ifstream f;
+        f.exceptions(std::ios::badbit | std::ios::failbit);
+        f.open(path.string(), std::ios_base::in);
+        const auto value(Json::read<FormatError>(f, path, "prepared state"));
+
+        if ((value["digest"].asString() != preparedDigest())
+            || (value["revision"].asUInt() != resource_.revision))
+        {
+            LOG(info2) << "Prepared state of <" << id()
+                       << "> is stale, ignoring.";
+            return false;
+        }
+
+        if (!loadPrepared_impl(value["state"])) { return false; }
+    } catch (const std::exception &e) {
+        LOG(warn2) << "Unable to restore prepared state of <" << id()
+                   << ">: <" << e.what() << ">.";
+        return false;
+    }
+
+    LOG(info2) << "Restored prepared state of <" << id() << ">.";
+    makeReady();
+    return true;
+}
+
+std::string Generator::preparedDigest() const
+{
+    // definition + anything else in resource that affects prepared data
+    boost::any tmp(Json::Value(Json::objectValue));
+    resource_.definition()->to(tmp);
+
+    std::ostringstream os;
+    os.precision(15);
+    const auto &lr(resource_.lodRange);
+    const auto &tr(resource_.tileRange);
+    os << resource_.generator.type << '|' << resource_.generator.driver
+       << '|' << lr.min << ',' << lr.max
+       << '|' << tr.ll(0) << ',' << tr.ll(1) << ',' << tr.ur(0) << ','
+       << tr.ur(1) << '|';
+    Json::write(os, boost::any_cast<const Json::Value&>(tmp));
+
+    // NB: must be stable between runs -> no std::hash
+    boost::crc_32_type crc;
+    const auto str(os.str());
+    crc.process_bytes(str.data(), str.size());
+
+    std::ostringstream dos;
+    dos << std::hex << crc.checksum();
+    return dos.str();
+}
+
 void Generator::mapConfig(std::ostream &os, ResourceRoot root)
     const
 {
@@ -208,6 +342,87 @@ void Generator::mapConfig(std::ostream &os, ResourceRoot root)
     vts::saveMapConfig(mc, os);
 }
 
+void Generator::sendMapConfig(Sink &sink, const Sink::FileInfo &stat
+                              , ResourceRoot root) const
+{
+    sendConfig(sink, stat, "mapConfig.json", root, [&](std::ostream &os)
+    {
+        mapConfig(os, root);
+    });
+}
+
+void Generator::sendConfig(Sink &sink, const Sink::FileInfo &stat
+                           , const std::string &name, ResourceRoot root
+                           , const Serializer &serializer) const
+{
+    const MapConfigKey key(name, resource_.revision, root.depth
+                           , root.backup);
+
+    std::shared_ptr<const std::string> data;
+    const auto cacheable(mapConfigCacheable_impl());
+    unsigned long generation(0);
+    if (cacheable) {
+        std::unique_lock<std::mutex> lock(mapConfigLock_);
+        auto fcache(mapConfigCache_.find(key));
+        if (fcache != mapConfigCache_.end()) { data = fcache->second; }
+        generation = mapConfigGeneration_;
+    }
+
+    if (!data) {
+        // not cached, serialize and compress
+        std::ostringstream os;
+        serializer(os);
+        data = std::make_shared<const std::string>(gzip(os.str()));
+
+        if (cacheable) {
+            std::unique_lock<std::mutex> lock(mapConfigLock_);
+            // do not store if cache has been invalidated in the meantime
+            if (generation == mapConfigGeneration_) {
+                mapConfigCache_[key] = data;
+            }
+        }
+    }
+
+    auto fi(stat);
+    sink.content(data, fi.setContentEncoding(ContentEncoding::gzip));
+}
+
+std::string Generator::etag(const FileInfo &fileInfo
+                            , std::uint64_t servingTag) const
+{
+    if (!stableContent_impl()) { return {}; }
+
+    // only tile data (lod-x-y...) are tagged; configuration files are cheap
+    // to generate (and cached) but depend on the rest of the resource set
+    if (fileInfo.filename.empty()
+        || !std::isdigit(static_cast<unsigned char>(fileInfo.filename[0])))
+    {
+        return {};
+    }
+
+    std::ostringstream os;
+    os << ETagVersion << '|' << resource_.id.referenceFrame
+       << '|' << resource_.id.group << '|' << resource_.id.id
+       << '|' << resource_.generator.type << '|' << resource_.generator.driver
+       << '|' << resource_.revision
+       << '|' << definitionDigest_
+       << '|' << fileInfo.path << '|' << fileInfo.query
+       << '|' << servingTag;
+
+    // weak tag: the same entity may be sent in different content encodings
+    std::ostringstream es;
+    es << "W/\"" << std::hex << std::setw(16) << std::setfill('0')
+       << fnv1a(os.str()) << '-' << std::dec << resource_.revision << '"';
+    return es.str();
+}
+
+void Generator::invalidateMapConfig() const
+{
+    std::unique_lock<std::mutex> lock(mapConfigLock_);
+    mapConfigCache_.clear();
+    ++mapConfigGeneration_;
+}
+
 namespace {
 
 bool isRemote(const std::string &path)
@@ -274,6 +489,9 @@ Generator
 void Generator::checkReady() const
 {
     if (ready_) { return; }
+
+    // remember demand, prepare scheduler prefers resources being asked for
+    ++demand_;
     throw Unavailable("Generator not ready.");
 }
 
@@ -337,8 +555,10 @@ public:
     Detail(const Generators::Config &config
            , const ResourceBackend::pointer &resourceBackend)
         : config_(config), resourceBackend_(resourceBackend)
-        , arsenal_(), running_(false), ready_(false), preparing_(0)
-        , work_(ios_), demRegistry_(std::make_shared<DemRegistry>())
+        , arsenal_(), running_(false), prepareFailed_(false)
+        , serving_(std::make_shared<GeneratorMap>())
+        , servingTag_(0), ready_(false), preparing_(0)
+        , demRegistry_(std::make_shared<DemRegistry>())
     {
         registerSystemGenerators();
     }
@@ -365,6 +585,8 @@ public:
 
     inline const DemRegistry& demRegistry() const { return *demRegistry_; }
 
+    inline std::uint64_t servingTag() const { return servingTag_; }
+
     void update();
 
     void stat(std::ostream &os) const;
@@ -375,11 +597,13 @@ public:
 private:
     void registerSystemGenerators();
 
-    void update(const Resource::map &resources);
+    bool update(const Resource::map &resources);
 
     void updater();
     void worker(std::size_t id);
-    void prepare(const Generator::pointer &generator);
+    /** Queues generators for prepare in one go.
+     */
+    void prepare(const Generator::list &generators);
 
     virtual Generator::pointer
     findGenerator_impl(Resource::Generator::Type generatorType
@@ -393,6 +617,10 @@ private:
     std::thread updater_;
     std::atomic<bool> running_;
     std::atomic<bool> updateRequest_;
+    /** Set by prepare worker when generator preparation fails; forces full
+     *  resource reload in the next update round.
+     */
+    std::atomic<bool> prepareFailed_;
     std::mutex updaterLock_;
     std::condition_variable updaterCond_;
 
@@ -433,24 +661,90 @@ private:
 
         > GeneratorMap;
 
+    typedef std::shared_ptr<const GeneratorMap> Snapshot;
+
+    /** Returns current snapshot of serving generators. Lock-free.
+     */
+    Snapshot serving() const { return std::atomic_load(&serving_); }
 
+    /** Copies current serving set, applies modifier to the copy and publishes
+     *  it as a new snapshot. Modifications are serialized, readers are never
+     *  blocked.
+     */
+    template <typename Modifier> void modify(const Modifier &modifier);
+
+    /** Drops cached mapConfigs of all serving generators.
+     */
+    void invalidateMapConfigs() const;
+
+    /** Called whenever set of serving generators or their readiness changes:
+     *  drops cached mapConfigs and recomputes serving tag. Must be called
+     *  under modifyLock_.
+     */
+    void servingChanged();
 
     // internals
-    mutable std::mutex lock_;
-    GeneratorMap serving_;
+
+    /** Serializes writers, readers use atomic snapshot.
+     */
+    std::mutex modifyLock_;
+
+    /** Immutable snapshot of serving generators; access only via
+     *  std::atomic_load/std::atomic_store.
+     */
+    Snapshot serving_;
+
+    /** Digest of current serving set, mixed into entity tags since generated
+     *  content can depend on other resources (introspection, DEMs).
+     */
+    std::atomic<std::uint64_t> servingTag_;
 
     std::atomic<bool> ready_;
     std::atomic<int> preparing_;
 
     // prepare stuff
-    asio::io_service ios_;
-    asio::io_service::work work_;
+    PrepareScheduler scheduler_;
     std::vector<std::thread> workers_;
 
     // DEM registry
     DemRegistry::pointer demRegistry_;
 };
 
+template <typename Modifier>
+void Generators::Detail::modify(const Modifier &modifier)
+{
+    std::unique_lock<std::mutex> lock(modifyLock_);
+    auto copy(std::make_shared<GeneratorMap>(*serving()));
+    modifier(*copy);
+    std::atomic_store(&serving_, Snapshot(std::move(copy)));
+
+    servingChanged();
+}
+
+void Generators::Detail::servingChanged()
+{
+    // mapConfigs can refer to other resources
+    invalidateMapConfigs();
+
+    // NB: must be stable between runs -> iterate by resource ID
+    const auto snapshot(serving());
+    std::ostringstream os;
+    for (const auto &generator : snapshot->get<ResourceIdIdx>()) {
+        os << generator->id() << '|' << generator->type() << '|'
+           << generator->resource().revision << '|' << generator->ready()
+           << '\n';
+    }
+    servingTag_ = fnv1a(os.str());
+}
+
+void Generators::Detail::invalidateMapConfigs() const
+{
+    const auto snapshot(serving());
+    for (const auto &generator : *snapshot) {
+        generator->invalidateMapConfig();
+    }
+}
+
 void Generators::Detail::checkReady() const
 {
     if (ready_) { return; }
@@ -488,7 +782,7 @@ void Generators::Detail::stop()
     if (!running_) { return; }
 
     running_ = false;
-    ios_.stop();
+    scheduler_.stop();
 
     updaterCond_.notify_all();
     updater_.join();
@@ -509,12 +803,23 @@ void Generators::Detail::updater()
     // invalidate any update request
     updateRequest_ = false;
 
+    // full reload is forced on first run, on explicit request and after
+    // incomplete update
+    bool force(true);
+
     while (running_) {
         // default sleep time in seconds
         std::chrono::seconds sleep(config_.resourceUpdatePeriod);
 
+        // retry resources that failed to prepare
+        if (std::atomic_exchange(&prepareFailed_, false)) { force = true; }
+
         try {
-            update(resourceBackend_->load());
+            if (force || resourceBackend_->changed()) {
+                force = !update(resourceBackend_->load());
+            } else {
+                LOG(info1) << "Resources unchanged, skipping update.";
+            }
         } catch (Aborted) {
             // pass
         } catch (const std::exception &e) {
@@ -522,6 +827,7 @@ void Generators::Detail::updater()
             if (config_.resourceUpdatePeriod > 0) {
                 sleep = std::chrono::seconds(5);
             }
+            force = true;
         }
 
         // sleep for configured time minutes
@@ -529,10 +835,11 @@ void Generators::Detail::updater()
             std::unique_lock<std::mutex> lock(updaterLock_);
 
             // condition variable wait predicate
-            const auto predicate([this]() -> bool
+            const auto predicate([this, &force]() -> bool
             {
                 auto updateRequest
                     (std::atomic_exchange(&updateRequest_, false));
+                if (updateRequest) { force = true; }
                 return !running_ || updateRequest;
             });
 
@@ -552,31 +859,22 @@ void Generators::Detail::worker(std::size_t id)
     dbglog::thread_id(str(boost::format("prepare:%u") % id));
     LOG(info2) << "Spawned prepare worker id:" << id << ".";
 
-    for (;;) {
-        try {
-            ios_.run();
-            LOG(info2) << "Terminated prepare worker id:" << id << ".";
-            return;
-        } catch (const std::exception &e) {
-            LOG(err3)
-                << "Uncaught exception in worker: <" << e.what()
-                << ">. Going on.";
-        }
-    }
-}
-
-void Generators::Detail::prepare(const Generator::pointer &generator)
-{
-    ++preparing_;
-
-    ios_.post([=]()
-    {
+    while (auto generator = scheduler_.pop()) {
         try {
             generator->prepare(*arsenal_);
             if (auto original = generator->replace()) {
                 replace(original, generator);
+            } else {
+                // generator is ready now, might be referenced by others
+                std::unique_lock<std::mutex> lock(modifyLock_);
+                servingChanged();
             }
+            // NB: report only after publishing, waiters expect to see the
+            // prepared generator in the serving set
+            scheduler_.done(generator, true);
         } catch (const std::exception &e) {
+            scheduler_.done(generator, false);
+
             LOG(warn2)
                 << "Failed to prepare generator for <"
                 << generator->resource().id << "> (" << e.what()
@@ -584,12 +882,23 @@ void Generators::Detail::prepare(const Generator::pointer &generator)
 
             resourceBackend_->error(generator->resource().id, e.what());
 
-            // erease from map (under lock)
-            std::unique_lock<std::mutex> lock(lock_);
-            serving_.erase(generator);
+            // erase from map
+            modify([&](GeneratorMap &serving) { serving.erase(generator); });
+
+            // make updater retry on next round
+            prepareFailed_ = true;
         }
         --preparing_;
-    });
+    }
+
+    LOG(info2) << "Terminated prepare worker id:" << id << ".";
+}
+
+void Generators::Detail::prepare(const Generator::list &generators)
+{
+    if (generators.empty()) { return; }
+    preparing_ += generators.size();
+    scheduler_.push(generators);
 }
 
 void Generators::Detail::registerSystemGenerators()
@@ -631,7 +940,7 @@ void Generators::Detail::registerSystemGenerators()
             auto g(factory->create(params));
 
             // register
-            serving_.insert(g);
+            modify([&](GeneratorMap &serving) { serving.insert(g); });
 
             // and prepare if not ready
             if (!g->ready()) {
@@ -677,27 +986,34 @@ Generators::generator(Resource::Generator::Type generatorType
 void Generators::Detail::replace(const Generator::pointer &original
                                  , const Generator::pointer &replacement)
 {
-    std::unique_lock<std::mutex> lock(lock_);
-    // find original in the serving set
-    auto ioriginal(serving_.find(original));
-    // and replace
-    serving_.replace(ioriginal, replacement);
+    modify([&](GeneratorMap &serving)
+    {
+        // find original in the serving set
+        auto ioriginal(serving.find(original));
+        if (ioriginal == serving.end()) { return; }
+        // and replace
+        serving.replace(ioriginal, replacement);
+    });
     LOG(info3)
         << "Replaced resource <" << original->id() << "> with new definiton.";
 }
 
-void Generators::Detail::update(const Resource::map &resources)
+bool Generators::Detail::update(const Resource::map &resources)
 {
     LOG(info2) << "Updating resources.";
 
     auto iresources(resources.begin()), eresources(resources.end());
-    auto &idx(serving_.get<ResourceIdIdx>());
+    const auto snapshot(serving());
+    auto &idx(snapshot->get<ResourceIdIdx>());
     auto iserving(idx.begin()), eserving(idx.end());
 
     Generator::list toAdd;
     Generator::list toRemove;
     Generator::list toReplace;
 
+    // false if any generator failed to be created
+    bool complete(true);
+
     auto add([&](const Resource &res)
     {
         if (!running_) {
@@ -713,6 +1029,7 @@ void Generators::Detail::update(const Resource::map &resources)
         } catch (const std::exception &e) {
             LOG(err2) << "Failed to create generator for resource <"
                       << iresources->first << ">: <" << e.what() << ">.";
+            complete = false;
         }
     });
 
@@ -732,6 +1049,7 @@ void Generators::Detail::update(const Resource::map &resources)
         } catch (const std::exception &e) {
             LOG(err2) << "Failed to re-create generator for resource <"
                       << iresources->first << ">: <" << e.what() << ">.";
+            complete = false;
         }
     });
 
@@ -786,37 +1104,40 @@ void Generators::Detail::update(const Resource::map &resources)
         }
     }
 
-    // add stuff
-    for (const auto &generator : toAdd) {
+    // add and remove stuff in one go
+    if (!toAdd.empty() || !toRemove.empty()) {
+        modify([&](GeneratorMap &serving)
         {
-            std::unique_lock<std::mutex> lock(lock_);
-            serving_.insert(generator);
-        }
-
-        if (!generator->ready()) {
-            prepare(generator);
-        }
+            for (const auto &generator : toAdd) { serving.insert(generator); }
+            for (const auto &generator : toRemove) {
+                serving.erase(generator);
+            }
+        });
     }
 
-    // remove stuff
-    for (const auto &generator : toRemove) {
-        {
-            std::unique_lock<std::mutex> lock(lock_);
-            serving_.erase(generator);
+    // prepare added stuff (unless state saved by previous run is usable);
+    // everything is queued at once after all (slow) restores so workers
+    // see whole batch and thus all dependencies
+    Generator::list toPrepare;
+    for (const auto &generator : toAdd) {
+        if (!generator->restore()) {
+            toPrepare.push_back(generator);
         }
-
-        // TODO: mark as to be removed for prepare workers
     }
 
+    // TODO: mark removed stuff as to be removed for prepare workers
+
     // replace stuff (prepare)
     for (const auto &generator : toReplace) {
-        if (!generator->ready()) {
-            prepare(generator);
+        if (!generator->restore()) {
+            toPrepare.push_back(generator);
         } else {
             this->replace(generator->replace(), generator);
         }
     }
 
+    prepare(toPrepare);
+
     LOG(info2) << "Resources updated.";
     if (!ready_) {
         ready_ = true;
@@ -827,6 +1148,8 @@ void Generators::Detail::update(const Resource::map &resources)
     while (preparing_ && running_) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+
+    return complete;
 }
 
 Generator::list
@@ -838,8 +1161,8 @@ Generators::Detail::referenceFrame(const std::string &referenceFrame)
     Generator::list out;
 
     // use only ready generators that handle datasets for given reference frame
-    std::unique_lock<std::mutex> lock(lock_);
-    auto &idx(serving_.get<ReferenceFrameIdx>());
+    const auto snapshot(serving());
+    auto &idx(snapshot->get<ReferenceFrameIdx>());
     for (auto range(idx.equal_range(referenceFrame));
          range.first != range.second; ++range.first)
     {
@@ -858,11 +1181,11 @@ Generators::Detail::generator(Resource::Generator::Type generatorType
 {
     checkReady();
 
-    // find generator (under lock)
+    // find generator in current snapshot
     auto generator([&]() -> Generator::pointer
     {
-        std::unique_lock<std::mutex> lock(lock_);
-        auto &idx(serving_.get<ResourceIdIdx>());
+        const auto snapshot(serving());
+        auto &idx(snapshot->get<ResourceIdIdx>());
         auto fserving(idx.find(resourceId));
         if (fserving == idx.end()) { return {}; }
         return *fserving;
@@ -902,9 +1225,9 @@ Generators::Detail::listGroups(const std::string &referenceFrame
 
     std::vector<std::string> out;
     {
-        std::unique_lock<std::mutex> lock(lock_);
+        const auto snapshot(serving());
 
-        auto &idx(serving_.get<TypeIdx>());
+        auto &idx(snapshot->get<TypeIdx>());
         std::string prev;
         for (auto range(idx.equal_range(TypeKey(referenceFrame, type)));
              range.first != range.second; ++range.first)
@@ -930,8 +1253,8 @@ Generators::Detail::listIds(const std::string &referenceFrame
 
     std::vector<std::string> out;
     {
-        std::unique_lock<std::mutex> lock(lock_);
-        auto &idx(serving_.get<GroupIdx>());
+        const auto snapshot(serving());
+        auto &idx(snapshot->get<GroupIdx>());
         for (auto range(idx.equal_range
                         (GroupKey(referenceFrame, type, group)));
              range.first != range.second; ++range.first)
@@ -987,26 +1310,27 @@ void Generators::update()
     detail().update();
 }
 
+std::uint64_t Generators::servingTag() const
+{
+    return detail().servingTag();
+}
+
 void Generator::stat(std::ostream &os) const
 {
     os << "<" << id()
        << "> (type <" << resource().generator << ">)"
        << (ready_ ? "" : " not ready")
        << "\n";
+    stat_impl(os);
 }
 
 void Generators::Detail::stat(std::ostream &os) const
 {
+    scheduler_.stat(os);
 
-    Generator::list generators;
-    {
-        std::unique_lock<std::mutex> lock(lock_);
-        for (const auto &generator : serving_) {
-            generators.push_back(generator);
-        }
-    }
-
-    for (const auto &generator : generators) {
+    // snapshot keeps generators alive
+    const auto snapshot(serving());
+    for (const auto &generator : *snapshot) {
         generator->stat(os);
     }
 }
@@ -68,6 +68,7 @@ void parseDefinition(GeodataVectorTiled::Definition &def
         def.maxSourceLod = boost::in_place();
         Json::get(*def.maxSourceLod, value, "maxSourceLod");
     }
+    Json::getOpt(def.tileLocalDem, value, "tileLocalDem");
 }
 
 struct Factory : Generator::Factory {
@@ -90,6 +91,9 @@ void parseDefinition(GeodataVectorTiled::Definition &def
     if (value.has_key("maxSourceLod")) {
         def.maxSourceLod = boost::python::extract<int>(value["maxSourceLod"]);
     }
+    if (value.has_key("tileLocalDem")) {
+        def.tileLocalDem = boost::python::extract<bool>(value["tileLocalDem"]);
+    }
 }
 
 void buildDefinition(Json::Value &value
@@ -98,6 +102,9 @@ void buildDefinition(Json::Value &value
     if (def.maxSourceLod) {
         value["maxSourceLod"] = *def.maxSourceLod;
     }
+    if (def.tileLocalDem) {
+        value["tileLocalDem"] = def.tileLocalDem;
+    }
 }
 
 utility::PreMain Factory::register_([]()
@@ -160,6 +167,11 @@ Changed GeodataVectorTiled::Definition::changed_impl(const DefinitionBase &o)
         return Changed::withRevisionBump;
     }
 
+    // different height sampling leads to revision bump
+    if (tileLocalDem != other.tileLocalDem) {
+        return Changed::withRevisionBump;
+    }
+
     // pass result from parent
     return changed;
 }
@@ -241,7 +253,8 @@ GeodataVectorTiled::GeodataVectorTiled(const Params &params)
 
             // load delivery index
             index_ = boost::in_place(referenceFrame().metaBinaryOrder
-                                     , deliveryIndexPath);
+                                     , deliveryIndexPath
+                                     , config().mmapOptions);
             makeReady();
             return;
         }
@@ -282,7 +295,8 @@ void GeodataVectorTiled::prepare_impl(Arsenal&)
         fs::rename(tmpPath, deliveryIndexPath);
 
         index_ = boost::in_place(referenceFrame().metaBinaryOrder
-                                 , deliveryIndexPath);
+                                 , deliveryIndexPath
+                                 , config().mmapOptions);
     }
 }
 
@@ -315,6 +329,14 @@ vr::FreeLayer GeodataVectorTiled::freeLayer_impl(ResourceRoot root) const
     return fl;
 }
 
+void GeodataVectorTiled::stat_impl(std::ostream &os) const
+{
+    if (!ready() || !index_) { return; }
+
+    os << "    tile index: " << index_->tileIndex.resident() << " of "
+       << index_->tileIndex.size() << " bytes resident\n";
+}
+
 vts::MapConfig GeodataVectorTiled::mapConfig_impl(ResourceRoot root)
     const
 {
@@ -452,17 +474,22 @@ void GeodataVectorTiled::generateGeodata(Sink &sink
         openOptions.push_back(os.str());
     }
 
+    // sample heights from DEM warped to this tile if asked to
+    boost::optional<math::Extents2> localDemExtents;
+    if (definition_.tileLocalDem) { localDemExtents = nodeInfo.extents(); }
+
     // heightcode data using warper's machinery
     auto hc(arsenal.warper.heightcode
             (tileFile, datasets.first, config, dem_.geoidGrid
-             , openOptions, layerEnhancers(), sink));
+             , openOptions, layerEnhancers(), sink, localDemExtents, true));
 
     // force 1 hour max age if not all views from viewspec have been found
     boost::optional<long> maxAge;
     if (!datasets.second) { maxAge = 3600; }
 
-    sink.content(hc->data, hc->size
-                 , fi.sinkFileInfo().setMaxAge(maxAge), true);
+    // send directly from shared memory, block is released once sent
+    sink.content(hc->data, hc->size, hc
+                 , fi.sinkFileInfo().setMaxAge(maxAge));
 }
 
 } // namespace generator
@@ -49,6 +49,13 @@ public:
          */
         boost::optional<vts::Lod> maxSourceLod;
 
+        /** Sample heights from DEM warped to tile extents instead of reading
+         *  datasets for each vertex.
+         */
+        bool tileLocalDem;
+
+        Definition() : tileLocalDem(false) {}
+
         virtual void from_impl(const boost::any &value);
         virtual void to_impl(boost::any &value) const;
 
@@ -62,6 +69,12 @@ private:
     virtual vts::MapConfig mapConfig_impl(ResourceRoot root) const;
     virtual vr::FreeLayer freeLayer_impl(ResourceRoot root) const;
 
+    virtual void stat_impl(std::ostream &os) const;
+
+    /** Tile index is built from scratch.
+     */
+    virtual double prepareCost_impl() const { return 10.0; }
+
     virtual void generateMetatile(Sink &sink
                                   , const GeodataFileInfo &fileInfo
                                   , Arsenal &arsenal) const;
@@ -24,7 +24,12 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sstream>
+#include <fstream>
+#include <functional>
+
 #include <boost/filesystem.hpp>
+#include <boost/crc.hpp>
 
 #include "utility/premain.hpp"
 #include "utility/raise.hpp"
@@ -35,6 +40,7 @@
 
 #include "jsoncpp/json.hpp"
 #include "jsoncpp/as.hpp"
+#include "jsoncpp/io.hpp"
 
 #include "vts-libs/storage/fstreams.hpp"
 
@@ -42,6 +48,7 @@
 #include "../support/tileindex.hpp"
 #include "../support/srs.hpp"
 #include "../support/revision.hpp"
+#include "../support/gzip.hpp"
 
 #include "./geodata-vector.hpp"
 #include "./factory.hpp"
@@ -75,6 +82,35 @@ utility::PreMain Factory::register_([]()
          , std::make_shared<Factory>());
 });
 
+std::string digest(const DefinitionBase &definition)
+{
+    boost::any tmp(Json::Value(Json::objectValue));
+    definition.to(tmp);
+
+    std::ostringstream os;
+    os.precision(15);
+    Json::write(os, boost::any_cast<const Json::Value&>(tmp));
+
+    // NB: used in persistent cache keys -> must be stable between runs
+    boost::crc_32_type crc;
+    const auto str(os.str());
+    crc.process_bytes(str.data(), str.size());
+
+    std::ostringstream dos;
+    dos << std::hex << crc.checksum();
+    return dos.str();
+}
+
+boost::optional<fs::path> hcCacheRoot(const Generator::Config &config
+                                      , const fs::path &root)
+{
+    // zero size disables the cache completely
+    if (!config.geodataDiskCache || !config.geodataCacheSize) {
+        return boost::none;
+    }
+    return root / "hccache";
+}
+
 } // namespace
 
 GeodataVector::GeodataVector(const Params &params)
@@ -85,7 +121,15 @@ GeodataVector::GeodataVector(const Params &params)
     , physicalSrs_(vr::system.srs(resource()
                                   .referenceFrame->model.physicalSrs))
     , dataPath_(root() / "geodata")
+    , hcCache_(std::make_shared<ContentCache>
+               (config().geodataCacheSize << 20
+                , hcCacheRoot(config(), root())
+                , config().geodataDiskCacheSize << 20))
+    , definitionDigest_(digest(definition_))
 {
+    // drop data cached by other revisions/definitions
+    hcCache_->purge(hcCachePrefix());
+
     // load geodata only if there is no enforced change
     if (changeEnforced()) {
         LOG(info1) << "Generator for <" << id() << "> not ready.";
@@ -127,8 +171,33 @@ GeodataVector::heightcode(const DemDataset::list &datasets
     return hc;
 }
 
+std::string GeodataVector::hcCachePrefix() const
+{
+    // revision + definition (format config etc.)
+    std::ostringstream os;
+    os << resource().revision << '|' << definitionDigest_ << '|';
+    return os.str();
+}
+
+std::string GeodataVector::hcCacheKey(const DemDataset::list &datasets)
+    const
+{
+    // prefix + resolved datasets
+    std::ostringstream os;
+    os << hcCachePrefix();
+    for (const auto &ds : datasets) {
+        os << ds.dataset;
+        if (ds.geoidGrid) { os << '+' << *ds.geoidGrid; }
+        os << '|';
+    }
+    return os.str();
+}
+
 void GeodataVector::prepare_impl(Arsenal &arsenal)
 {
+    // anything cached is stale now
+    hcCache_->clear();
+
     Aborter dummyAborter;
     auto hc(heightcode({ dem_ }, arsenal.warper, dummyAborter));
 
@@ -222,15 +291,46 @@ void GeodataVector::generateGeodata(Sink &sink
     if (!datasets.second) { maxAge = 3600; }
 
     if (datasets.first.size() > 1) {
-        // valid viewspec -> use it to heightcode file
-        auto hc(heightcode(datasets.first, arsenal.warper, sink));
+        // valid viewspec -> use it to heightcode file, try cache first
+        const auto key(hcCacheKey(datasets.first));
+        auto data(hcCache_->get(key));
+        if (!data) {
+            auto hc(heightcode(datasets.first, arsenal.warper, sink));
+            if (!sink.accepts(ContentEncoding::gzip, FileClass::data)) {
+                // client cannot handle gzip, send as is
+                sink.content(hc->data, hc->size, hc
+                             , fi.sinkFileInfo().setMaxAge(maxAge));
+                return;
+            }
+
+            data = std::make_shared<std::string>(gzip(hc->data, hc->size));
+            hcCache_->put(key, data);
+        }
+
+        sink.content(data, fi.sinkFileInfo().setMaxAge(maxAge)
+                     .setContentEncoding(ContentEncoding::gzip));
+        return;
+    }
+
+    // no valid viewspec, return original file; compressed variant is kept in
+    // the cache as well
+    if (sink.accepts(ContentEncoding::gzip, FileClass::data)) {
+        const auto key(hcCacheKey({}));
+        auto data(hcCache_->get(key));
+        if (!data) {
+            std::ifstream f(dataPath_.string(), std::ios::binary);
+            f.exceptions(std::ios::badbit | std::ios::failbit);
+            std::ostringstream os;
+            os << f.rdbuf();
+            data = std::make_shared<std::string>(gzip(os.str()));
+            hcCache_->put(key, data);
+        }
 
-        sink.content(hc->data, hc->size
-                     , fi.sinkFileInfo().setMaxAge(maxAge), true);
+        sink.content(data, fi.sinkFileInfo().setMaxAge(maxAge)
+                     .setContentEncoding(ContentEncoding::gzip));
         return;
     }
 
-    // no valid viewspec, return original file
     sink.content(vs::fileIStream(fi.sinkFileInfo().contentType.c_str()
                                  , dataPath_)
                  , FileClass::data, maxAge);
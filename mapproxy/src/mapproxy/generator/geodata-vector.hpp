@@ -29,6 +29,8 @@
 
 #include "vts-libs/vts/tileset/tilesetindex.hpp"
 
+#include "../support/contentcache.hpp"
+
 #include "./geodatavectorbase.hpp"
 
 namespace generator {
@@ -49,6 +51,10 @@ public:
 private:
     virtual void prepare_impl(Arsenal &arsenal);
 
+    /** Whole dataset is heightcoded.
+     */
+    virtual double prepareCost_impl() const { return 100.0; }
+
     virtual vts::MapConfig mapConfig_impl(ResourceRoot root) const;
     virtual vr::FreeLayer freeLayer_impl(ResourceRoot root) const;
 
@@ -64,6 +70,15 @@ private:
     heightcode(const DemDataset::list &datasets
                , GdalWarper &warper, Aborter &aborter) const;
 
+    /** Builds heightcoded data cache key for given list of datasets.
+     */
+    std::string hcCacheKey(const DemDataset::list &datasets) const;
+
+    /** Common prefix of all heightcoded data cache keys (revision and
+     *  definition digest).
+     */
+    std::string hcCachePrefix() const;
+
     Definition definition_;
 
     const DemDataset dem_;
@@ -77,6 +92,15 @@ private:
     /** Path to cached output data.
      */
     boost::filesystem::path dataPath_;
+
+    /** Cache of gzipped heightcoded data for viewspec requests and of gzipped
+     *  original output.
+     */
+    ContentCache::pointer hcCache_;
+
+    /** Digest of definition, part of heightcoded data cache key.
+     */
+    std::string definitionDigest_;
 };
 
 } // namespace generator
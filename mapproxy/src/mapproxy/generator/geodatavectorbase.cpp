@@ -459,6 +459,13 @@ GeodataVectorBase::GeodataVectorBase(const Params &params, bool tiled)
     }
 }
 
+Generator::Dependencies GeodataVectorBase::dependencies_impl() const
+{
+    if (!definition_.introspection.surface) { return {}; }
+    return { Dependency(Resource::Generator::Type::surface
+                        , *definition_.introspection.surface) };
+}
+
 Generator::Task GeodataVectorBase::generateFile_impl(const FileInfo &fileInfo
                                                      , Sink &sink) const
 {
@@ -482,19 +489,17 @@ Generator::Task GeodataVectorBase::generateFile_impl(const FileInfo &fileInfo
                    ("Metatiles not supported by non-tiled driver."));
         break;
 
-    case GeodataFileInfo::Type::config: {
-        std::ostringstream os;
-        mapConfig(os, ResourceRoot::none);
-        sink.content(os.str(), fi.sinkFileInfo());
+    case GeodataFileInfo::Type::config:
+        sendMapConfig(sink, fi.sinkFileInfo(), ResourceRoot::none);
         break;
-    }
 
-    case GeodataFileInfo::Type::definition: {
-        std::ostringstream os;
-        vr::saveFreeLayer(os, freeLayer_impl(ResourceRoot::none));
-        sink.content(os.str(), fi.sinkFileInfo());
+    case GeodataFileInfo::Type::definition:
+        sendConfig(sink, fi.sinkFileInfo(), "freelayer.json"
+                   , ResourceRoot::none, [&](std::ostream &os)
+        {
+            vr::saveFreeLayer(os, freeLayer_impl(ResourceRoot::none));
+        });
         break;
-    }
 
     case GeodataFileInfo::Type::support:
         supportFile(*fi.support, sink, fi.sinkFileInfo());
@@ -100,6 +100,8 @@ private:
     virtual Task generateFile_impl(const FileInfo &fileInfo
                                    , Sink &sink) const;
 
+    virtual Dependencies dependencies_impl() const;
+
     virtual void generateMetatile(Sink &sink
                                   , const GeodataFileInfo &fileInfo
                                   , Arsenal &arsenal) const = 0;
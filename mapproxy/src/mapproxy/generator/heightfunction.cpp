@@ -1,6 +1,9 @@
+#include <algorithm>
+
 #include <boost/lexical_cast.hpp>
 
 #include "utility/enum-io.hpp"
+#include "utility/openmp.hpp"
 
 #include "jsoncpp/json.hpp"
 #include "jsoncpp/as.hpp"
@@ -25,6 +28,31 @@ SuperElevation::SuperElevation(const Config &config)
     limits_.max = apply(config_.heightRange.max);
 }
 
+void HeightFunction::operator()(double *values, std::size_t count
+                                , std::size_t stride) const
+{
+    for (std::size_t i(0); i < count; ++i, values += stride) {
+        *values = operator()(*values);
+    }
+}
+
+void SuperElevation::operator()(double *values, std::size_t count
+                                , std::size_t stride) const
+{
+    const auto hmin(config_.heightRange.min);
+    const auto hmax(config_.heightRange.max);
+    const auto smin(config_.scaleRange.min);
+    const auto s(s_);
+
+    // clamping to height range yields limits_ for values outside the range
+    UTILITY_OMP(simd)
+    for (std::size_t i = 0; i < count; ++i) {
+        auto &value(values[i * stride]);
+        const auto h(std::min(std::max(value, hmin), hmax));
+        value = h * ((h - hmin) * s + smin);
+    }
+}
+
 bool SuperElevation::Config::changed(const Config &other) const
 {
     if (heightRange != other.heightRange) { return true; }
@@ -28,6 +28,7 @@
 #define mapproxy_generator_heightfunction_hpp_included_
 
 #include <memory>
+#include <cstddef>
 #include <boost/any.hpp>
 
 #include "vts-libs/storage/range.hpp"
@@ -41,6 +42,13 @@ public:
     virtual ~HeightFunction() {}
     virtual double operator()(double h) const = 0;
 
+    /** Batch version: applies function in place to count values that are
+     *  stride doubles apart. Default implementation calls the single-value
+     *  version for each value.
+     */
+    virtual void operator()(double *values, std::size_t count
+                            , std::size_t stride = 1) const;
+
     static HeightFunction::pointer parse(const boost::any &value
                                          , const std::string &key);
     static bool changed(const HeightFunction::pointer &l
@@ -74,6 +82,9 @@ public:
         return apply(h);
     }
 
+    virtual void operator()(double *values, std::size_t count
+                            , std::size_t stride = 1) const;
+
     virtual void build(boost::any &value) const;
     virtual bool changed(const HeightFunction::pointer &other) const;
 
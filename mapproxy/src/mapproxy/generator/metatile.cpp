@@ -31,6 +31,7 @@
 #include "../support/grid.hpp"
 #include "../support/srs.hpp"
 #include "../support/mesh.hpp"
+#include "../support/heightgrid.hpp"
 
 #include "./metatile.hpp"
 
@@ -91,66 +92,30 @@ const math::Point3* getValue(const Sample &sample)
     return (sample.valid ? &sample.value : nullptr);
 }
 
-inline bool validSample(double value)
-{
-    return (value >= -1e6);
-}
-
 class ValueMinMaxSampler {
 public:
+    /** Prepares whole value/min/max grid at once: fills invalid samples from
+     *  their neighbourhood and applies height function in batch.
+     */
     ValueMinMaxSampler(const GdalWarper::Raster &dem
                        , const HeightFunction::pointer &heightFunction)
-        : dem_(dem), heightFunction_(heightFunction)
-    {}
-
-    boost::optional<cv::Vec3d> operator()(int i, int j) const {
-        // first, try exact value
-        const auto &v(dem_->at<cv::Vec3d>(j, i));
-        if (validSample(v[0])) { return applyHeightFunction(v); }
-
-        // output vector and count of valid samples
-        cv::Vec3d out(0, std::numeric_limits<double>::max()
-                      , std::numeric_limits<double>::lowest());
-        int count(0);
-
-        for (int jj(-1); jj <= +1; ++jj) {
-            for (int ii(-1); ii <= +1; ++ii) {
-                // ignore current point
-                if (!(ii || jj)) { continue; }
-
-                auto x(i + ii), y(j + jj);
-                // check bounds
-                if ((x < 0) || (x >= dem_->cols)
-                    || (y < 0) || (y >= dem_->rows))
-                    { continue; }
-
-                const auto &v(dem_->at<cv::Vec3d>(y, x));
-                if (validSample(v[0])) {
-                    out[0] += v[0];
-                    out[1] = std::min(out[1], v[1]);
-                    out[2] = std::max(out[2], v[2]);
-                    ++count;
-                }
-            }
+        : dem_(dem->clone()), validity_(heightValidity(dem_))
+    {
+        fillHeightHoles(dem_, validity_);
+        if (heightFunction) {
+            (*heightFunction)(dem_.ptr<double>()
+                              , dem_.total() * dem_.channels());
         }
-
-        if (!count) { return boost::none; }
-
-        out[0] /= count;
-        return applyHeightFunction(out);
     }
 
-private:
-    cv::Vec3d applyHeightFunction(cv::Vec3d value) const {
-        if (!heightFunction_) { return std::move(value); }
-        value[0] = (*heightFunction_)(value[0]);
-        value[1] = (*heightFunction_)(value[1]);
-        value[2] = (*heightFunction_)(value[2]);
-        return std::move(value);
+    const cv::Vec3d* operator()(int i, int j) const {
+        if (!validity_(j, i)) { return nullptr; }
+        return &dem_.at<cv::Vec3d>(j, i);
     }
 
-    GdalWarper::Raster dem_;
-    const HeightFunction::pointer &heightFunction_;
+private:
+    cv::Mat dem_;
+    HeightValidity validity_;
 };
 
 typedef vts::MetaNode::Flag MetaFlag;
@@ -170,6 +135,56 @@ inline MetaFlag::value_type ti2metaFlags(TiFlag::value_type ti)
     return meta;
 }
 
+/** Tile index flags of all tiles in a metatile. Plain tile index is queried
+ *  tile by tile, mmapped tile index is rasterized in a single traversal.
+ */
+template <typename TileIndexType> class MetatileFlags;
+
+template <>
+class MetatileFlags<vts::TileIndex> {
+public:
+    MetatileFlags(const vts::TileIndex &tileIndex, const vts::TileId&
+                  , unsigned int)
+        : tileIndex_(tileIndex)
+    {}
+
+    TiFlag::value_type operator()(const vts::TileId &tileId) const {
+        return tileIndex_.get(tileId);
+    }
+
+private:
+    const vts::TileIndex &tileIndex_;
+};
+
+template <>
+class MetatileFlags<mmapped::TileIndex> {
+public:
+    MetatileFlags(const mmapped::TileIndex &tileIndex
+                  , const vts::TileId &tileId, unsigned int order)
+        : origin_(tileId.lod, (tileId.x >> order) << order
+                  , (tileId.y >> order) << order)
+        , order_(order)
+    {
+        tileIndex.range(origin_, order_, flags_);
+    }
+
+    TiFlag::value_type operator()(const vts::TileId &tileId) const {
+        // NB: unsigned arithmetics, tiles before origin wrap around
+        const unsigned int x(tileId.x - origin_.x);
+        const unsigned int y(tileId.y - origin_.y);
+        const unsigned int size(1u << order_);
+        if ((tileId.lod != origin_.lod) || (x >= size) || (y >= size)) {
+            return TiFlag::none;
+        }
+        return flags_[(y << order_) + x];
+    }
+
+private:
+    vts::TileId origin_;
+    unsigned int order_;
+    std::vector<mmapped::TileIndex::value_type> flags_;
+};
+
 template <typename TileIndexType>
 vts::MetaTile
 metatileFromDemImpl(const vts::TileId &tileId, Sink &sink, Arsenal &arsenal
@@ -192,6 +207,10 @@ metatileFromDemImpl(const vts::TileId &tileId, Sink &sink, Arsenal &arsenal
 
     vts::MetaTile metatile(tileId, rf.metaBinaryOrder);
 
+    // fetch tile index flags for whole metatile at once
+    const MetatileFlags<TileIndexType> tileFlags
+        (tileIndex, tileId, rf.metaBinaryOrder);
+
     auto setChildren([&](const MetatileBlock &block
                          , const vts::TileId &nodeId, vts::MetaNode &node)
                      -> void
@@ -237,7 +256,7 @@ metatileFromDemImpl(const vts::TileId &tileId, Sink &sink, Arsenal &arsenal
 
                 // build metanode
                 vts::MetaNode node;
-                node.flags(ti2metaFlags(tileIndex.get(nodeId)));
+                node.flags(ti2metaFlags(tileFlags(nodeId)));
                 setChildren(block, nodeId, node);
                 metatile.set(nodeId, node);
             }
@@ -305,8 +324,11 @@ metatileFromDemImpl(const vts::TileId &tileId, Sink &sink, Arsenal &arsenal
         // grid mask
         const ShiftMask rfmask(block, metatileSamplesPerTile, maskTree);
 
+        // prepare samples and release shared data
+        const ValueMinMaxSampler vmm(dem, heightFunction);
+        dem.reset();
+
         // fill in grid
-        ValueMinMaxSampler vmm(dem, heightFunction);
         for (int j(0), je(gridSize.height); j < je; ++j) {
             auto y(extents.ur(1) - j * gts.height);
             for (int i(0), ie(gridSize.width); i < ie; ++i) {
@@ -326,9 +348,6 @@ metatileFromDemImpl(const vts::TileId &tileId, Sink &sink, Arsenal &arsenal
             }
         }
 
-        // release shared data
-        dem.reset();
-
         // generate metatile content
         for (int j(0), je(bSize.height); j < je; ++j) {
             for (int i(0), ie(bSize.width); i < ie; ++i) {
@@ -338,7 +357,7 @@ metatileFromDemImpl(const vts::TileId &tileId, Sink &sink, Arsenal &arsenal
 
                 // build metanode
                 vts::MetaNode node;
-                node.flags(ti2metaFlags(tileIndex.get(nodeId)));
+                node.flags(ti2metaFlags(tileFlags(nodeId)));
                 bool geometry(node.geometry());
                 bool navtile(node.navtile());
 
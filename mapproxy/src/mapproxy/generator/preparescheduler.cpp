@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+
+#include "dbglog/dbglog.hpp"
+
+#include "./preparescheduler.hpp"
+
+namespace {
+
+double seconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(d)
+        .count();
+}
+
+bool matches(const Generator::Dependency &dependency
+             , const Generator &generator)
+{
+    return ((dependency.first == generator.type())
+            && (dependency.second == generator.id()));
+}
+
+} // namespace
+
+PrepareScheduler::PrepareScheduler()
+    : running_(true)
+{}
+
+void PrepareScheduler::push(const Generator::list &generators)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (const auto &generator : generators) {
+            pending_.emplace_back(generator);
+        }
+    }
+    cond_.notify_all();
+}
+
+bool PrepareScheduler::blocked(const Job &job) const
+{
+    const auto check([&](const Job::list &jobs) -> bool
+    {
+        for (const auto &other : jobs) {
+            if (other.generator == job.generator) { continue; }
+            for (const auto &dependency : job.dependencies) {
+                if (matches(dependency, *other.generator)) { return true; }
+            }
+        }
+        return false;
+    });
+
+    return check(pending_) || check(active_);
+}
+
+double PrepareScheduler::cost(const Job &job) const
+{
+    auto fhistory(history_.find(job.generator->id()));
+    if (fhistory != history_.end()) { return fhistory->second; }
+    return job.generator->prepareCost();
+}
+
+bool PrepareScheduler::better(const Job &l, const Job &r) const
+{
+    // demanded resources first
+    const auto ld(l.generator->demand()), rd(r.generator->demand());
+    if (ld != rd) { return ld > rd; }
+
+    // then cheaper ones
+    const auto lc(cost(l)), rc(cost(r));
+    if (lc != rc) { return lc < rc; }
+
+    // and finally FIFO
+    return l.queued < r.queued;
+}
+
+Generator::pointer PrepareScheduler::pop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;) {
+        if (!running_) { return {}; }
+
+        auto best(pending_.end());
+        for (auto ipending(pending_.begin()), epending(pending_.end());
+             ipending != epending; ++ipending)
+        {
+            if (blocked(*ipending)) { continue; }
+            if ((best == epending) || better(*ipending, *best)) {
+                best = ipending;
+            }
+        }
+
+        if ((best == pending_.end()) && !pending_.empty() && active_.empty())
+        {
+            // all pending jobs wait for each other -> dependency cycle; just
+            // take the best one
+            for (auto ipending(pending_.begin()), epending(pending_.end());
+                 ipending != epending; ++ipending)
+            {
+                if ((best == epending) || better(*ipending, *best)) {
+                    best = ipending;
+                }
+            }
+            LOG(warn2)
+                << "Dependency cycle detected while scheduling prepare of <"
+                << best->generator->id() << ">.";
+        }
+
+        if (best != pending_.end()) {
+            best->started = Clock::now();
+            active_.splice(active_.end(), pending_, best);
+            const auto &job(active_.back());
+
+            LOG(info2)
+                << "Scheduled prepare of <" << job.generator->id()
+                << "> (demand: " << job.generator->demand()
+                << ", estimated cost: " << cost(job)
+                << " s, waited: " << seconds(job.started - job.queued)
+                << " s, pending: " << pending_.size() << ").";
+            return job.generator;
+        }
+
+        cond_.wait(lock);
+    }
+}
+
+void PrepareScheduler::done(const Generator::pointer &generator, bool success)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        auto factive(std::find_if(active_.begin(), active_.end()
+                                  , [&](const Job &job) {
+                                      return job.generator == generator;
+                                  }));
+        if (factive != active_.end()) {
+            const auto duration(seconds(Clock::now() - factive->started));
+
+            if (success) {
+                history_[generator->id()] = duration;
+                LOG(info3)
+                    << "Prepared <" << generator->id() << "> in "
+                    << duration << " s.";
+            } else {
+                LOG(info3)
+                    << "Prepare of <" << generator->id() << "> failed after "
+                    << duration << " s.";
+            }
+
+            active_.erase(factive);
+        }
+    }
+
+    // dependent jobs may be unblocked now
+    cond_.notify_all();
+}
+
+void PrepareScheduler::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_all();
+}
+
+void PrepareScheduler::stat(std::ostream &os) const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_.empty() && active_.empty()) { return; }
+
+    const auto now(Clock::now());
+
+    os << "prepare: " << active_.size() << " running, "
+       << pending_.size() << " pending\n";
+
+    for (const auto &job : active_) {
+        os << "    running <" << job.generator->id() << ">: "
+           << seconds(now - job.started) << " s";
+        const auto progress(job.generator->prepareProgress());
+        if (progress >= 0.0) {
+            os << ", " << int(100.0 * progress) << " %";
+        }
+        os << "\n";
+    }
+
+    for (const auto &job : pending_) {
+        os << "    pending <" << job.generator->id() << ">: "
+           << seconds(now - job.queued) << " s, demand "
+           << job.generator->demand() << ", estimated cost "
+           << cost(job) << " s"
+           << (blocked(job) ? ", waiting for dependencies" : "")
+           << "\n";
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef mapproxy_generator_preparescheduler_hpp_included_
+#define mapproxy_generator_preparescheduler_hpp_included_
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <condition_variable>
+
+#include <boost/noncopyable.hpp>
+
+#include "../generator.hpp"
+
+/** Schedules generators for prepare.
+ *
+ *  Pending generators are ordered by:
+ *      * dependencies: generator waits while any of its dependencies is
+ *        pending or being prepared (unless this would block everything, i.e.
+ *        there is a dependency cycle)
+ *      * client demand: resources already being asked for go first
+ *      * estimated cost: cheap resources go first; measured prepare
+ *        duration is used for resources prepared before
+ *      * order of arrival
+ */
+class PrepareScheduler : boost::noncopyable {
+public:
+    PrepareScheduler();
+
+    /** Queues generators for prepare. Whole batch is queued atomically so
+     *  no worker can pop a generator before its dependencies in the same
+     *  batch are queued.
+     */
+    void push(const Generator::list &generators);
+
+    /** Waits for next generator to prepare. Returns null pointer when
+     *  stopped.
+     */
+    Generator::pointer pop();
+
+    /** Marks generator obtained by pop() as finished.
+     */
+    void done(const Generator::pointer &generator, bool success);
+
+    /** Stops scheduler, wakes up all waiting workers.
+     */
+    void stop();
+
+    /** Prints pending and running prepares.
+     */
+    void stat(std::ostream &os) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Job {
+        Generator::pointer generator;
+        Generator::Dependencies dependencies;
+        Clock::time_point queued;
+        Clock::time_point started;
+
+        Job(const Generator::pointer &generator)
+            : generator(generator)
+            , dependencies(generator->dependencies())
+            , queued(Clock::now())
+        {}
+
+        typedef std::list<Job> list;
+    };
+
+    bool blocked(const Job &job) const;
+    double cost(const Job &job) const;
+    bool better(const Job &l, const Job &r) const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    bool running_;
+
+    Job::list pending_;
+    Job::list active_;
+
+    /** Measured prepare duration (in seconds) from previous prepares.
+     */
+    std::map<Resource::Id, double> history_;
+};
+
+#endif // mapproxy_generator_preparescheduler_hpp_included_
@@ -29,6 +29,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/logic/tribool_io.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <opencv2/highgui/highgui.hpp>
 
@@ -61,6 +62,8 @@
 #include "../error.hpp"
 #include "../support/metatile.hpp"
 #include "../support/mesh.hpp"
+#include "../support/rtin.hpp"
+#include "../support/heightgrid.hpp"
 #include "../support/srs.hpp"
 #include "../support/geo.hpp"
 #include "../support/grid.hpp"
@@ -131,6 +134,8 @@ void parseDefinition(SurfaceDem::Definition &def, const Json::Value &value)
         Json::get(*def.heightcodingAlias, value, "heightcodingAlias");
     }
 
+    Json::getOpt(def.simplifier, value, "simplifier");
+
     def.parse(value);
 }
 
@@ -150,6 +155,9 @@ void buildDefinition(Json::Value &value, const SurfaceDem::Definition &def)
     if (def.heightcodingAlias) {
         value["heightcodingAlias"] = *def.heightcodingAlias;
     }
+    if (def.simplifier != MeshSimplifier::decimation) {
+        value["simplifier"] = boost::lexical_cast<std::string>(def.simplifier);
+    }
 
     def.build(value);
 }
@@ -177,6 +185,17 @@ void parseDefinition(SurfaceDem::Definition &def
         def.heightcodingAlias = py2utf8(value["heightcodingAlias"]);
     }
 
+    if (value.has_key("simplifier")) {
+        try {
+            def.simplifier = boost::lexical_cast<MeshSimplifier>
+                (py2utf8(value["simplifier"]));
+        } catch (boost::bad_lexical_cast) {
+            utility::raise<Error>
+                ("Value stored in simplifier is not a valid mesh "
+                 "simplifier.");
+        }
+    }
+
     def.parse(value);
 }
 
@@ -216,6 +235,9 @@ Changed SurfaceDem::Definition::changed_impl(const DefinitionBase &o) const
     if (mask != other.mask) { return Changed::yes; }
     if (textureLayerId != other.textureLayerId) { return Changed::yes; }
 
+    // different simplifier produces different yet valid meshes
+    if (simplifier != other.simplifier) { return Changed::safely; }
+
     return SurfaceBase::SurfaceDefinition::changed_impl(o);
 }
 
@@ -288,7 +310,8 @@ void SurfaceDem::prepare_impl(Arsenal&)
 
         // open delivery index
         index_ = boost::in_place(referenceFrame().metaBinaryOrder
-                                 , deliveryIndexPath);
+                                 , deliveryIndexPath
+                                 , config().mmapOptions);
     }
 
     addToRegistry();
@@ -380,73 +403,47 @@ SurfaceDem::generateMetatileImpl(const vts::TileId &tileId
 
 namespace {
 
-inline bool validSample(double value)
-{
-    return (value >= -1e6);
-}
-
 class DemSampler {
 public:
     /** Samples point in dem. Dilates by one pixel if pixel is invalid.
      *
      *  Pixels masked by external mask are not valid (i.e. the mask must be
      *  dilated by 1 pixel beforehand)
+     *
+     *  Whole grid is prepared at once: holes are filled and height function is
+     *  applied in batch.
+     *
+     *  Warped raster is exclusively ours, therefore it is modified in place
+     *  (no copy out of shared memory); sampler keeps it alive.
      */
-    DemSampler(const cv::Mat &dem, const vts::NodeInfo::CoverageMask &mask
+    DemSampler(const GdalWarper::Raster &dem
+               , const vts::NodeInfo::CoverageMask &mask
                , const HeightFunction::pointer &heightFunction)
-        : dem_(dem), mask_(mask), heightFunction_(heightFunction)
-    {}
-
-    bool operator()(int i, int j, double &h) const {
-        // ignore masked-out pixels
-        if (!mask_.get(i, j)) { return false; }
-
-        h = dem_.at<double>(j, i);
-        if (validSample(h)) {
-            if (heightFunction_) { h = (*heightFunction_)(h); }
-            return true;
-        }
-
-        h = 0;
-        int count(0);
-
-        for (int jj(-1); jj <= +1; ++jj) {
-            for (int ii(-1); ii <= +1; ++ii) {
-                // ignore current point
-                if (!(ii || jj)) { continue; }
-
-                auto x(i + ii), y(j + jj);
-                // check bounds
-                if ((x < 0) || (x >= dem_.cols)
-                    || (y < 0) || (y >= dem_.rows))
-                    { continue; }
-
-                // ingore masked-out pixels
-                if (!mask_.get(x, y)) { continue; }
-
-                // sample pixel and use if valid
-                auto v(dem_.at<double>(y, x));
-                if (!validSample(v)) { continue; }
-
-                h += v;
-                ++count;
+        : raster_(dem), dem_(*dem), validity_(heightValidity(dem_))
+    {
+        HeightValidity m(dem_.rows, dem_.cols);
+        for (int j(0); j < dem_.rows; ++j) {
+            for (int i(0); i < dem_.cols; ++i) {
+                m(j, i) = mask.get(i, j);
             }
         }
 
-        if (!count) { return false; }
-        if (heightFunction_) {
-            h = (*heightFunction_)(h / count);
-        } else {
-            h = (h / count);
+        fillHeightHoles(dem_, validity_, &m);
+        if (heightFunction) {
+            (*heightFunction)(dem_.ptr<double>(), dem_.total());
         }
+    }
 
+    bool operator()(int i, int j, double &h) const {
+        if (!validity_(j, i)) { return false; }
+        h = dem_.at<double>(j, i);
         return true;
     }
 
 private:
+    GdalWarper::Raster raster_;
     cv::Mat dem_;
-    const vts::NodeInfo::CoverageMask &mask_;
-    const HeightFunction::pointer &heightFunction_;
+    HeightValidity validity_;
 };
 
 } // namespace
@@ -459,14 +456,17 @@ vts::Mesh SurfaceDem::generateMeshImpl(const vts::NodeInfo &nodeInfo
 {
     const int samplesPerSide(128);
     const TileFacesCalculator tileFacesCalculator;
+    const auto rtin(definition_.simplifier == MeshSimplifier::rtin);
 
     sink.checkAborted();
 
-    /** warp input dataset as a DEM, with optimized size
+    /** warp input dataset as a DEM, with optimized size; RTIN needs
+     *  power-of-two grid
      */
     auto dem(arsenal.warper.warp
              (GdalWarper::RasterRequest
-              (GdalWarper::RasterRequest::Operation::demOptimal
+              (rtin ? GdalWarper::RasterRequest::Operation::demOptimalPow2
+               : GdalWarper::RasterRequest::Operation::demOptimal
                , dem_.dataset
                , nodeInfo.srsDef(), nodeInfo.extents()
                , math::Size2(samplesPerSide, samplesPerSide))
@@ -481,18 +481,26 @@ vts::Mesh SurfaceDem::generateMeshImpl(const vts::NodeInfo &nodeInfo
     auto coverage(generateCoverage(dem->cols - 1, nodeInfo, maskTree_
                                    , vts::NodeInfo::CoverageType::grid));
 
-    DemSampler ds(*dem, coverage, definition_.heightFunction);
-
-    // generate mesh
-    auto meshInfo(meshFromNode(nodeInfo, size
-                               , [&](int i, int j, double &h) -> bool
+    DemSampler ds(dem, coverage, definition_.heightFunction);
+    const auto sampler([&](int i, int j, double &h) -> bool
     {
         return ds(i, j, h);
-    }));
-    auto &lm(std::get<0>(meshInfo));
+    });
 
-    // simplify
-    simplifyMesh(lm, nodeInfo, tileFacesCalculator, dem_.geoidGrid);
+    // generate (simplified) mesh
+    auto meshInfo([&]() -> std::tuple<geometry::Mesh, bool>
+    {
+        if (rtin && rtinCompatible(size)) {
+            return rtinMeshFromNode(nodeInfo, size, sampler
+                                    , tileFacesCalculator, dem_.geoidGrid);
+        }
+
+        auto meshInfo(meshFromNode(nodeInfo, size, sampler));
+        simplifyMesh(std::get<0>(meshInfo), nodeInfo, tileFacesCalculator
+                     , dem_.geoidGrid);
+        return meshInfo;
+    }());
+    auto &lm(std::get<0>(meshInfo));
 
     // and add skirt
     addSkirt(lm, nodeInfo);
@@ -583,7 +591,7 @@ void SurfaceDem::generateNavtile(const vts::TileId &tileId
     // set height range
     nt.heightRange(vts::NavTile::HeightRange
                    (std::floor(heightRange.min), std::ceil(heightRange.max)));
-    DemSampler ds(*dem, coverage, definition_.heightFunction);
+    DemSampler ds(dem, coverage, definition_.heightFunction);
 
     // calculate navtile values
     math::Size2f npx(ts.width / (ntd.cols - 1)
@@ -33,6 +33,7 @@
 #include "./surface.hpp"
 
 #include "../support/coverage.hpp"
+#include "../support/mesh.hpp"
 
 namespace vts = vtslibs::vts;
 namespace vr = vtslibs::registry;
@@ -50,8 +51,11 @@ public:
         boost::optional<boost::filesystem::path> mask;
         unsigned int textureLayerId;
         boost::optional<std::string> heightcodingAlias;
+        MeshSimplifier simplifier;
 
-        Definition() : textureLayerId() {}
+        Definition()
+            : textureLayerId(), simplifier(MeshSimplifier::decimation)
+        {}
 
     private:
         virtual void from_impl(const boost::any &value);
@@ -25,6 +25,9 @@
  */
 
 #include <new>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
@@ -182,9 +185,59 @@ Changed SurfaceSpheroid::Definition::changed_impl(const DefinitionBase &o)
     return SurfaceBase::SurfaceDefinition::changed_impl(o);
 }
 
+/** Fully covered tiles of the same LOD and row class (SDS and tile size) share
+ *  the same mesh in tile-local SDS coordinates; only the final conversion to
+ *  physical SRS differs. Number of distinct keys is bound by number of LODs
+ *  times number of reference frame subtrees, therefore there is no eviction.
+ */
+class SurfaceSpheroid::MeshTemplates {
+public:
+    typedef std::shared_ptr<const geometry::Mesh> Mesh;
+
+    /** Returns mesh template (including skirt) for given fully covered
+     *  node. Template is built on first use.
+     */
+    Mesh operator()(const vts::NodeInfo &nodeInfo, int samplesPerSide);
+
+private:
+    /** (LOD, SDS, tile width, tile height, samples per side)
+     */
+    typedef std::tuple<vts::Lod, std::string, double, double, int> Key;
+
+    std::mutex mutex_;
+    std::map<Key, Mesh> templates_;
+};
+
+SurfaceSpheroid::MeshTemplates::Mesh
+SurfaceSpheroid::MeshTemplates::operator()(const vts::NodeInfo &nodeInfo
+                                           , int samplesPerSide)
+{
+    const auto ts(math::size(nodeInfo.extents()));
+    const Key key(nodeInfo.nodeId().lod, nodeInfo.srs()
+                  , ts.width, ts.height, samplesPerSide);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto ftemplates(templates_.find(key));
+        if (ftemplates != templates_.end()) { return ftemplates->second; }
+    }
+
+    // build outside of lock; concurrent builds yield identical meshes and
+    // first one wins
+    auto meshInfo
+        (meshFromNode(nodeInfo, math::Size2(samplesPerSide, samplesPerSide)));
+    auto mesh(std::make_shared<geometry::Mesh>
+              (std::move(std::get<0>(meshInfo))));
+    addSkirt(*mesh, nodeInfo);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    return templates_.insert(Key(key), mesh).first->second;
+}
+
 SurfaceSpheroid::SurfaceSpheroid(const Params &params)
     : SurfaceBase(params)
     , definition_(resource().definition<Definition>())
+    , meshTemplates_(std::make_shared<MeshTemplates>())
 {
     loadFiles(definition_);
 }
@@ -258,6 +311,10 @@ void SurfaceSpheroid::prepare_impl(Arsenal&)
                 ti.set(lod, block.view, flags);
             }
         }
+
+        // tile index build takes most of the time
+        prepareProgress(0.9 * (lod - r.lodRange.min + 1)
+                        / (r.lodRange.max - r.lodRange.min + 1.0));
     }
 
     // save it all
@@ -272,7 +329,8 @@ void SurfaceSpheroid::prepare_impl(Arsenal&)
     fs::rename(tmpPath, deliveryIndexPath);
 
     index_ = boost::in_place(referenceFrame().metaBinaryOrder
-                             , deliveryIndexPath);
+                             , deliveryIndexPath
+                             , config().mmapOptions);
 }
 
 vts::MapConfig SurfaceSpheroid::mapConfig_impl(ResourceRoot root) const
@@ -327,6 +385,45 @@ inline MetaFlag::value_type ti2metaFlags(TiFlag::value_type ti)
  */
 const int metatileSamplesPerTile(8);
 
+/** Samples navigation height at grid of given tile extents (row 0 is the top
+ *  row). This is the only place where spheroid heights are computed so
+ *  metatile height ranges and navtile data always agree.
+ */
+template <typename Valid, typename Store>
+void sampleNavHeights(const math::Extents2 &extents, const math::Size2 &edges
+                      , const vts::CsConvertor &navConv
+                      , const Valid &valid, const Store &store)
+{
+    const auto ts(math::size(extents));
+    const math::Size2f px(ts.width / edges.width, ts.height / edges.height);
+
+    for (int j(0); j <= edges.height; ++j) {
+        auto y(extents.ur(1) - j * px.height);
+        for (int i(0); i <= edges.width; ++i) {
+            if (!valid(i, j)) { continue; }
+            store(i, j, navConv
+                  (math::Point3(extents.ll(0) + i * px.width, y, 0.0))(2));
+        }
+    }
+}
+
+/** Height range of tile computed from metatile grid.
+ */
+template <typename Valid>
+vs::Range<double> navHeightRange(const math::Extents2 &extents
+                                 , const vts::CsConvertor &navConv
+                                 , const Valid &valid)
+{
+    auto heightRange(vs::Range<double>::emptyRange());
+    sampleNavHeights(extents, math::Size2(metatileSamplesPerTile
+                                          , metatileSamplesPerTile)
+                     , navConv, valid, [&](int, int, double z)
+    {
+        update(heightRange, z);
+    });
+    return heightRange;
+}
+
 } // namespace
 
 void SurfaceSpheroid::generateMetatile(const vts::TileId &tileId
@@ -353,6 +450,11 @@ void SurfaceSpheroid::generateMetatile(const vts::TileId &tileId
 
     vts::MetaTile metatile(tileId, rf.metaBinaryOrder);
 
+    // fetch tile index flags for whole metatile at once (tileId is metatile
+    // origin, checked by metatileBlocks)
+    std::vector<mmapped::TileIndex::value_type> tileFlags;
+    index_->tileIndex.range(tileId, rf.metaBinaryOrder, tileFlags);
+
     auto setChildren([&](const MetatileBlock &block, const vts::TileId &nodeId
                          , vts::MetaNode &node) -> void
     {
@@ -446,12 +548,14 @@ void SurfaceSpheroid::generateMetatile(const vts::TileId &tileId
 
                 // build metanode
                 vts::MetaNode node;
-                node.flags(ti2metaFlags(index_->tileIndex.get(nodeId)));
+                node.flags(ti2metaFlags
+                           (tileFlags[((nodeId.y - tileId.y)
+                                       << rf.metaBinaryOrder)
+                                      + (nodeId.x - tileId.x)]));
                 bool geometry(node.geometry());
                 bool navtile(node.navtile());
 
-                // compute tile extents and height range
-                auto heightRange(vs::Range<double>::emptyRange());
+                // compute tile extents
                 math::Extents3 te(math::InvalidExtents{});
                 double area(0);
                 int triangleCount(0);
@@ -488,18 +592,25 @@ void SurfaceSpheroid::generateMetatile(const vts::TileId &tileId
                             area += std::get<0>(qa);
                             triangleCount += std::get<1>(qa);
                         }
-
-                        if (p && navtile) {
-                            // sample height in navtile
-                            auto z(navConv
-                                   (math::Point3
-                                    (extents.ll(0) + xx * gts.width
-                                     , yy, 0.0))(2));
-                            update(heightRange, z);
-                        }
                     }
                 }
 
+                // height range (same path as in navtile generation)
+                auto heightRange(vs::Range<double>::emptyRange());
+                if (navtile) {
+                    const math::Extents2 ne
+                        (extents.ll(0) + i * ts.width
+                         , extents.ur(1) - (j + 1) * ts.height
+                         , extents.ll(0) + (i + 1) * ts.width
+                         , extents.ur(1) - j * ts.height);
+                    heightRange = navHeightRange
+                        (ne, navConv, [&](int ii, int jj)
+                    {
+                        return grid(mask, i * metatileSamplesPerTile + ii
+                                    , j * metatileSamplesPerTile + jj);
+                    });
+                }
+
                 setChildren(block, nodeId, node);
 
                 if (geometry && !area) {
@@ -574,35 +685,40 @@ vts::Mesh SurfaceSpheroid::generateMeshImpl(const vts::NodeInfo &nodeInfo
 {
     // TODO: calculate tile sampling
     const int samplesPerSide(10);
-    //const TileFacesCalculator tileFacesCalculator;
 
     sink.checkAborted();
 
-    // generate mesh
+    auto build([&](const geometry::Mesh &lm, bool fullyCovered) -> vts::Mesh
+    {
+        // generate VTS mesh
+        vts::Mesh mesh(false);
+        auto &sm(addSubMesh(mesh, lm, nodeInfo, definition_.geoidGrid));
+        if (definition_.textureLayerId) {
+            sm.textureLayer = definition_.textureLayerId;
+        }
+
+        if (withMask) {
+            // asked to generate coverage mask
+            meshCoverageMask(mesh.coverageMask, lm, nodeInfo, fullyCovered);
+        }
+        return mesh;
+    });
+
+    if (!nodeInfo.partial()) {
+        // fully covered tile: just convert template to physical SRS
+        return build(*(*meshTemplates_)(nodeInfo, samplesPerSide), true);
+    }
+
+    // partial tile: mesh depends on node's coverage, generate from scratch
     auto meshInfo
         (meshFromNode
          (nodeInfo, math::Size2(samplesPerSide, samplesPerSide)));
     auto &lm(std::get<0>(meshInfo));
 
-    // simplify
-    //simplifyMesh(lm, nodeInfo, tileFacesCalculator);
-
-    // and add skirt
+    // add skirt
     addSkirt(lm, nodeInfo);
 
-    // generate VTS mesh
-    vts::Mesh mesh(false);
-    auto &sm(addSubMesh(mesh, lm, nodeInfo, definition_.geoidGrid));
-    if (definition_.textureLayerId) {
-        sm.textureLayer = definition_.textureLayerId;
-    }
-
-    if (withMask) {
-        // asked to generate coverage mask
-        meshCoverageMask
-            (mesh.coverageMask, lm, nodeInfo, std::get<1>(meshInfo));
-    }
-    return mesh;
+    return build(lm, std::get<1>(meshInfo));
 }
 
 void SurfaceSpheroid::generateNavtile(const vts::TileId &tileId
@@ -627,7 +743,6 @@ void SurfaceSpheroid::generateNavtile(const vts::TileId &tileId
     }
 
     const auto &extents(nodeInfo.extents());
-    const auto ts(math::size(extents));
 
     // sds -> navigation SRS convertor
     auto navConv(sds2nav(nodeInfo, definition_.geoidGrid));
@@ -635,25 +750,15 @@ void SurfaceSpheroid::generateNavtile(const vts::TileId &tileId
     // first, calculate height range in the same way as is done in metatile
     auto heightRange(vs::Range<double>::emptyRange());
     {
-        // create node doverage
+        // create node coverage
         const auto coverage(nodeInfo.coverageMask
                             (vts::NodeInfo::CoverageType::grid
                              , math::Size2(metatileSamplesPerTile + 1
                                            , metatileSamplesPerTile + 1), 1));
-        // grid pixel size
-        math::Size2f gpx
-            (ts.width / (metatileSamplesPerTile + 1)
-             , ts.height / (metatileSamplesPerTile + 1));
-        for (int j(0); j <= metatileSamplesPerTile; ++j) {
-            auto y(extents.ll(1) + j * gpx.height);
-            for (int i(0); i <= metatileSamplesPerTile; ++i) {
-                if (!coverage.get(i, j)) { continue; }
-                auto z(navConv
-                   (math::Point3
-                    (extents.ll(0) + i * gpx.width, y, 0.0))(2));
-                update(heightRange, z);
-            }
-        }
+        heightRange = navHeightRange(extents, navConv, [&](int i, int j)
+        {
+            return coverage.get(i, j);
+        });
     }
 
     // calculate navtile values
@@ -667,20 +772,15 @@ void SurfaceSpheroid::generateNavtile(const vts::TileId &tileId
     // set height range
     nt.heightRange(vts::NavTile::HeightRange
                    (std::floor(heightRange.min), std::ceil(heightRange.max)));
-    math::Size2f npx(ts.width / (ntd.cols - 1)
-                     , ts.height / (ntd.rows - 1));
-    for (int j(0); j < ntd.rows; ++j) {
-        auto y(extents.ll(1) + j * npx.height);
-        for (int i(0); i < ntd.cols; ++i) {
-            // mask with node's mask
-            if (!coverage.get(i, j)) { continue; }
-            auto z(navConv
-                   (math::Point3
-                    (extents.ll(0) + i * npx.width, y, 0.0))(2));
-            // write
-            ntd.at<vts::opencv::NavTile::DataType>(j, i) = z;
-        }
-    }
+    sampleNavHeights(extents, math::Size2(ntd.cols - 1, ntd.rows - 1)
+                     , navConv, [&](int i, int j)
+    {
+        // mask with node's mask
+        return coverage.get(i, j);
+    }, [&](int i, int j, double z)
+    {
+        ntd.at<vts::opencv::NavTile::DataType>(j, i) = z;
+    });
 
     // done
     std::ostringstream os;
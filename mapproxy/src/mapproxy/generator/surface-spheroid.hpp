@@ -27,6 +27,8 @@
 #ifndef mapproxy_generator_surface_spheroid_hpp_included_
 #define mapproxy_generator_surface_spheroid_hpp_included_
 
+#include <memory>
+
 #include "vts-libs/vts/tileset/tilesetindex.hpp"
 #include "vts-libs/vts/tileset/properties.hpp"
 
@@ -73,6 +75,12 @@ private:
                                  , Arsenal &arsenal) const;
 
     const Definition &definition_;
+
+    /** Cache of normalized (tile-local) meshes shared by all fully covered
+     *  tiles of the same shape.
+     */
+    class MeshTemplates;
+    std::shared_ptr<MeshTemplates> meshTemplates_;
 };
 
 } // namespace generator
@@ -275,7 +275,8 @@ bool SurfaceBase::loadFiles(const SurfaceDefinition &definition)
 
             // load delivery index
             index_ = boost::in_place(referenceFrame().metaBinaryOrder
-                                     , deliveryIndexPath);
+                                     , deliveryIndexPath
+                                     , config().mmapOptions);
             makeReady();
             return true;
         }
@@ -315,6 +316,29 @@ bool SurfaceBase::updateProperties(const SurfaceDefinition &def)
     return changed;
 }
 
+void SurfaceBase::stat_impl(std::ostream &os) const
+{
+    if (!ready() || !index_) { return; }
+
+    os << "    tile index: " << index_->tileIndex.resident() << " of "
+       << index_->tileIndex.size() << " bytes resident\n";
+}
+
+Generator::Dependencies SurfaceBase::dependencies_impl() const
+{
+    const auto &introspection
+        (resource().definition<SurfaceDefinition>().introspection);
+
+    Dependencies dependencies;
+    for (const auto &rid : introspection.tms) {
+        dependencies.emplace_back(Resource::Generator::Type::tms, rid);
+    }
+    for (const auto &rid : introspection.geodata) {
+        dependencies.emplace_back(Resource::Generator::Type::geodata, rid);
+    }
+    return dependencies;
+}
+
 Generator::Task SurfaceBase
 ::generateFile_impl(const FileInfo &fileInfo, Sink &sink) const
 {
@@ -325,28 +349,26 @@ Generator::Task SurfaceBase
         sink.error(utility::makeError<NotFound>("Unrecognized filename."));
         break;
 
-    case SurfaceFileInfo::Type::definition: {
-        auto fl(vts::freeLayer
-                (vts::meshTilesConfig
-                 (properties_, vts::ExtraTileSetProperties()
-                  , prependRoot(fs::path(), resource(), ResourceRoot::none))));
-
-        std::ostringstream os;
-        vr::saveFreeLayer(os, fl);
-        sink.content(os.str(), fi.sinkFileInfo());
+    case SurfaceFileInfo::Type::definition:
+        sendConfig(sink, fi.sinkFileInfo(), "freelayer.json"
+                   , ResourceRoot::none, [&](std::ostream &os)
+        {
+            auto fl(vts::freeLayer
+                    (vts::meshTilesConfig
+                     (properties_, vts::ExtraTileSetProperties()
+                      , prependRoot(fs::path(), resource()
+                                    , ResourceRoot::none))));
+            vr::saveFreeLayer(os, fl);
+        });
         break;
-    }
 
     case SurfaceFileInfo::Type::file: {
         switch (fi.fileType) {
         case vts::File::config: {
             switch (fi.flavor) {
-            case vts::FileFlavor::regular: {
-                std::ostringstream os;
-                mapConfig(os, ResourceRoot::none);
-                sink.content(os.str(), fi.sinkFileInfo());
+            case vts::FileFlavor::regular:
+                sendMapConfig(sink, fi.sinkFileInfo(), ResourceRoot::none);
                 break;
-            }
 
             case vts::FileFlavor::raw:
                 sink.content(vs::fileIStream
@@ -503,7 +525,7 @@ void SurfaceBase::generateMesh(const vts::TileId &tileId
         vts::saveMeshProper(os, mesh);
         if (vs::gzipped(os)) {
             // gzip -> mesh
-            sfi.addHeader("Content-Encoding", "gzip");
+            sfi.setContentEncoding(ContentEncoding::gzip);
         }
     }
 
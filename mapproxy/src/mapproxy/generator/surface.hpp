@@ -87,6 +87,14 @@ private:
     virtual Task generateFile_impl(const FileInfo &fileInfo
                                    , Sink &sink) const;
 
+    virtual void stat_impl(std::ostream &os) const;
+
+    virtual Dependencies dependencies_impl() const;
+
+    /** Tile index is built from scratch.
+     */
+    virtual double prepareCost_impl() const { return 10.0; }
+
     virtual void generateMetatile(const vts::TileId &tileId
                                   , Sink &sink
                                   , const SurfaceFileInfo &fileInfo
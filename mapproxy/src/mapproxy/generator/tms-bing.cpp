@@ -280,12 +280,9 @@ Generator::Task TmsBing::generateFile_impl(const FileInfo &fileInfo
         sink.error(utility::makeError<NotFound>("Unrecognized filename."));
         break;
 
-    case TmsFileInfo::Type::config: {
-        std::ostringstream os;
-        mapConfig(os, ResourceRoot::none);
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::config:
+        sendMapConfig(sink, fi.sinkFileInfo(), ResourceRoot::none);
         break;
-    }
 
     case TmsFileInfo::Type::definition:
         return [this, fi](Sink &sink, Arsenal &arsenal) {
@@ -185,10 +185,79 @@ TmsRasterPatchwork::TmsRasterPatchwork(const Params &params)
     LOG(info1) << "Generator for <" << id() << "> not ready.";
 }
 
+namespace {
+
+std::shared_ptr<const std::string> encode(const cv::Mat &image
+                                          , RasterFormat format)
+{
+    std::vector<unsigned char> buf;
+    switch (format) {
+    case RasterFormat::jpg:
+        cv::imencode(".jpg", image, buf
+                     , { cv::IMWRITE_JPEG_QUALITY, 75 });
+        break;
+
+    case RasterFormat::png:
+        cv::imencode(".png", image, buf
+                     , { cv::IMWRITE_PNG_COMPRESSION, 9 });
+        break;
+    }
+
+    return std::make_shared<std::string>(buf.begin(), buf.end());
+}
+
+/** Color index of given tile. There is only 254 of them, therefore all
+ *  possible patches are generated up front.
+ */
+int colorIndex(const vts::TileId &tileId)
+{
+    unsigned long long int index(tileId.y);
+    index <<= tileId.lod;
+    index += tileId.x;
+    // skip black
+    return 1 + (index % 254);
+}
+
+cv::Mat_<cv::Vec3b> patch(int colorIndex)
+{
+    cv::Mat_<cv::Vec3b> tile(vr::BoundLayer::tileHeight
+                             , vr::BoundLayer::tileWidth);
+
+    const cv::Vec3b color(vts::opencv::palette256vec[colorIndex]);
+    const cv::Vec3b darkColor(color[0] * 0.8, color[1] * 0.8, color[2] * 0.8);
+    cv::Vec3b colors[2] = { color, darkColor };
+
+    for (int j(0); j < vr::BoundLayer::tileHeight; ++j) {
+        for (int i(0); i < vr::BoundLayer::tileWidth; ++i) {
+            tile(j, i) = colors[((j >> 3) + (i >> 3)) & 1];
+        }
+    }
+
+    return tile;
+}
+
+} // namespace
+
 void TmsRasterPatchwork::prepare_impl(Arsenal&)
 {
     LOG(info2) << "Preparing <" << id() << ">.";
 
+    // pre-render all patches in configured format
+    patches_.assign(255, Data());
+    for (int ci(1); ci < 255; ++ci) {
+        patches_[ci] = encode(patch(ci), definition_.format);
+    }
+
+    // and both possible constant masks
+    fullMask_ = encode(cv::Mat_<std::uint8_t>
+                       (vr::BoundLayer::tileHeight
+                        , vr::BoundLayer::tileWidth, 255)
+                       , RasterFormat::png);
+    emptyMask_ = encode(cv::Mat_<std::uint8_t>
+                        (vr::BoundLayer::tileHeight
+                         , vr::BoundLayer::tileWidth, std::uint8_t(0))
+                        , RasterFormat::png);
+
     // try to open datasets
     if (definition_.mask) {
         geo::GeoDataset::open(absoluteDataset(*definition_.mask));
@@ -290,19 +359,17 @@ Generator::Task TmsRasterPatchwork::generateFile_impl(const FileInfo &fileInfo
         sink.error(utility::makeError<NotFound>("Unrecognized filename."));
         break;
 
-    case TmsFileInfo::Type::config: {
-        std::ostringstream os;
-        mapConfig(os, ResourceRoot::none);
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::config:
+        sendMapConfig(sink, fi.sinkFileInfo(), ResourceRoot::none);
         break;
-    };
 
-    case TmsFileInfo::Type::definition: {
-        std::ostringstream os;
-        vr::saveBoundLayer(os, boundLayer(ResourceRoot::none));
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::definition:
+        sendConfig(sink, fi.sinkFileInfo(), "boundlayer.json"
+                   , ResourceRoot::none, [&](std::ostream &os)
+        {
+            vr::saveBoundLayer(os, boundLayer(ResourceRoot::none));
+        });
         break;
-    }
 
     case TmsFileInfo::Type::support:
         sink.content(fi.support->data, fi.support->size
@@ -355,41 +422,8 @@ void TmsRasterPatchwork::generateTileImage(const vts::TileId &tileId
         return;
     }
 
-    unsigned long long int colorIndex(tileId.y);
-    colorIndex <<= tileId.lod;
-    colorIndex += tileId.x;
-    // skip black
-    colorIndex = 1 + (colorIndex % 254);
-
-    cv::Mat_<cv::Vec3b> tile(vr::BoundLayer::tileHeight
-                             , vr::BoundLayer::tileWidth);
-
-    const cv::Vec3b color(vts::opencv::palette256vec[colorIndex]);
-    const cv::Vec3b darkColor(color[0] * 0.8, color[1] * 0.8, color[2] * 0.8);
-    cv::Vec3b colors[2] = { color, darkColor };
-
-    for (int j(0); j < vr::BoundLayer::tileHeight; ++j) {
-        for (int i(0); i < vr::BoundLayer::tileWidth; ++i) {
-            tile(j, i) = colors[((j >> 3) + (i >> 3)) & 1];
-        }
-    }
-
-    // serialize
-    std::vector<unsigned char> buf;
-    switch (fi.format) {
-    case RasterFormat::jpg:
-        // TODO: configurable quality
-        cv::imencode(".jpg", tile, buf
-                     , { cv::IMWRITE_JPEG_QUALITY, 75 });
-        break;
-
-    case RasterFormat::png:
-        cv::imencode(".png", tile, buf
-                     , { cv::IMWRITE_PNG_COMPRESSION, 9 });
-        break;
-    }
-
-    sink.content(buf, fi.sinkFileInfo());
+    // serve pre-rendered patch
+    sink.content(patches_[colorIndex(tileId)], fi.sinkFileInfo());
 }
 
 void TmsRasterPatchwork::generateTileMask(const vts::TileId &tileId
@@ -412,20 +446,32 @@ void TmsRasterPatchwork::generateTileMask(const vts::TileId &tileId
     }
 
     if (!definition_.mask) {
-        cv::Mat_<std::uint8_t> mask(vr::BoundLayer::tileHeight
-                                    , vr::BoundLayer::tileWidth, 255);
+        sink.content(fullMask_, fi.sinkFileInfo());
+        return;
+    }
 
-        // serialize
-        std::vector<unsigned char> buf;
-        // write as png file
-        cv::imencode(".png", mask, buf
-                     , { cv::IMWRITE_PNG_COMPRESSION, 9 });
+    // probe mask coverage first: single pixel detail mask tells whether the
+    // tile is fully covered (white), uncovered (black) or partial (gray)
+    auto probe(arsenal.warper.warp
+               (GdalWarper::RasterRequest
+                (GdalWarper::RasterRequest::Operation::detailMask
+                 , absoluteDataset(*definition_.mask)
+                 , nodeInfo.srsDef()
+                 , nodeInfo.extents()
+                 , math::Size2(1, 1))
+                , sink));
+    sink.checkAborted();
 
-        // reset max age received from dataset if mask is uded
-        sink.content(buf, fi.sinkFileInfo());
+    const auto coverage(probe->at<double>(0, 0));
+    if (coverage >= 255) {
+        sink.content(fullMask_, fi.sinkFileInfo());
+        return;
+    } else if (!coverage) {
+        sink.content(emptyMask_, fi.sinkFileInfo());
         return;
     }
 
+    // partial tile, warp full mask
     auto mask(arsenal.warper.warp
               (GdalWarper::RasterRequest
                (GdalWarper::RasterRequest::Operation::mask
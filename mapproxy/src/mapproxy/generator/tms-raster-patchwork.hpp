@@ -73,9 +73,20 @@ private:
 
     bool hasMask() const;
 
+    typedef std::shared_ptr<const std::string> Data;
+
     const Definition &definition_;
 
     bool hasMetatiles_;
+
+    /** Encoded patch images, indexed by color index. Computed in prepare.
+     */
+    std::vector<Data> patches_;
+
+    /** Encoded full and empty masks. Computed in prepare.
+     */
+    Data fullMask_;
+    Data emptyMask_;
 };
 
 } // namespace generator
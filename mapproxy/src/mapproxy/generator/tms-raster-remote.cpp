@@ -26,6 +26,7 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <opencv2/highgui/highgui.hpp>
 
@@ -91,6 +92,17 @@ void parseDefinition(TmsRasterRemote::Definition &def
         Json::get(s, value, "mask");
         def.mask = s;;
     }
+
+    Json::getOpt(def.proxy, value, "proxy");
+    if (value.isMember("format")) {
+        Json::get(s, value, "format");
+        try {
+            def.format = boost::lexical_cast<RasterFormat>(s);
+        } catch (boost::bad_lexical_cast) {
+            utility::raise<Json::Error>
+                ("Value stored in format is not RasterFormat value");
+        }
+    }
 }
 
 void buildDefinition(Json::Value &value
@@ -100,6 +112,10 @@ void buildDefinition(Json::Value &value
     if (def.mask) {
         value["mask"] = def.mask->string();
     }
+    if (def.proxy) {
+        value["proxy"] = def.proxy;
+        value["format"] = boost::lexical_cast<std::string>(def.format);
+    }
 }
 
 void parseDefinition(TmsRasterRemote::Definition &def
@@ -110,6 +126,20 @@ void parseDefinition(TmsRasterRemote::Definition &def
     if (value.has_key("mask")) {
         def.mask = py2utf8(value["mask"]);
     }
+
+    if (value.has_key("proxy")) {
+        def.proxy = boost::python::extract<bool>(value["proxy"]);
+    }
+
+    if (value.has_key("format")) {
+        try {
+            def.format = boost::lexical_cast<RasterFormat>
+                (py2utf8(value["format"]));
+        } catch (boost::bad_lexical_cast) {
+            utility::raise<Error>
+                ("Value stored in format is not a RasterFormat value");
+        }
+    }
 }
 
 } // namespace
@@ -147,6 +177,8 @@ Changed TmsRasterRemote::Definition::changed_impl(const DefinitionBase &o)
 
     if (remoteUrl != other.remoteUrl) { return Changed::yes; }
     if (mask != other.mask) { return Changed::yes; }
+    if (proxy != other.proxy) { return Changed::yes; }
+    if (proxy && (format != other.format)) { return Changed::yes; }
 
     return Changed::no;
 }
@@ -156,6 +188,7 @@ TmsRasterRemote::TmsRasterRemote(const Params &params)
     , definition_(resource().definition<Definition>())
     , hasMetatiles_(false)
     , maskTree_(ignoreNonexistent(absoluteDatasetRf(definition_.mask)))
+    , remoteUrl_(definition_.remoteUrl)
 {
     LOG(info1) << "Generator for <" << id() << "> not ready.";
 }
@@ -186,7 +219,15 @@ vr::BoundLayer TmsRasterRemote::boundLayer(ResourceRoot root) const
     bl.type = vr::BoundLayer::Type::raster;
 
     // build url
-    bl.url = definition_.remoteUrl;
+    if (definition_.proxy) {
+        // tiles are served by us
+        bl.url = prependRoot
+            (utility::format("{lod}-{x}-{y}.%s%s", definition_.format
+                             , RevisionWrapper(res.revision, "?"))
+             , resource(), root);
+    } else {
+        bl.url = definition_.remoteUrl;
+    }
     bl.maskUrl = prependRoot
         (utility::format("{lod}-{x}-{y}.mask%s"
                          , RevisionWrapper(res.revision, "?"))
@@ -273,19 +314,17 @@ Generator::Task TmsRasterRemote::generateFile_impl(const FileInfo &fileInfo
         sink.error(utility::makeError<NotFound>("Unrecognized filename."));
         break;
 
-    case TmsFileInfo::Type::config: {
-        std::ostringstream os;
-        mapConfig(os, ResourceRoot::none);
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::config:
+        sendMapConfig(sink, fi.sinkFileInfo(), ResourceRoot::none);
         break;
-    }
 
-    case TmsFileInfo::Type::definition: {
-        std::ostringstream os;
-        vr::saveBoundLayer(os, boundLayer(ResourceRoot::none));
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::definition:
+        sendConfig(sink, fi.sinkFileInfo(), "boundlayer.json"
+                   , ResourceRoot::none, [&](std::ostream &os)
+        {
+            vr::saveBoundLayer(os, boundLayer(ResourceRoot::none));
+        });
         break;
-    }
 
     case TmsFileInfo::Type::support:
         sink.content(fi.support->data, fi.support->size
@@ -293,9 +332,15 @@ Generator::Task TmsRasterRemote::generateFile_impl(const FileInfo &fileInfo
         break;
 
     case TmsFileInfo::Type::image: {
-        sink.error(utility::makeError<NotFound>
-                    ("Remote tms driver is unable to generate any image."));
-        return {};
+        if (!definition_.proxy) {
+            sink.error(utility::makeError<NotFound>
+                       ("Remote tms driver is unable to generate any image."));
+            return {};
+        }
+
+        return [=](Sink &sink, Arsenal &arsenal) {
+            generateTileImage(fi.tileId, fi, sink, arsenal);
+        };
     }
 
     case TmsFileInfo::Type::mask:
@@ -516,4 +561,58 @@ void TmsRasterRemote::generateMetatileFromTree(const vts::TileId &tileId
     sink.content(buf, fi.sinkFileInfo());
 }
 
+void TmsRasterRemote::generateTileImage(const vts::TileId &tileId
+                                        , const TmsFileInfo &fi
+                                        , Sink &sink
+                                        , Arsenal &arsenal) const
+{
+    sink.checkAborted();
+
+    vts::NodeInfo nodeInfo(referenceFrame(), tileId);
+    if (!nodeInfo.valid()) {
+        sink.error(utility::makeError<NotFound>
+                    ("TileId outside of valid reference frame tree."));
+        return;
+    }
+
+    if (!nodeInfo.productive()) {
+        sink.error(utility::makeError<EmptyImage>("No valid data."));
+        return;
+    }
+
+    // do not bother upstream with tiles fully masked out by mask tree (mask
+    // dataset would need a warp, that is left to the client's mask request)
+    if (maskTree_ && !countNonZero(boundlayerMask(tileId, maskTree_))) {
+        sink.error(utility::makeError<EmptyImage>("No valid data."));
+        return;
+    }
+
+    const auto url(remoteUrl_(vts::UrlTemplate::Vars
+                              (tileId, vts::local(nodeInfo.rootLod(), tileId))));
+
+    // fetch (possibly cached) upstream tile; sink must outlive this call
+    auto sinkFileInfo(fi.sinkFileInfo());
+    arsenal.upstream.fetch(url, [sink, sinkFileInfo]
+                           (const UpstreamFetcher::Response::pointer &response
+                            , const std::exception_ptr &error) mutable
+    {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (...) {
+                sink.error();
+            }
+            return;
+        }
+
+        // propagate upstream content type and remaining max age
+        auto sfi(sinkFileInfo);
+        if (!response->contentType.empty()) {
+            sfi.contentType = response->contentType;
+        }
+        sfi.setMaxAge(response->maxAge());
+        sink.content(response->data, sfi);
+    });
+}
+
 } // namespace generator
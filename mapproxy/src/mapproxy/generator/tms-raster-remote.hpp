@@ -27,6 +27,8 @@
 #ifndef mapproxy_generator_tms_raster_remote_hpp_included_
 #define mapproxy_generator_tms_raster_remote_hpp_included_
 
+#include "vts-libs/vts/urltemplate.hpp"
+
 #include "../support/coverage.hpp"
 #include "../generator.hpp"
 
@@ -40,7 +42,16 @@ public:
         std::string remoteUrl;
         boost::optional<boost::filesystem::path> mask;
 
-        Definition() {}
+        /** Serve tiles through mapproxy (i.e. fetch and cache upstream tiles)
+         *  instead of letting clients fetch them from remote URL.
+         */
+        bool proxy;
+
+        /** Format of proxied tiles, used only in local URL.
+         */
+        RasterFormat format;
+
+        Definition() : proxy(false), format(RasterFormat::jpg) {}
 
     private:
         virtual void from_impl(const boost::any &value);
@@ -56,6 +67,10 @@ private:
     virtual Task generateFile_impl(const FileInfo &fileInfo
                                    , Sink &sink) const;
 
+    /** Proxied tiles can change upstream.
+     */
+    virtual bool stableContent_impl() const { return !definition_.proxy; }
+
     void generateTileMask(const vts::TileId &tileId
                           , const TmsFileInfo &fi
                           , Sink &sink
@@ -76,6 +91,11 @@ private:
                                   , Sink &sink
                                   , Arsenal &arsenal) const;
 
+    void generateTileImage(const vts::TileId &tileId
+                           , const TmsFileInfo &fi
+                           , Sink &sink
+                           , Arsenal &arsenal) const;
+
     vr::BoundLayer boundLayer(ResourceRoot root) const;
 
     const Definition &definition_;
@@ -88,6 +108,10 @@ private:
     /** Mask dataset path. Only when defined and not a RF tree.
      */
     boost::optional<std::string> maskDataset_;
+
+    /** Remote URL template, used in proxy mode.
+     */
+    vts::UrlTemplate remoteUrl_;
 };
 
 } // namespace generator
@@ -169,6 +169,18 @@ void parseDefinition(TmsRaster::Definition &def
     }
 }
 
+Json::Value fileStamp(const fs::path &path)
+{
+    // NB: missing file or directory yields -1
+    boost::system::error_code ec;
+    Json::Value stamp(Json::objectValue);
+    stamp["mtime"] = Json::Int64(fs::last_write_time(path, ec));
+    if (ec) { stamp["mtime"] = -1; }
+    stamp["size"] = Json::Int64(fs::file_size(path, ec));
+    if (ec) { stamp["size"] = -1; }
+    return stamp;
+}
+
 } // namespace
 
 void TmsRaster::Definition::from_impl(const boost::any &value)
@@ -245,7 +257,7 @@ TmsRaster::TmsRaster(const Params &params)
     }
 
     if (fs::exists(deliveryIndexPath)) {
-        index_ = boost::in_place(deliveryIndexPath);
+        index_ = boost::in_place(deliveryIndexPath, config().mmapOptions);
     }
 
     if (index_) {
@@ -299,7 +311,7 @@ void TmsRaster::prepare_impl(Arsenal&)
         const auto tmpPath(utility::addExtension(deliveryIndexPath, ".tmp"));
         mmapped::TileIndex::write(tmpPath, index);
         fs::rename(tmpPath, deliveryIndexPath);
-        index_ = boost::in_place(deliveryIndexPath);
+        index_ = boost::in_place(deliveryIndexPath, config().mmapOptions);
 
         // done
         makeReady();
@@ -322,7 +334,7 @@ void TmsRaster::prepare_impl(Arsenal&)
         // store and open
         const auto deliveryIndexPath(root() / "delivery.index");
         mmapped::TileIndex::write(deliveryIndexPath, index);
-        index_ = boost::in_place(deliveryIndexPath);
+        index_ = boost::in_place(deliveryIndexPath, config().mmapOptions);
     } else if (definition_.mask) {
         maskDataset_ = definition_.mask;
         geo::GeoDataset::open(absoluteDataset(*maskDataset_));
@@ -408,6 +420,60 @@ vts::MapConfig TmsRaster::mapConfig_impl(ResourceRoot root)
     return mapConfig;
 }
 
+void TmsRaster::stat_impl(std::ostream &os) const
+{
+    if (!ready() || !index_) { return; }
+
+    os << "    tile index: " << index_->resident() << " of "
+       << index_->size() << " bytes resident\n";
+}
+
+bool TmsRaster::savePrepared_impl(Json::Value &state) const
+{
+    // delivery index is reopened directly in constructor
+    if (index_) { return false; }
+
+    state["hasMetatiles"] = hasMetatiles_;
+    if (maskDataset_) { state["maskDataset"] = *maskDataset_; }
+    state["datasets"] = datasetStamp();
+    return true;
+}
+
+bool TmsRaster::loadPrepared_impl(const Json::Value &state)
+{
+    // mask tree needs delivery index that is missing -> must prepare
+    if (maskTree_) { return false; }
+
+    // datasets changed since state has been saved -> must prepare
+    if (state["datasets"] != datasetStamp()) {
+        LOG(info1) << "Datasets of <" << id()
+                   << "> changed since last run, must prepare.";
+        return false;
+    }
+
+    hasMetatiles_ = state["hasMetatiles"].asBool();
+    if (state.isMember("maskDataset")) {
+        maskDataset_ = state["maskDataset"].asString();
+    }
+    return true;
+}
+
+Json::Value TmsRaster::datasetStamp() const
+{
+    Json::Value stamp(Json::objectValue);
+    stamp["dataset"] = fileStamp(absoluteDataset(dataset().path));
+    if (definition_.mask) {
+        stamp["mask"] = fileStamp(absoluteDataset(*definition_.mask));
+    }
+    return stamp;
+}
+
+double TmsRaster::prepareCost_impl() const
+{
+    // mask tree -> tile index is built from scratch
+    return maskTree_ ? 10.0 : 1.0;
+}
+
 Generator::Task TmsRaster::generateFile_impl(const FileInfo &fileInfo
                                              , Sink &sink) const
 {
@@ -445,19 +511,17 @@ Generator::Task TmsRaster::generateFile_impl(const FileInfo &fileInfo
         sink.error(utility::makeError<NotFound>("Unrecognized filename."));
         break;
 
-    case TmsFileInfo::Type::config: {
-        std::ostringstream os;
-        mapConfig(os, ResourceRoot::none);
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::config:
+        sendMapConfig(sink, fi.sinkFileInfo(), ResourceRoot::none);
         break;
-    };
 
-    case TmsFileInfo::Type::definition: {
-        std::ostringstream os;
-        vr::saveBoundLayer(os, boundLayer(ResourceRoot::none));
-        sink.content(os.str(), fi.sinkFileInfo());
+    case TmsFileInfo::Type::definition:
+        sendConfig(sink, fi.sinkFileInfo(), "boundlayer.json"
+                   , ResourceRoot::none, [&](std::ostream &os)
+        {
+            vr::saveBoundLayer(os, boundLayer(ResourceRoot::none));
+        });
         break;
-    }
 
     case TmsFileInfo::Type::support:
         sink.content(fi.support->data, fi.support->size
@@ -93,6 +93,13 @@ private:
     virtual Task generateFile_impl(const FileInfo &fileInfo
                                    , Sink &sink) const;
 
+    virtual void stat_impl(std::ostream &os) const;
+
+    virtual bool savePrepared_impl(Json::Value &state) const;
+    virtual bool loadPrepared_impl(const Json::Value &state);
+
+    virtual double prepareCost_impl() const;
+
     void generateTileImage(const vts::TileId &tileId
                            , const TmsFileInfo &fi
                            , Sink &sink, Arsenal &arsenal) const;
@@ -120,6 +127,10 @@ private:
 
     void update(vr::BoundLayer &bl) const;
 
+    /** Modification time and size of datasets prepared state depends on.
+     */
+    Json::Value datasetStamp() const;
+
     // customizable stuff
 
     /** Path to dataset and its validity. Defaults to path from resource.
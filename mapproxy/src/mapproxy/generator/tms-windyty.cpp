@@ -30,6 +30,8 @@
 #include <cerrno>
 #include <fstream>
 #include <system_error>
+#include <chrono>
+#include <algorithm>
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
@@ -37,6 +39,8 @@
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
 
+#include <gdal_priv.h>
+
 #include "utility/premain.hpp"
 #include "utility/raise.hpp"
 #include "utility/format.hpp"
@@ -87,6 +91,8 @@ utility::PreMain Factory::register_([]()
 void parseDefinition(TmsWindyty::Definition &def, const Json::Value &value)
 {
     Json::getOpt(def.forecastOffset, value, "forecastOffset");
+    Json::getOpt(def.prepareAhead, value, "prepareAhead");
+    Json::getOpt(def.prewarmDepth, value, "prewarmDepth");
 }
 
 void buildDefinition(Json::Value &value, const TmsWindyty::Definition &def)
@@ -94,6 +100,12 @@ void buildDefinition(Json::Value &value, const TmsWindyty::Definition &def)
     if (def.forecastOffset) {
         value["forecastOffset"] = def.forecastOffset;
     }
+    if (def.prepareAhead) {
+        value["prepareAhead"] = def.prepareAhead;
+    }
+    if (def.prewarmDepth) {
+        value["prewarmDepth"] = def.prewarmDepth;
+    }
 }
 
 void parseDefinition(TmsWindyty::Definition &def
@@ -103,6 +115,14 @@ void parseDefinition(TmsWindyty::Definition &def
         def.forecastOffset = boost::python::extract<int>
             (value["forecastOffset"]);
     }
+    if (value.has_key("prepareAhead")) {
+        def.prepareAhead = boost::python::extract<int>
+            (value["prepareAhead"]);
+    }
+    if (value.has_key("prewarmDepth")) {
+        def.prewarmDepth = boost::python::extract<int>
+            (value["prewarmDepth"]);
+    }
 }
 
 // definition dataset config
@@ -218,11 +238,14 @@ TmsWindyty::File writeWms(const fs::path &root
                           , const TmsWindyty::DatasetConfig &config
                           , const Resource &resource
                           , std::time_t time
-                          , int expires, int offset)
+                          , int expires, int offset
+                          , bool ahead = false)
 {
+    // files prepared ahead are kept apart not to clash with on-demand ones
     auto path(root / "windyty" / resource.id.referenceFrame
               / resource.id.group /
-              str(boost::format("%s.%s.xml") % resource.id.id % time));
+              str(boost::format("%s.%s%s.xml") % resource.id.id % time
+                  % (ahead ? ".next" : "")));
     fs::create_directories(path.parent_path());
 
     // temporary file
@@ -247,6 +270,62 @@ TmsWindyty::File writeWms(const fs::path &root
                             , path.string());
 }
 
+/** Reads all blocks of `depth` coarsest levels of given dataset. This makes
+ *  GDAL WMS driver fetch (and cache) upstream tiles before any client asks
+ *  for them. Stops between block fetches once `stop` is set.
+ */
+void prewarm(const std::string &path, int depth
+             , const std::atomic<bool> &stop)
+{
+    std::shared_ptr< ::GDALDataset> ds
+        (static_cast< ::GDALDataset*>(::GDALOpen(path.c_str(), GA_ReadOnly))
+         , [](::GDALDataset *ds) { if (ds) { ::GDALClose(ds); } });
+    if (!ds) {
+        LOG(warn2) << "Cannot open windyty dataset " << path
+                   << " for prewarming.";
+        return;
+    }
+
+    auto *band(ds->GetRasterBand(1));
+    if (!band) { return; }
+
+    std::vector<unsigned char> block;
+    const auto overviews(band->GetOverviewCount());
+
+    // overviews go from the finest to the coarsest one
+    for (int level(0); level < depth; ++level) {
+        const int ovr(overviews - 1 - level);
+        auto *b((ovr >= 0) ? band->GetOverview(ovr) : band);
+        if (!b) { continue; }
+
+        int bx(0), by(0);
+        b->GetBlockSize(&bx, &by);
+        block.resize(std::size_t(bx) * by
+                     * ::GDALGetDataTypeSizeBytes(b->GetRasterDataType()));
+
+        const int nx((b->GetXSize() + bx - 1) / bx);
+        const int ny((b->GetYSize() + by - 1) / by);
+        for (int j(0); j < ny; ++j) {
+            for (int i(0); i < nx; ++i) {
+                if (stop) {
+                    LOG(info1) << "Prewarming of " << path << " aborted.";
+                    return;
+                }
+                if (b->ReadBlock(i, j, block.data()) != CE_None) {
+                    LOG(warn1) << "Unable to prewarm block " << i << ", " << j
+                               << " in " << path << ".";
+                }
+            }
+        }
+
+        LOG(info1) << "Prewarmed " << (nx * ny) << " block(s) of " << path
+                   << " at level " << level << ".";
+
+        // full resolution reached
+        if (ovr < 0) { break; }
+    }
+}
+
 } // namespace
 
 void TmsWindyty::Definition::from_impl(const boost::any &value)
@@ -292,6 +371,10 @@ Changed TmsWindyty::Definition::changed_impl(const DefinitionBase &o) const
     // forecast offset can change
     if (forecastOffset != other.forecastOffset) { return Changed::safely; }
 
+    // pre-generation setup can change as well
+    if (prepareAhead != other.prepareAhead) { return Changed::safely; }
+    if (prewarmDepth != other.prewarmDepth) { return Changed::safely; }
+
     // not changed at alla
     return Changed::no;
 }
@@ -309,6 +392,24 @@ TmsWindyty::TmsWindyty(const Params &params)
     ds_.current = writeWms(config().tmpRoot, dsConfig_, resource()
                            , normalizedTime(std::time(nullptr), dsConfig_)
                            , 1, definition_.forecastOffset);
+
+    if (definition_.prepareAhead > 0) {
+        scheduler_ = std::thread(&TmsWindyty::scheduler, this);
+    }
+}
+
+TmsWindyty::~TmsWindyty()
+{
+    if (!scheduler_.joinable()) { return; }
+
+    // wake up sleeping scheduler; running prewarm polls the flag between
+    // block fetches so we wait for at most one fetch
+    {
+        std::unique_lock<std::mutex> lock(ds_.mutex);
+        ds_.stop = true;
+    }
+    ds_.cond.notify_all();
+    scheduler_.join();
 }
 
 bool TmsWindyty::transparent_impl() const
@@ -327,19 +428,84 @@ TmsWindyty::DsInfo TmsWindyty::dsInfo(std::time_t now) const
     // lock access
     std::unique_lock<std::mutex> lock(ds_.mutex);
 
-    if (now > ds_.current.timestamp) {
-        // Generate new file
-        auto file(writeWms(config().tmpRoot, dsConfig_, resource()
-                           , normalizedTime(now, dsConfig_)
-                           , 1, definition_.forecastOffset));
-        ds_.prev = std::move(ds_.current);
-        ds_.current = std::move(file);
-    }
+    update(now);
 
     // done
     return { ds_.current.path, ds_.current.timestamp };
 }
 
+void TmsWindyty::update(std::time_t now) const
+{
+    if (now <= ds_.current.timestamp) { return; }
+
+    const auto start(normalizedTime(now, dsConfig_));
+
+    if (!ds_.next.path.empty()
+        && ((ds_.next.timestamp - dsConfig_.period) == start))
+    {
+        // next period has been prepared in advance, just swap
+        LOG(info2) << "Switching to pre-generated dataset "
+                   << ds_.next.path << ".";
+        ds_.prev = std::move(ds_.current);
+        ds_.current = std::move(ds_.next);
+        return;
+    }
+
+    // Generate new file
+    auto file(writeWms(config().tmpRoot, dsConfig_, resource()
+                       , start, 1, definition_.forecastOffset));
+    ds_.prev = std::move(ds_.current);
+    ds_.current = std::move(file);
+}
+
+void TmsWindyty::scheduler()
+{
+    std::unique_lock<std::mutex> lock(ds_.mutex);
+
+    while (!ds_.stop) {
+        const auto now(std::time(nullptr));
+
+        // switch to next period if it is time to do so
+        update(now);
+
+        // next period starts at current's expiration time
+        const auto boundary(ds_.current.timestamp);
+        const bool prepared(!ds_.next.path.empty()
+                            && (ds_.next.timestamp > boundary));
+        const auto when(boundary - definition_.prepareAhead);
+
+        if (prepared || (now < when)) {
+            // sleep till preparation time or till the boundary is crossed
+            const auto until(prepared ? (boundary + 1) : when);
+            ds_.cond.wait_for
+                (lock, std::chrono::seconds
+                 (std::max<std::time_t>(until - now, 1)));
+            continue;
+        }
+
+        // prepare next period without holding the lock
+        lock.unlock();
+        try {
+            auto file(writeWms(config().tmpRoot, dsConfig_, resource()
+                               , boundary, 1, definition_.forecastOffset
+                               , true));
+            if (definition_.prewarmDepth > 0) {
+                prewarm(file.path, definition_.prewarmDepth, ds_.stop);
+            }
+
+            lock.lock();
+            ds_.next = std::move(file);
+        } catch (const std::exception &e) {
+            LOG(warn2) << "Failed to prepare next windyty forecast period: <"
+                       << e.what() << ">.";
+
+            // try again later
+            lock.lock();
+            ds_.cond.wait_for(lock, std::chrono::seconds(1));
+        }
+    }
+}
+
 TmsRaster::DatasetDesc TmsWindyty::dataset_impl() const
 {
     const auto now(std::time(nullptr));
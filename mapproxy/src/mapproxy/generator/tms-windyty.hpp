@@ -28,6 +28,9 @@
 #define mapproxy_generator_tms_windyty_hpp_included_
 
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
 #include <boost/format.hpp>
 
@@ -41,6 +44,8 @@ class TmsWindyty : public TmsRaster {
 public:
     TmsWindyty(const Params &params);
 
+    virtual ~TmsWindyty();
+
     struct DatasetConfig {
         std::time_t base;
         int period;
@@ -101,7 +106,17 @@ public:
     struct Definition : public TmsRaster::Definition {
         int forecastOffset;
 
-        Definition() : forecastOffset() {}
+        /** Prepare next forecast period dataset this number of seconds
+         *  before period boundary. Zero disables pre-generation.
+         */
+        int prepareAhead;
+
+        /** Number of coarsest dataset levels to prefetch for the next
+         *  forecast period. Used only when prepareAhead is non-zero.
+         */
+        int prewarmDepth;
+
+        Definition() : forecastOffset(), prepareAhead(), prewarmDepth() {}
 
     private:
         virtual void from_impl(const boost::any &value);
@@ -115,6 +130,18 @@ private:
     virtual bool transparent_impl() const;
     virtual bool hasMask_impl() const;
 
+    /** Dataset changes in time, always prepare from scratch.
+     */
+    virtual bool savePrepared_impl(Json::Value&) const { return false; }
+
+    /** Bound layer URLs contain current dataset timestamp.
+     */
+    virtual bool mapConfigCacheable_impl() const { return false; }
+
+    /** Dataset changes in time under the same URL.
+     */
+    virtual bool stableContent_impl() const { return false; }
+
     virtual vr::BoundLayer boundLayer(ResourceRoot root) const;
 
     struct DsInfo {
@@ -124,17 +151,39 @@ private:
 
     DsInfo dsInfo(std::time_t now) const;
 
+    /** Switches to next period's dataset if current one has expired. Must be
+     *  called under ds_.mutex.
+     */
+    void update(std::time_t now) const;
+
+    /** Next period dataset preparation loop.
+     */
+    void scheduler();
+
     struct Dataset {
         std::mutex mutex;
+        std::condition_variable cond;
+
+        /** Set under mutex to wake the scheduler; also polled without lock
+         *  by long-running prewarm.
+         */
+        std::atomic<bool> stop;
 
         File current;
         File prev;
+
+        /** Pre-generated dataset for next forecast period.
+         */
+        File next;
+
+        Dataset() : stop(false) {}
     };
 
     const Definition &definition_;
     int pid_;
     DatasetConfig dsConfig_;
     mutable Dataset ds_;
+    std::thread scheduler_;
 };
 
 } // namespace generator
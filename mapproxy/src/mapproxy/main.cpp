@@ -144,6 +144,7 @@ private:
     vs::SupportFile::Vars variables_;
     Generators::Config generatorsConfig_;
     GdalWarper::Options gdalWarperOptions_;
+    UpstreamFetcher::Options upstreamOptions_;
 
     ResourceBackend::pointer resourceBackend_;
     boost::optional<GdalWarper> gdalWarper_;
@@ -197,6 +198,29 @@ void Daemon::configuration(po::options_description &cmdline
          ->default_value(gdalWarperOptions_.rssCheckPeriod)->required()
          , "Memory check period (in seconds)")
 
+        ("upstream.cache.memory"
+         , po::value(&upstreamOptions_.memoryLimit)
+         ->default_value(upstreamOptions_.memoryLimit)->required()
+         , "Memory limit of upstream content cache (in MB).")
+        ("upstream.cache.disk"
+         , po::value(&upstreamOptions_.diskLimit)
+         ->default_value(upstreamOptions_.diskLimit)->required()
+         , "Disk limit of upstream content cache (in MB), "
+         "0 disables disk cache.")
+        ("upstream.cache.root"
+         , po::value(&upstreamOptions_.root)
+         , "Root of upstream content disk cache. Defaults to "
+         "store.path/upstream.")
+        ("upstream.defaultMaxAge"
+         , po::value(&upstreamOptions_.defaultMaxAge)
+         ->default_value(upstreamOptions_.defaultMaxAge)->required()
+         , "Max age (in seconds) of upstream content without "
+         "expiration information.")
+        ("upstream.timeout"
+         , po::value(&upstreamOptions_.timeout)
+         ->default_value(upstreamOptions_.timeout)->required()
+         , "Upstream request timeout (in milliseconds).")
+
         ("resource-backend.type"
          , po::value(&resourceBackendConfig_.type)->required()
          , ("Resource backend type, possible values: "
@@ -228,6 +252,38 @@ void Daemon::configuration(po::options_description &cmdline
          , po::value(&variables_["VTS_BUILTIN_BROWSER_URL"])
          , "URL of built in browser.")
 
+        ("geodata.cacheSize"
+         , po::value(&generatorsConfig_.geodataCacheSize)
+         ->default_value(generatorsConfig_.geodataCacheSize)->required()
+         , "Memory limit of heightcoded geodata cache per resource (in MB). "
+         "Zero disables the cache completely (disk cache included).")
+        ("geodata.diskCache"
+         , po::value(&generatorsConfig_.geodataDiskCache)
+         ->default_value(generatorsConfig_.geodataDiskCache)->required()
+         , "Store heightcoded geodata in resource's store directory as well.")
+        ("geodata.diskCacheSize"
+         , po::value(&generatorsConfig_.geodataDiskCacheSize)
+         ->default_value(generatorsConfig_.geodataDiskCacheSize)->required()
+         , "Disk limit of heightcoded geodata cache per resource (in MB). "
+         "Oldest files are removed when exceeded.")
+
+        ("mmap.prefault"
+         , po::value(&generatorsConfig_.mmapOptions.prefault)
+         ->default_value(generatorsConfig_.mmapOptions.prefault)->required()
+         , utility::concat
+         ("Prefaulting of memory mapped tile indices, one of "
+          , enumerationString(generatorsConfig_.mmapOptions.prefault)
+          , ". Trades startup time for first-request latency.").c_str())
+        ("mmap.hugepages"
+         , po::value(&generatorsConfig_.mmapOptions.hugepages)
+         ->default_value(generatorsConfig_.mmapOptions.hugepages)->required()
+         , "Advise kernel to use huge pages for memory mapped tile indices.")
+        ("mmap.verify"
+         , po::value(&generatorsConfig_.mmapOptions.verify)
+         ->default_value(generatorsConfig_.mmapOptions.verify)->required()
+         , "Validate checksums of memory mapped tile indices when opened. "
+         "Reads whole index, i.e. defeats mmap.prefault=none.")
+
         ("introspection.defaultFov"
          , po::value(&generatorsConfig_.defaultFov)
          ->default_value(generatorsConfig_.defaultFov)->required()
@@ -236,6 +292,8 @@ void Daemon::configuration(po::options_description &cmdline
 
         resourceBackendGenericConfig_.fileClassSettings
             .configuration(config, "max-age.");
+        resourceBackendGenericConfig_.fileClassSettings
+            .encodingConfiguration(config, "encoding.");
 
     (void) cmdline;
     (void) pd;
@@ -276,6 +334,11 @@ void Daemon::configure(const po::variables_map &vars)
 
     gdalWarperOptions_.tmpRoot = fs::absolute(gdalWarperOptions_.tmpRoot);
 
+    if (upstreamOptions_.root.empty()) {
+        upstreamOptions_.root = generatorsConfig_.root / "upstream";
+    }
+    upstreamOptions_.root = fs::absolute(upstreamOptions_.root);
+
     {
         const auto &value(vars["resource-backend.freeze"].as<std::string>());
         std::vector<std::string> parts;
@@ -304,10 +367,22 @@ void Daemon::configure(const po::variables_map &vars)
         << "\n\tcore.threadCount = " << coreThreadCount_
         << "\n\tgdal.processCount = " << gdalWarperOptions_.processCount
         << "\n\tgdal.tmpRoot = " << gdalWarperOptions_.tmpRoot
+        << "\n\tupstream.cache.memory = " << upstreamOptions_.memoryLimit
+        << "\n\tupstream.cache.disk = " << upstreamOptions_.diskLimit
+        << "\n\tupstream.cache.root = " << upstreamOptions_.root
+        << "\n\tupstream.defaultMaxAge = " << upstreamOptions_.defaultMaxAge
+        << "\n\tupstream.timeout = " << upstreamOptions_.timeout
         << "\n\tresource-backend.updatePeriod = "
         << generatorsConfig_.resourceUpdatePeriod
         << "\n\tresource-backend.root = "
         << generatorsConfig_.resourceRoot
+        << "\n\tgeodata.cacheSize = " << generatorsConfig_.geodataCacheSize
+        << "\n\tgeodata.diskCache = " << generatorsConfig_.geodataDiskCache
+        << "\n\tgeodata.diskCacheSize = "
+        << generatorsConfig_.geodataDiskCacheSize
+        << "\n\tmmap.prefault = " << generatorsConfig_.mmapOptions.prefault
+        << "\n\tmmap.hugepages = " << generatorsConfig_.mmapOptions.hugepages
+        << "\n\tmmap.verify = " << generatorsConfig_.mmapOptions.verify
         << "\n\tresource-backend.freeze = ["
         << utility::join(generatorsConfig_.freezeResourceTypes, ",")
         << "]\n"
@@ -379,7 +454,8 @@ service::Service::Cleanup Daemon::start()
     // starts core + generators
     core_ = boost::in_place(std::ref(*generators_), std::ref(*gdalWarper_)
                             , coreThreadCount_
-                            , std::ref(http_->fetcher()));
+                            , std::ref(http_->fetcher())
+                            , upstreamOptions_);
 
     http_->listen(httpListen_, std::ref(*core_));
     http_->startServer(httpThreadCount_);
@@ -114,6 +114,26 @@ FileClassSettings parseFileClassSettings(const python::dict &value
     return fcs;
 }
 
+void parseEncodings(FileClassSettings &fcs, const python::dict &value)
+{
+    for (python::stl_input_iterator<python::str> ivalue(value), evalue;
+         ivalue != evalue; ++ivalue)
+    {
+        auto fc(boost::lexical_cast<FileClass>(py2utf8(*ivalue)));
+        python::list list(value[*ivalue]);
+
+        ContentEncodings encodings;
+        for (python::stl_input_iterator<python::str> iitem(list), eitem;
+             iitem != eitem; ++iitem)
+        {
+            encodings.set(static_cast<int>
+                          (boost::lexical_cast<ContentEncoding>
+                           (py2utf8(*iitem))));
+        }
+        fcs.setEncodings(fc, encodings);
+    }
+}
+
 Resource::list parseResource(const Resource::Id &id, const python::dict &value
                              , const FileClassSettings &fileClassSettings)
 {
@@ -121,6 +141,9 @@ Resource::list parseResource(const Resource::Id &id, const python::dict &value
                ? parseFileClassSettings(python::dict(value["maxAge"])
                                         , fileClassSettings)
                : fileClassSettings);
+    if (value.has_key("encoding")) {
+        parseEncodings(r.fileClassSettings, python::dict(value["encoding"]));
+    }
     r.id = id;
 
     std::string tmp(py2utf8(value["type"]));
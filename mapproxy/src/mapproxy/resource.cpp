@@ -24,7 +24,11 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <set>
+#include <fstream>
+
 #include <boost/lexical_cast.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include "dbglog/dbglog.hpp"
 
@@ -118,6 +122,32 @@ FileClassSettings parseFileClassSettings(const Json::Value &value
     return fcs;
 }
 
+/** Parses per-file-class list of enabled content encodings, e.g.
+ *  "encoding": { "data": [ "gzip" ], "config": [] }
+ */
+void parseEncodings(FileClassSettings &fcs, const Json::Value &value)
+{
+    if (value.isNull()) { return; }
+
+    for (const auto &name : value.getMemberNames()) {
+        auto fc(boost::lexical_cast<FileClass>(name));
+        const auto &list(value[name]);
+        if (!list.isArray()) {
+            LOGTHROW(err1, Json::Error)
+                << "Encoding list for file class <" << name
+                << "> is not an array.";
+        }
+
+        ContentEncodings encodings;
+        for (const auto &item : list) {
+            encodings.set(static_cast<int>
+                          (boost::lexical_cast<ContentEncoding>
+                           (item.asString())));
+        }
+        fcs.setEncodings(fc, encodings);
+    }
+}
+
 Resource::list parseResource(const Json::Value &value
                              , const FileClassSettings &fileClassSettings)
 {
@@ -127,6 +157,7 @@ Resource::list parseResource(const Json::Value &value
     }
 
     Resource r(parseFileClassSettings(value["maxAge"], fileClassSettings));
+    parseEncodings(r.fileClassSettings, value["encoding"]);
 
     Json::get(r.id.group, value, "group");
     Json::get(r.id.id, value, "id");
@@ -203,9 +234,14 @@ Resource::list parseResource(const Json::Value &value
     return out;
 }
 
+/** Parses resources from given JSON value. Includes are loaded recursively
+ *  unless file cache entry is provided; in that case include patterns and
+ *  their expansion are only recorded in the entry.
+ */
 void parseResources(Resource::map &resources, const Json::Value &value
                     , const FileClassSettings &fileClassSettings
-                    , const fs::path &path)
+                    , const fs::path &path
+                    , ResourceFileCache::File *file = nullptr)
 {
     const auto dir(path.parent_path());
 
@@ -250,11 +286,17 @@ void parseResources(Resource::map &resources, const Json::Value &value
     const auto include([&](const fs::path &value) -> void
     {
         const auto includePath(fs::absolute(value, dir));
+        if (file) { file->includes.push_back(includePath); }
 
         auto paths(globPath(includePath));
         for (const auto &path : paths) {
             // ignore directories
             if (path.filename() == ".") { continue; }
+            if (file) {
+                // just remember, loaded by caller
+                file->included.push_back(path);
+                continue;
+            }
             includeLoad(path);
         }
     });
@@ -345,6 +387,110 @@ Resource::map loadResources(std::istream &in, const fs::path &path
     return resources;
 }
 
+/** Returns modification time and size of given file.
+ */
+std::pair<std::time_t, std::uintmax_t> fileStamp(const fs::path &path)
+{
+    boost::system::error_code ec;
+    const auto mtime(fs::last_write_time(path, ec));
+    if (ec) { return { -1, 0 }; }
+    const auto size(fs::file_size(path, ec));
+    if (ec) { return { -1, 0 }; }
+    return { mtime, size };
+}
+
+/** Expands include patterns the same way parseResources does.
+ */
+std::vector<fs::path> expandIncludes(const std::vector<fs::path> &includes)
+{
+    std::vector<fs::path> out;
+    for (const auto &include : includes) {
+        for (const auto &path : globPath(include)) {
+            if (path.filename() == ".") { continue; }
+            out.push_back(path);
+        }
+    }
+    return out;
+}
+
+/** Loads single file into cache (if not up to date already) and recurses
+ *  into included files. All resources are merged into output map.
+ */
+void loadCached(Resource::map &resources, const fs::path &path
+                , const FileClassSettings &fileClassSettings
+                , const ResourceFileCache &old, ResourceFileCache::FileMap &files
+                , const fs::path &includedFrom = fs::path())
+{
+    const auto stamp(fileStamp(path));
+
+    auto iold(old.files.find(path));
+    if (files.find(path) != files.end()) {
+        // already loaded in this run (included more than once)
+    } else if ((iold != old.files.end()) && (iold->second.mtime == stamp.first)
+               && (iold->second.size == stamp.second))
+    {
+        // unchanged file, reuse
+        files.insert(*iold);
+    } else {
+        if (includedFrom.empty()) {
+            LOG(info2) << "Loading resources from file " << path << ".";
+        } else {
+            LOG(info2) << "Loading resources from file " << path
+                       << " included from " << includedFrom << ".";
+        }
+
+        std::ifstream f;
+        f.exceptions(std::ios::badbit | std::ios::failbit);
+
+        try {
+            f.open(path.string(), std::ios_base::in);
+        } catch (const std::exception &e) {
+            LOGTHROW(err1, IOError)
+                << "Unable to load resources " << path
+                << ": <" << e.what() << ">.";
+        }
+
+        const auto config(Json::read<FormatError>(f, path, "resources"));
+
+        ResourceFileCache::File file;
+        file.mtime = stamp.first;
+        file.size = stamp.second;
+
+        try {
+            parseResources(file.resources, config, fileClassSettings
+                           , path, &file);
+        } catch (const Json::Error &e) {
+            LOGTHROW(err1, FormatError)
+                << "Invalid resource config file " << path
+                << " format: <" << e.what() << ">.";
+        } catch (const vs::Error &e) {
+            LOGTHROW(err1, FormatError)
+                << "Invalid resource config file " << path
+                << " format: <" << e.what() << ">.";
+        }
+
+        files.insert(ResourceFileCache::FileMap::value_type(path, file));
+    }
+
+    auto &file(files.find(path)->second);
+
+    for (const auto &res : file.resources) {
+        if (!resources.insert(res).second) {
+            LOGTHROW(err1, FormatError)
+                << "Invalid resource config file " << path
+                << " format: <Duplicate entry for <" << res.first << ">.>";
+        }
+    }
+
+    // NB: expand includes again, glob can match different set of files now;
+    // remember current expansion, changed() compares against it
+    const auto included(expandIncludes(file.includes));
+    file.included = included;
+    for (const auto &include : included) {
+        loadCached(resources, include, fileClassSettings, old, files, path);
+    }
+}
+
 Resource::list loadResource(std::istream &in, const fs::path &path
                             , const FileClassSettings &fileClassSettings)
 {
@@ -434,6 +580,50 @@ Resource::map loadResources(const boost::filesystem::path &path
     return detail::loadResources(f, path, fileClassSettings);
 }
 
+Resource::map loadResources(const boost::filesystem::path &path
+                            , ResourceFileCache &cache
+                            , const FileClassSettings &fileClassSettings)
+{
+    // start with fresh set of files, anything not visited is forgotten
+    ResourceFileCache::FileMap files;
+    Resource::map resources;
+    detail::loadCached(resources, path, fileClassSettings, cache, files);
+
+    cache.root = path;
+    cache.files.swap(files);
+    return resources;
+}
+
+bool ResourceFileCache::changed() const
+{
+    if (root.empty()) { return true; }
+
+    // walk the include tree the same way as loadCached does
+    std::vector<fs::path> queue{ root };
+    std::set<fs::path> visited;
+    while (!queue.empty()) {
+        const auto path(queue.back());
+        queue.pop_back();
+        if (!visited.insert(path).second) { continue; }
+
+        auto ifiles(files.find(path));
+        if (ifiles == files.end()) { return true; }
+        const auto &file(ifiles->second);
+
+        const auto stamp(detail::fileStamp(path));
+        if ((file.mtime != stamp.first) || (file.size != stamp.second)) {
+            return true;
+        }
+
+        const auto included(detail::expandIncludes(file.includes));
+        if (included != file.included) { return true; }
+
+        queue.insert(queue.end(), included.begin(), included.end());
+    }
+
+    return (visited.size() != files.size());
+}
+
 Resource::list loadResource(const boost::filesystem::path &path
                             , const FileClassSettings &fileClassSettings)
 {
@@ -27,6 +27,10 @@
 #ifndef mapproxy_resource_hpp_included_
 #define mapproxy_resource_hpp_included_
 
+#include <ctime>
+#include <cstdint>
+#include <map>
+#include <vector>
 #include <memory>
 #include <iostream>
 
@@ -304,6 +308,55 @@ Resource::map loadResources(const boost::filesystem::path &path
                             , const FileClassSettings &fileClassSettings
                             = FileClassSettings());
 
+/** Cache of parsed resource files used by incremental loading.
+ *
+ *  Every loaded file (main one and all included ones) is remembered together
+ *  with its modification time, size, resources defined directly in it and
+ *  its include directives. Unchanged files are not reparsed on next load.
+ */
+struct ResourceFileCache {
+    struct File {
+        std::time_t mtime;
+        std::uintmax_t size;
+
+        /** Resources defined directly in this file.
+         */
+        Resource::map resources;
+
+        /** Absolute include patterns (before glob expansion).
+         */
+        std::vector<boost::filesystem::path> includes;
+
+        /** Glob-expanded included files, in load order.
+         */
+        std::vector<boost::filesystem::path> included;
+
+        File() : mtime(), size() {}
+    };
+
+    typedef std::map<boost::filesystem::path, File> FileMap;
+
+    /** Root file path, empty until first load.
+     */
+    boost::filesystem::path root;
+
+    FileMap files;
+
+    /** Checks whether anything has changed since last load: any known file
+     *  has been modified or removed or any include pattern expands to
+     *  different set of files. Empty cache is always changed.
+     */
+    bool changed() const;
+};
+
+/** Load resources from given path, reparse only files changed since last
+ *  load. Cache is updated on success.
+ */
+Resource::map loadResources(const boost::filesystem::path &path
+                            , ResourceFileCache &cache
+                            , const FileClassSettings &fileClassSettings
+                            = FileClassSettings());
+
 /** Load single resource from given path.
  */
 Resource::list loadResource(const boost::filesystem::path &path
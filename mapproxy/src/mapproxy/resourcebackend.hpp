@@ -48,6 +48,11 @@ public:
 
     Resource::map load() const;
 
+    /** Checks whether resources may have changed since last load. Backends
+     *  without change detection always report change.
+     */
+    bool changed() const;
+
     void error(const Resource::Id &resourceId, const std::string &message)
         const;
 
@@ -109,6 +114,8 @@ protected:
 
     virtual Resource::map load_impl() const = 0;
 
+    virtual bool changed_impl() const { return true; }
+
     virtual void error_impl(const Resource::Id&, const std::string&) const {}
 
     GenericConfig genericConfig_;
@@ -119,6 +126,11 @@ inline Resource::map ResourceBackend::load() const
     return load_impl();
 }
 
+inline bool ResourceBackend::changed() const
+{
+    return changed_impl();
+}
+
 inline void ResourceBackend::error(const Resource::Id &resourceId
                                    , const std::string &message) const
 {
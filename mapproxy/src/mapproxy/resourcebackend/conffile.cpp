@@ -94,7 +94,20 @@ Conffile::Conffile(const GenericConfig &genericConfig
 
 Resource::map Conffile::load_impl() const
 {
-    return loadResources(config_.path, {}, genericConfig_.fileClassSettings);
+    std::unique_lock<std::mutex> lock(cacheLock_);
+    return loadResources(config_.path, cache_
+                         , genericConfig_.fileClassSettings);
+}
+
+bool Conffile::changed_impl() const
+{
+    std::unique_lock<std::mutex> lock(cacheLock_);
+    try {
+        return cache_.changed();
+    } catch (const std::exception&) {
+        // let load report the problem
+        return true;
+    }
 }
 
 } // namespace resource_backend
@@ -27,6 +27,8 @@
 #ifndef mapproxy_resourcebackend_conffile_hpp_included_
 #define mapproxy_resourcebackend_conffile_hpp_included_
 
+#include <mutex>
+
 #include <boost/filesystem/path.hpp>
 
 #include "../resourcebackend.hpp"
@@ -45,7 +47,14 @@ public:
 private:
     virtual Resource::map load_impl() const;
 
+    virtual bool changed_impl() const;
+
     const Config config_;
+
+    /** Parsed files, only changed files are reparsed on load.
+     */
+    mutable std::mutex cacheLock_;
+    mutable ResourceFileCache cache_;
 };
 
 } // namespace resource_backend
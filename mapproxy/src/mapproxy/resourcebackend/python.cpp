@@ -149,7 +149,7 @@ utility::PreMain Factory::register_([]()
 } // namespace
 
 Python::Python(const GenericConfig &genericConfig, const Config &config)
-    : ResourceBackend(genericConfig), run_(), error_()
+    : ResourceBackend(genericConfig), run_(), error_(), changed_()
 {
     try {
         python::dict options;
@@ -162,6 +162,9 @@ Python::Python(const GenericConfig &genericConfig, const Config &config)
         if (PyObject_HasAttrString(run_.ptr(), "error")) {
             error_ = run_.attr("error");
         }
+        if (PyObject_HasAttrString(run_.ptr(), "changed")) {
+            changed_ = run_.attr("changed");
+        }
     } catch (const python::error_already_set&) {
         LOGTHROW(err2, Error)
             << "Run importing python script from " << config.script << ": "
@@ -188,6 +191,25 @@ Resource::map Python::load_impl() const
     throw;
 }
 
+bool Python::changed_impl() const
+{
+    // no change feed -> always changed
+    if (!changed_) { return true; }
+
+    std::unique_lock<decltype(mutex_)> lock(mutex_);
+    try {
+        return python::extract<bool>(changed_());
+    } catch (const python::error_already_set&) {
+        python::handle_exception();
+        LOG(warn2)
+            << "Resource backend change check failed: "
+            << pysupport::formatCurrentException();
+    }
+
+    // be safe and reload
+    return true;
+}
+
 void Python::error_impl(const Resource::Id &resourceId
                         , const std::string &message) const
 {
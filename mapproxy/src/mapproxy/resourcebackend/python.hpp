@@ -52,6 +52,8 @@ public:
 private:
     virtual Resource::map load_impl() const;
 
+    virtual bool changed_impl() const;
+
     virtual void error_impl(const Resource::Id &resourceId
                             , const std::string &message) const;
 
@@ -61,6 +63,7 @@ private:
     mutable std::recursive_mutex mutex_;
     python::object run_;
     python::object error_;
+    python::object changed_;
 };
 
 } // namespace resource_backend
@@ -24,8 +24,13 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 #include <boost/lexical_cast.hpp>
 #include <boost/format.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <opencv2/highgui/highgui.hpp>
 
@@ -39,8 +44,10 @@
 
 #include "./sink.hpp"
 #include "./error.hpp"
+#include "./support/gzip.hpp"
 
 namespace vts = vtslibs::vts;
+namespace ba = boost::algorithm;
 
 namespace {
 
@@ -72,6 +79,22 @@ Sink::FileInfo update(const Sink::FileInfo &inStat
     return stat;
 }
 
+/** Content smaller than this is not worth compressing.
+ */
+const std::size_t MinEncodedSize(1024);
+
+/** Is content of given type worth compressing? Images and meshes are
+ *  already compressed.
+ */
+bool compressible(const std::string &contentType)
+{
+    return (ba::starts_with(contentType, "text/")
+            || ba::starts_with(contentType, "application/json")
+            || ba::starts_with(contentType, "application/javascript")
+            || ba::starts_with(contentType, "application/xml")
+            || ba::starts_with(contentType, "image/svg+xml"));
+}
+
 const auto emptyImage([]() -> std::vector<unsigned char>
 {
     cv::Mat dot(4, 4, CV_8U, cv::Scalar(0));
@@ -101,7 +124,7 @@ public:
                       , FileClass fileClass
                       , const FileClassSettings *fileClassSettings
                       , const boost::optional<long> &forcedMaxAge
-                      , bool gzipped)
+                      , bool gzipped, const std::string &etag)
         : stream_(stream), stat_(stream->stat())
         , fs_(Sink::FileInfo(stat_.contentType, stat_.lastModified
                              , maxAge(fileClass, fileClassSettings
@@ -113,6 +136,9 @@ public:
         if (gzipped) {
             headers_.emplace_back("Content-Encoding", "gzip");
         }
+        if (!etag.empty()) {
+            headers_.emplace_back("ETag", etag);
+        }
     }
 
     virtual http::SinkBase::FileInfo stat() const {
@@ -140,13 +166,163 @@ private:
     http::Header::list headers_;
 };
 
+/** Data source for memory block held by a shared owner. Owner is released
+ *  only after HTTP layer is done with the data source.
+ *
+ *  Scarce owners (e.g. shared memory block) are not pinned by slow clients:
+ *  if the data do not fit into the first read or reading takes too long the
+ *  rest of the data is copied out and the owner is released.
+ */
+class SharedDataSource : public http::ServerSink::DataSource {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    SharedDataSource(const void *data, std::size_t size
+                     , const std::shared_ptr<const void> &owner
+                     , const Sink::FileInfo &stat, bool scarce = false)
+        : data_(static_cast<const char*>(data)), size_(size)
+        , owner_(owner), stat_(stat), scarce_(scarce)
+        , created_(Clock::now())
+    {}
+
+    virtual http::SinkBase::FileInfo stat() const { return stat_; }
+
+    virtual std::size_t read(char *buf, std::size_t size
+                             , std::size_t off)
+    {
+        if (off >= size_) { return 0; }
+
+        if (scarce_ && ((size_ - off > size)
+                        || (Clock::now() - created_ > MaxPinTime)))
+        {
+            // more writes needed (or client is slow): release owner
+            copy_.assign(data_, data_ + size_);
+            data_ = copy_.data();
+            owner_.reset();
+            scarce_ = false;
+        }
+
+        size = std::min(size, size_ - off);
+        std::copy(data_ + off, data_ + off + size, buf);
+        return size;
+    }
+
+    virtual std::string name() const { return "memory"; }
+
+    virtual void close() const {}
+
+    virtual long size() const { return size_; }
+
+    virtual const http::Header::list *headers() const {
+        return &stat_.headers;
+    }
+
+private:
+    /** Maximum time scarce owner can be held.
+     */
+    static constexpr std::chrono::milliseconds MaxPinTime{100};
+
+    const char *data_;
+    std::size_t size_;
+    std::shared_ptr<const void> owner_;
+    Sink::FileInfo stat_;
+    bool scarce_;
+    Clock::time_point created_;
+    std::vector<char> copy_;
+};
+
+constexpr std::chrono::milliseconds SharedDataSource::MaxPinTime;
+
 } //namesapce
 
 void Sink::content(const vs::IStream::pointer &stream, FileClass fileClass
                    , const boost::optional<long> &maxAge, bool gzipped)
 {
     sink_->content(std::make_shared<IStreamDataSource>
-                   (stream, fileClass, fileClassSettings_, maxAge, gzipped));
+                   (stream, fileClass, fileClassSettings_, maxAge, gzipped
+                    , etag_));
+}
+
+void Sink::content(const std::shared_ptr<const std::string> &data
+                   , const FileInfo &stat)
+{
+    content(data->data(), data->size(), data, stat, false);
+}
+
+void Sink::content(const void *data, std::size_t size
+                   , const std::shared_ptr<const void> &owner
+                   , const FileInfo &stat)
+{
+    content(data, size, owner, stat, true);
+}
+
+void Sink::content(const void *data, std::size_t size
+                   , const std::shared_ptr<const void> &owner
+                   , const FileInfo &stat, bool scarce)
+{
+    auto fi(update(stat));
+    if (const auto encoded = encode(data, size, fi)) {
+        sink_->content(std::make_shared<SharedDataSource>
+                       (encoded->data(), encoded->size(), encoded, fi));
+        return;
+    }
+
+    sink_->content(std::make_shared<SharedDataSource>
+                   (data, size, owner, fi, scarce));
+}
+
+void Sink::content(const void *data, std::size_t size
+                   , const FileInfo &stat, bool needCopy)
+{
+    auto fi(update(stat));
+    if (const auto encoded = encode(data, size, fi)) {
+        sink_->content(std::make_shared<SharedDataSource>
+                       (encoded->data(), encoded->size(), encoded, fi));
+        return;
+    }
+
+    sink_->content(data, size, fi, needCopy, &fi.headers);
+}
+
+bool Sink::accepts(ContentEncoding ce, FileClass fileClass) const
+{
+    if (!acceptEncoding_.test(static_cast<int>(ce))) { return false; }
+    if (!fileClassSettings_) { return true; }
+    return fileClassSettings_->getEncoding(fileClass, ce);
+}
+
+std::shared_ptr<const std::string>
+Sink::encode(const void *data, std::size_t size, FileInfo &stat) const
+{
+    switch (stat.contentEncoding) {
+    case ContentEncoding::gzip:
+        // pre-compressed content
+        stat.addHeader("Vary", "Accept-Encoding");
+        if (accepts(ContentEncoding::gzip, stat.fileClass)) {
+            stat.addHeader("Content-Encoding", "gzip");
+            return {};
+        }
+
+        // client cannot handle it, decode
+        stat.contentEncoding = ContentEncoding::identity;
+        return std::make_shared<const std::string>(gunzip(data, size));
+
+    case ContentEncoding::identity:
+        break;
+    }
+
+    if (!compressible(stat.contentType)) { return {}; }
+    stat.addHeader("Vary", "Accept-Encoding");
+
+    if ((size < MinEncodedSize)
+        || !accepts(ContentEncoding::gzip, stat.fileClass))
+    {
+        return {};
+    }
+
+    stat.contentEncoding = ContentEncoding::gzip;
+    stat.addHeader("Content-Encoding", "gzip");
+    return std::make_shared<const std::string>(gzip(data, size));
 }
 
 void Sink::error(const std::exception_ptr &exc)
@@ -180,6 +356,23 @@ void Sink::error(const std::exception_ptr &exc)
     }
 }
 
+void Sink::notModified(FileClass fileClass)
+{
+    const auto fi(update(FileInfo().setFileClass(fileClass)));
+
+    http::Header::list headers(fi.headers);
+    if (*fi.maxAge >= 0) {
+        headers.emplace_back("Cache-Control"
+                             , "max-age=" + std::to_string(*fi.maxAge));
+    } else {
+        headers.emplace_back("Cache-Control", "no-cache");
+    }
+
+    sink_->error(std::make_exception_ptr
+                 (NotModified("Not modified."))
+                 , &headers);
+}
+
 Sink::FileInfo& Sink::FileInfo::setFileClass(FileClass fc)
 {
     fileClass = fc;
@@ -199,7 +392,15 @@ Sink::FileInfo& Sink::FileInfo::addHeader(const std::string &name
     return *this;
 }
 
+Sink::FileInfo& Sink::FileInfo::setContentEncoding(ContentEncoding ce)
+{
+    contentEncoding = ce;
+    return *this;
+}
+
 Sink::FileInfo Sink::update(const FileInfo &stat) const
 {
-    return ::update(stat, fileClassSettings_);
+    auto fi(::update(stat, fileClassSettings_));
+    if (!etag_.empty()) { fi.addHeader("ETag", etag_); }
+    return fi;
 }
@@ -69,6 +69,8 @@ public:
                  , std::time_t lastModified = -1
                  , const boost::optional<long> &maxAge = boost::none)
             : http::SinkBase::FileInfo(contentType, lastModified, maxAge)
+            , fileClass(FileClass::unknown)
+            , contentEncoding(ContentEncoding::identity)
         {}
 
         FileInfo& setFileClass(FileClass fc);
@@ -78,12 +80,21 @@ public:
         FileInfo& addHeader(const std::string &name
                             , const std::string &value);
 
+        /** Marks content as already encoded (e.g. pre-compressed cache
+         *  entry). Sink decodes it if client cannot handle the encoding.
+         */
+        FileInfo& setContentEncoding(ContentEncoding ce);
+
         FileClass fileClass;
+        ContentEncoding contentEncoding;
         http::Header::list headers;
     };
 
     Sink(const http::ServerSink::pointer &sink)
-        : sink_(sink), fileClassSettings_() {}
+        : sink_(sink), fileClassSettings_()
+    {
+        acceptEncoding_.set(static_cast<int>(ContentEncoding::identity));
+    }
 
     /** Sends content to client.
      * \param data data top send
@@ -107,6 +118,29 @@ public:
     void content(const void *data, std::size_t size
                  , const FileInfo &stat, bool needCopy);
 
+    /** Sends shared content to client. Data are not copied, sink holds
+     *  reference to them until they are sent.
+     * \param data data to send
+     * \param stat file info (size is ignored)
+     */
+    void content(const std::shared_ptr<const std::string> &data
+                 , const FileInfo &stat);
+
+    /** Sends content owned by a shared object (e.g. heightcoded data in
+     *  shared memory) to client. Owner is treated as scarce resource: data
+     *  are sent directly from it (i.e. copied only into HTTP layer's buffer)
+     *  if they fit into a single read issued in a short time, otherwise they
+     *  are copied out and the owner is released early.
+     * \param data data to send
+     * \param size size of data
+     * \param owner owner of the data, released when data are sent or
+     *              copied out
+     * \param stat file info (size is ignored)
+     */
+    void content(const void *data, std::size_t size
+                 , const std::shared_ptr<const void> &owner
+                 , const FileInfo &stat);
+
     /** Sends content to client.
      * \param stream stream to send
      * \param fileclass file class
@@ -133,6 +167,12 @@ public:
      */
     void error();
 
+    /** Answers conditional request with 304 Not Modified. Response carries
+     *  entity tag and the same Cache-Control as full response of given file
+     *  class would (RFC 7232, section 4.1).
+     */
+    void notModified(FileClass fileClass);
+
     /** Sends given error to the client.
      */
     template <typename T> void error(const T &exc);
@@ -155,6 +195,21 @@ public:
      */
     void assignFileClassSettings(const FileClassSettings &fileClasssettings);
 
+    /** Assigns entity tag to be sent along with any content.
+     */
+    void assignETag(const std::string &etag) { etag_ = etag; }
+
+    /** Assigns content encodings acceptable by client.
+     */
+    void assignAcceptEncoding(const ContentEncodings &acceptEncoding) {
+        acceptEncoding_ = acceptEncoding;
+    }
+
+    /** Can content of given file class be sent with given encoding? Both
+     *  client and file class settings must allow it.
+     */
+    bool accepts(ContentEncoding ce, FileClass fileClass) const;
+
 private:
     /** Sends given error to the client.
      */
@@ -162,9 +217,28 @@ private:
 
     FileInfo update(const FileInfo &stat) const;
 
+    void content(const void *data, std::size_t size
+                 , const std::shared_ptr<const void> &owner
+                 , const FileInfo &stat, bool scarce);
+
+    /** Negotiates content encoding. Returns encoded (or decoded) content or
+     *  null pointer if data should be sent as they are. Updates headers in
+     *  file info.
+     */
+    std::shared_ptr<const std::string>
+    encode(const void *data, std::size_t size, FileInfo &stat) const;
+
     http::ServerSink::pointer sink_;
 
     const FileClassSettings *fileClassSettings_;
+
+    /** Entity tag, not sent if empty.
+     */
+    std::string etag_;
+
+    /** Content encodings acceptable by client.
+     */
+    ContentEncodings acceptEncoding_;
 };
 
 // inlines
@@ -178,18 +252,12 @@ inline void Sink::error(const T &exc)
 inline void Sink::error() { error(std::current_exception()); }
 
 inline void Sink::content(const std::string &data, const FileInfo &stat) {
-    sink_->content(data, update(stat), &stat.headers);
+    content(data.data(), data.size(), stat, true);
 }
 
 template <typename T>
 inline void Sink::content(const std::vector<T> &data, const FileInfo &stat) {
-    sink_->content(data, update(stat), &stat.headers);
-}
-
-inline void Sink::content(const void *data, std::size_t size
-                          , const FileInfo &stat, bool needCopy)
-{
-    sink_->content(data, size, update(stat), needCopy, &stat.headers);
+    content(data.data(), data.size() * sizeof(T), stat, true);
 }
 
 inline void
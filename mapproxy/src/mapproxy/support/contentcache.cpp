@@ -0,0 +1,256 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctime>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/crc.hpp>
+
+#include "dbglog/dbglog.hpp"
+
+#include "./contentcache.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+/** Temporary files are being written by other threads, never touch them.
+ */
+bool isTmp(const fs::path &path)
+{
+    return path.extension() == ".tmp";
+}
+
+} // namespace
+
+ContentCache::ContentCache(std::size_t limit
+                           , const boost::optional<fs::path> &root
+                           , std::size_t diskLimit)
+    : limit_(limit), root_(root), diskLimit_(diskLimit), size_()
+    , diskSize_()
+{
+    if (!root_) { return; }
+    create_directories(*root_);
+
+    // account current content
+    boost::system::error_code ec;
+    for (fs::directory_iterator idir(*root_, ec), edir; idir != edir;
+         idir.increment(ec))
+    {
+        if (isTmp(idir->path())) { continue; }
+        diskSize_ += file_size(idir->path(), ec);
+    }
+}
+
+fs::path ContentCache::filePath(const std::string &key) const
+{
+    // NB: must be stable between runs -> no std::hash
+    boost::crc_32_type crc;
+    crc.process_bytes(key.data(), key.size());
+
+    std::ostringstream os;
+    os << std::hex << std::setw(8) << std::setfill('0') << crc.checksum();
+    return *root_ / os.str();
+}
+
+void ContentCache::store(const std::string &key, const Data &data)
+{
+    // NB: called under lock
+    if (!limit_ || (data->size() > limit_)) { return; }
+
+    auto findex(index_.find(key));
+    if (findex != index_.end()) {
+        // replace existing entry
+        size_ -= findex->second->second->size();
+        lru_.erase(findex->second);
+        index_.erase(findex);
+    }
+
+    lru_.emplace_front(key, data);
+    index_.emplace(key, lru_.begin());
+    size_ += data->size();
+
+    // evict least recently used entries
+    while (size_ > limit_) {
+        const auto &last(lru_.back());
+        size_ -= last.second->size();
+        index_.erase(last.first);
+        lru_.pop_back();
+    }
+}
+
+ContentCache::Data ContentCache::get(const std::string &key)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto findex(index_.find(key));
+        if (findex != index_.end()) {
+            // move to front
+            lru_.splice(lru_.begin(), lru_, findex->second);
+            return findex->second->second;
+        }
+    }
+
+    if (!root_) { return {}; }
+
+    // try disk; file starts with full key to detect hash collisions
+    std::ifstream f(filePath(key).string(), std::ios::binary);
+    if (!f) { return {}; }
+
+    std::string storedKey;
+    if (!std::getline(f, storedKey) || (storedKey != key)) { return {}; }
+
+    auto data(std::make_shared<std::string>
+              (std::istreambuf_iterator<char>(f)
+               , std::istreambuf_iterator<char>()));
+    if (f.bad()) { return {}; }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    store(key, data);
+    return data;
+}
+
+void ContentCache::put(const std::string &key, const Data &data)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        store(key, data);
+    }
+
+    if (!root_) { return; }
+
+    // write to temporary file and move in place
+    const auto path(filePath(key));
+    const auto tmpPath(fs::unique_path(path.string() + ".%%%%-%%%%.tmp"));
+    std::size_t written(0);
+    try {
+        {
+            std::ofstream f;
+            f.exceptions(std::ios::badbit | std::ios::failbit);
+            f.open(tmpPath.string(), std::ios::binary | std::ios::trunc);
+            f << key << '\n';
+            f.write(data->data(), data->size());
+            written = f.tellp();
+        }
+        fs::rename(tmpPath, path);
+    } catch (const std::exception &e) {
+        LOG(warn2) << "Unable to write cached content to " << path
+                   << ": <" << e.what() << ">.";
+        boost::system::error_code ec;
+        fs::remove(tmpPath, ec);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    diskSize_ += written;
+    if (diskLimit_ && (diskSize_ > diskLimit_)) { shrink(); }
+}
+
+void ContentCache::shrink()
+{
+    // NB: called under lock; drop oldest files until we get under 90% of
+    // limit
+    typedef std::pair<std::time_t, fs::path> Item;
+    std::vector<Item> items;
+
+    boost::system::error_code ec;
+    std::size_t size(0);
+    for (fs::directory_iterator idir(*root_, ec), edir; idir != edir;
+         idir.increment(ec))
+    {
+        if (isTmp(idir->path())) { continue; }
+        size += file_size(idir->path(), ec);
+        items.emplace_back(last_write_time(idir->path(), ec), idir->path());
+    }
+
+    std::sort(items.begin(), items.end());
+
+    const std::size_t target(diskLimit_ / 10 * 9);
+    for (const auto &item : items) {
+        if (size <= target) { break; }
+        const auto fsize(file_size(item.second, ec));
+        if (fs::remove(item.second, ec)) { size -= fsize; }
+    }
+
+    diskSize_ = size;
+}
+
+void ContentCache::purge(const std::string &prefix)
+{
+    if (!root_) { return; }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    boost::system::error_code ec;
+    std::size_t size(0);
+    for (fs::directory_iterator idir(*root_, ec), edir; idir != edir;
+         idir.increment(ec))
+    {
+        const auto &path(idir->path());
+        if (isTmp(path)) { continue; }
+
+        // file starts with full key
+        std::string key;
+        {
+            std::ifstream f(path.string(), std::ios::binary);
+            std::getline(f, key);
+        }
+
+        const auto fsize(file_size(path, ec));
+        if ((key.compare(0, prefix.size(), prefix) != 0)
+            && fs::remove(path, ec))
+        {
+            continue;
+        }
+        size += fsize;
+    }
+
+    diskSize_ = size;
+}
+
+void ContentCache::clear()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    size_ = 0;
+
+    if (!root_) { return; }
+
+    boost::system::error_code ec;
+    for (fs::directory_iterator idir(*root_, ec), edir; idir != edir;
+         idir.increment(ec))
+    {
+        if (isTmp(idir->path())) { continue; }
+        fs::remove(idir->path(), ec);
+    }
+    diskSize_ = 0;
+}
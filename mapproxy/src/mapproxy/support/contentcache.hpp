@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef mapproxy_support_contentcache_hpp_included_
+#define mapproxy_support_contentcache_hpp_included_
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+#include <boost/filesystem/path.hpp>
+
+/** Cache of generated content blobs keyed by arbitrary string.
+ *
+ *  Memory part is an LRU bounded by total size of stored data. Optional disk
+ *  part stores every blob in its own file under given directory; blobs found
+ *  on disk are promoted to memory. Disk part is bounded as well, oldest files
+ *  are removed when its limit is exceeded.
+ *
+ *  Data are shared: returned pointer keeps data alive even if evicted from the
+ *  cache meanwhile.
+ */
+class ContentCache {
+public:
+    typedef std::shared_ptr<const std::string> Data;
+    typedef std::shared_ptr<ContentCache> pointer;
+
+    /** Creates cache.
+     *
+     * \param limit memory limit in bytes (0 means no memory cache)
+     * \param root directory for disk cache (none means no disk cache)
+     * \param diskLimit disk cache limit in bytes (0 means no limit)
+     */
+    ContentCache(std::size_t limit
+                 , const boost::optional<boost::filesystem::path> &root
+                 = boost::none
+                 , std::size_t diskLimit = 0);
+
+    /** Returns cached data or null pointer if not found.
+     */
+    Data get(const std::string &key);
+
+    /** Stores data in the cache.
+     */
+    void put(const std::string &key, const Data &data);
+
+    /** Drops everything (including disk cache content).
+     */
+    void clear();
+
+    /** Removes disk cache files whose key does not start with given prefix
+     *  (e.g. data of old revisions).
+     */
+    void purge(const std::string &prefix);
+
+private:
+    void store(const std::string &key, const Data &data);
+    boost::filesystem::path filePath(const std::string &key) const;
+    void shrink();
+
+    typedef std::list<std::pair<std::string, Data>> Lru;
+
+    const std::size_t limit_;
+    const boost::optional<boost::filesystem::path> root_;
+    const std::size_t diskLimit_;
+
+    std::mutex mutex_;
+    std::size_t size_;
+    std::size_t diskSize_;
+    Lru lru_;
+    std::unordered_map<std::string, Lru::iterator> index_;
+};
+
+#endif // mapproxy_support_contentcache_hpp_included_
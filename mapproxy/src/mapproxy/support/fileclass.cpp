@@ -55,3 +55,26 @@ void FileClassSettings::configuration(po::options_description &od
            .c_str());
     }
 }
+
+void FileClassSettings::encodingConfiguration(po::options_description &od
+                                              , const std::string &prefix)
+{
+    auto ao(od.add_options());
+    for (auto ce : enumerationValues(ContentEncoding())) {
+        if (ce == ContentEncoding::identity) { continue; }
+        auto encoding(boost::lexical_cast<std::string>(ce));
+        for (auto fc : enumerationValues(FileClass())) {
+            if (fc == FileClass::unknown) { continue; }
+            auto name(boost::lexical_cast<std::string>(fc));
+            auto &value(encodings_[static_cast<int>(fc)]);
+            ao((prefix + encoding + "." + name).c_str()
+               , po::value<bool>()->default_value
+               (value.test(static_cast<int>(ce)))
+               ->notifier([&value, ce](bool v) {
+                       value.set(static_cast<int>(ce), v);
+                   })
+               , ("Allow " + encoding + " content encoding for file class <"
+                  + name + "> when accepted by client.").c_str());
+        }
+    }
+}
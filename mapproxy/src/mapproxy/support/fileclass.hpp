@@ -28,6 +28,7 @@
 #define mapproxy_support_fileclass_hpp_included_
 
 #include <array>
+#include <bitset>
 
 #include <boost/any.hpp>
 #include <boost/program_options.hpp>
@@ -39,11 +40,24 @@
  */
 enum class FileClass { config, support, registry, data, unknown };
 
+/** Content encodings mapproxy can produce. Same rules as for FileClass apply,
+ *  identity (i.e. no encoding) must be the last one.
+ */
+enum class ContentEncoding { gzip, identity };
+
+/** Set of content encodings, indexed by ContentEncoding.
+ */
+typedef std::bitset<static_cast<int>(ContentEncoding::identity) + 1>
+    ContentEncodings;
+
 class FileClassSettings {
 public:
     FileClassSettings() : maxAges_{{0}} {
         // unknown files are never cached -- for example directory listings
         setMaxAge(FileClass::unknown, -1);
+
+        // all encodings are enabled by default
+        for (auto &encodings : encodings_) { encodings.set(); }
     }
 
     void from(const boost::any &value);
@@ -52,11 +66,27 @@ public:
     void configuration(boost::program_options::options_description &od
                               , const std::string &prefix = "");
 
+    /** Registers per-file-class content encoding toggles as
+     *  <prefix><encoding>.<fileClass>.
+     */
+    void encodingConfiguration(boost::program_options::options_description
+                               &od, const std::string &prefix = "");
+
     void setMaxAge(FileClass fc, long value);
     long getMaxAge(FileClass fc) const;
 
+    void setEncoding(FileClass fc, ContentEncoding ce, bool value);
+    bool getEncoding(FileClass fc, ContentEncoding ce) const;
+
+    /** Sets all enabled encodings of given file class at once. Identity is
+     *  always enabled.
+     */
+    void setEncodings(FileClass fc, const ContentEncodings &value);
+
 private:
     std::array<long, static_cast<int>(FileClass::unknown) + 1> maxAges_;
+    std::array<ContentEncodings, static_cast<int>(FileClass::unknown) + 1>
+        encodings_;
 };
 
 UTILITY_GENERATE_ENUM_IO(FileClass,
@@ -67,6 +97,11 @@ UTILITY_GENERATE_ENUM_IO(FileClass,
                          ((unknown))
                          )
 
+UTILITY_GENERATE_ENUM_IO(ContentEncoding,
+                         ((gzip))
+                         ((identity))
+                         )
+
 // inlines
 
 inline void FileClassSettings::setMaxAge(FileClass fc, long value)
@@ -79,4 +114,25 @@ inline long FileClassSettings::getMaxAge(FileClass fc) const
     return maxAges_[static_cast<int>(fc)];
 }
 
+inline void FileClassSettings::setEncoding(FileClass fc, ContentEncoding ce
+                                           , bool value)
+{
+    if (ce == ContentEncoding::identity) { return; }
+    encodings_[static_cast<int>(fc)].set(static_cast<int>(ce), value);
+}
+
+inline bool FileClassSettings::getEncoding(FileClass fc, ContentEncoding ce)
+    const
+{
+    return encodings_[static_cast<int>(fc)].test(static_cast<int>(ce));
+}
+
+inline void FileClassSettings::setEncodings(FileClass fc
+                                            , const ContentEncodings &value)
+{
+    encodings_[static_cast<int>(fc)] = value;
+    encodings_[static_cast<int>(fc)].set
+        (static_cast<int>(ContentEncoding::identity));
+}
+
 #endif // mapproxy_support_fileclass_hpp_included_
@@ -0,0 +1,285 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#include "dbglog/dbglog.hpp"
+
+#include "utility/openmp.hpp"
+
+#include "../error.hpp"
+
+#include "./heightgrid.hpp"
+
+namespace {
+
+const double Infinity(std::numeric_limits<double>::infinity());
+
+void checkDem(const cv::Mat &dem)
+{
+    if ((dem.depth() != CV_64F)
+        || ((dem.channels() != 1) && (dem.channels() != 3)))
+    {
+        LOGTHROW(err2, Error)
+            << "Height grid must be CV_64F matrix with 1 or 3 channels.";
+    }
+}
+
+/** Horizontal 3-sample window over one row.
+ */
+struct RowWindow {
+    std::vector<double> sum;
+    std::vector<double> count;
+    std::vector<double> min;
+    std::vector<double> max;
+
+    RowWindow(int cols, bool minMax)
+        : sum(cols), count(cols)
+        , min(minMax ? cols : 0), max(minMax ? cols : 0)
+    {}
+};
+
+/** Sums 3-sample horizontal window of src into dst, i.e. dst[i] = src[i - 1]
+ *  + src[i] + src[i + 1] with missing samples at the borders.
+ */
+template <typename Op>
+void window3(const double *src, double *dst, int cols, const Op &op)
+{
+    if (cols == 1) { dst[0] = src[0]; return; }
+
+    dst[0] = op(src[0], src[1]);
+    UTILITY_OMP(simd)
+    for (int i = 1; i < cols - 1; ++i) {
+        dst[i] = op(op(src[i - 1], src[i]), src[i + 1]);
+    }
+    dst[cols - 1] = op(src[cols - 2], src[cols - 1]);
+}
+
+struct Plus {
+    double operator()(double l, double r) const { return l + r; }
+};
+
+struct Min {
+    double operator()(double l, double r) const { return std::min(l, r); }
+};
+
+struct Max {
+    double operator()(double l, double r) const { return std::max(l, r); }
+};
+
+} // namespace
+
+HeightValidity heightValidity(const cv::Mat &dem)
+{
+    checkDem(dem);
+
+    const int channels(dem.channels());
+    HeightValidity validity(dem.rows, dem.cols);
+
+    for (int j(0); j < dem.rows; ++j) {
+        const auto *in(dem.ptr<double>(j));
+        auto *out(validity.ptr<std::uint8_t>(j));
+
+        UTILITY_OMP(simd)
+        for (int i = 0; i < dem.cols; ++i) {
+            out[i] = (in[i * channels] >= InvalidHeightThreshold);
+        }
+    }
+
+    return validity;
+}
+
+void fillHeightHoles(cv::Mat &dem, HeightValidity &validity
+                     , const HeightValidity *mask)
+{
+    checkDem(dem);
+
+    const int rows(dem.rows), cols(dem.cols);
+    const int channels(dem.channels());
+    const bool minMax(channels == 3);
+
+    if (mask) {
+        // masked out samples are not valid
+        cv::bitwise_and(validity, *mask, validity);
+    }
+
+    // rows with at least one fillable invalid sample
+    std::vector<char> holes(rows, false);
+    bool anyHole(false);
+    for (int j(0); j < rows; ++j) {
+        const auto *v(validity.ptr<std::uint8_t>(j));
+        const auto *m(mask ? mask->ptr<std::uint8_t>(j) : nullptr);
+        int invalid(0);
+        if (m) {
+            UTILITY_OMP(simd reduction(+:invalid))
+            for (int i = 0; i < cols; ++i) { invalid += (m[i] && !v[i]); }
+        } else {
+            UTILITY_OMP(simd reduction(+:invalid))
+            for (int i = 0; i < cols; ++i) { invalid += !v[i]; }
+        }
+        anyHole |= (holes[j] = (invalid > 0));
+    }
+
+    if (!anyHole) { return; }
+
+    // compute horizontal windows of all rows, invalid samples are replaced by
+    // neutral values
+    std::vector<RowWindow> windows(rows, RowWindow(cols, minMax));
+    {
+        std::vector<double> value(cols), count(cols), min, max;
+        if (minMax) { min.resize(cols); max.resize(cols); }
+
+        for (int j(0); j < rows; ++j) {
+            // only rows around holes are needed
+            if (!(holes[j] || ((j > 0) && holes[j - 1])
+                  || ((j + 1 < rows) && holes[j + 1])))
+            {
+                continue;
+            }
+
+            const auto *in(dem.ptr<double>(j));
+            const auto *v(validity.ptr<std::uint8_t>(j));
+
+            UTILITY_OMP(simd)
+            for (int i = 0; i < cols; ++i) {
+                value[i] = v[i] ? in[i * channels] : 0.0;
+                count[i] = v[i];
+            }
+
+            auto &w(windows[j]);
+            window3(value.data(), w.sum.data(), cols, Plus());
+            window3(count.data(), w.count.data(), cols, Plus());
+
+            if (minMax) {
+                UTILITY_OMP(simd)
+                for (int i = 0; i < cols; ++i) {
+                    min[i] = v[i] ? in[i * channels + 1] : Infinity;
+                    max[i] = v[i] ? in[i * channels + 2] : -Infinity;
+                }
+                window3(min.data(), w.min.data(), cols, Min());
+                window3(max.data(), w.max.data(), cols, Max());
+            }
+        }
+    }
+
+    // combine windows vertically and fill holes; center sample is invalid so
+    // it does not contribute to sums anyway
+    const RowWindow empty(cols, minMax);
+    HeightValidity filled(validity.clone());
+    std::vector<double> sum(cols), count(cols), min, max;
+    if (minMax) { min.resize(cols); max.resize(cols); }
+
+    for (int j(0); j < rows; ++j) {
+        if (!holes[j]) { continue; }
+
+        const auto &above((j > 0) ? windows[j - 1] : empty);
+        const auto &current(windows[j]);
+        const auto &below((j + 1 < rows) ? windows[j + 1] : empty);
+
+        auto *out(dem.ptr<double>(j));
+        const auto *v(validity.ptr<std::uint8_t>(j));
+        const auto *m(mask ? mask->ptr<std::uint8_t>(j) : nullptr);
+        auto *f(filled.ptr<std::uint8_t>(j));
+
+        UTILITY_OMP(simd)
+        for (int i = 0; i < cols; ++i) {
+            sum[i] = above.sum[i] + current.sum[i] + below.sum[i];
+            count[i] = above.count[i] + current.count[i] + below.count[i];
+        }
+
+        if (minMax) {
+            // empty window has zero-sized min/max -> handle borders
+            const auto *amin((j > 0) ? above.min.data() : nullptr);
+            const auto *amax((j > 0) ? above.max.data() : nullptr);
+            const auto *bmin((j + 1 < rows) ? below.min.data() : nullptr);
+            const auto *bmax((j + 1 < rows) ? below.max.data() : nullptr);
+
+            UTILITY_OMP(simd)
+            for (int i = 0; i < cols; ++i) {
+                min[i] = current.min[i];
+                max[i] = current.max[i];
+            }
+            if (amin) {
+                UTILITY_OMP(simd)
+                for (int i = 0; i < cols; ++i) {
+                    min[i] = std::min(min[i], amin[i]);
+                    max[i] = std::max(max[i], amax[i]);
+                }
+            }
+            if (bmin) {
+                UTILITY_OMP(simd)
+                for (int i = 0; i < cols; ++i) {
+                    min[i] = std::min(min[i], bmin[i]);
+                    max[i] = std::max(max[i], bmax[i]);
+                }
+            }
+        }
+
+        for (int i(0); i < cols; ++i) {
+            if (v[i] || (count[i] <= 0.0) || (m && !m[i])) { continue; }
+
+            out[i * channels] = sum[i] / count[i];
+            if (minMax) {
+                out[i * channels + 1] = min[i];
+                out[i * channels + 2] = max[i];
+            }
+            f[i] = true;
+        }
+    }
+
+    validity = filled;
+}
+
+void combineValueMinMax(const cv::Mat &value, const cv::Mat &min
+                        , const cv::Mat &max, double nodata, cv::Mat &out)
+{
+    for (int j(0); j < value.rows; ++j) {
+        const auto *v(value.ptr<double>(j));
+        const auto *vmin(min.ptr<double>(j));
+        const auto *vmax(max.ptr<double>(j));
+        auto *o(out.ptr<double>(j));
+
+        UTILITY_OMP(simd)
+        for (int i = 0; i < value.cols; ++i) {
+            const auto x(v[i]);
+            const bool valid(x != nodata);
+
+            // clone value into minimum/maximum if invalid or not embracing
+            // the value
+            const auto lo(((vmin[i] == nodata) || (vmin[i] > x))
+                          ? x : vmin[i]);
+            const auto hi(((vmax[i] == nodata) || (vmax[i] < x))
+                          ? x : vmax[i]);
+
+            o[3 * i] = valid ? x : nodata;
+            o[3 * i + 1] = valid ? lo : nodata;
+            o[3 * i + 2] = valid ? hi : nodata;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef mapproxy_support_heightgrid_hpp_included_
+#define mapproxy_support_heightgrid_hpp_included_
+
+#include <cstdint>
+
+#include <opencv2/core/core.hpp>
+
+/** Batch kernels for height grids (DEM rasters warped into CV_64F matrices
+ *  with either single height channel or value/min/max channels).
+ *
+ *  All kernels process whole rows in tight branch-free loops to allow the
+ *  compiler to vectorize them.
+ */
+
+/** Heights below this value are treated as invalid (no data).
+ */
+constexpr double InvalidHeightThreshold(-1e6);
+
+typedef cv::Mat_<std::uint8_t> HeightValidity;
+
+/** Computes validity mask of given height grid (uses the first channel).
+ */
+HeightValidity heightValidity(const cv::Mat &dem);
+
+/** Fills invalid samples from valid samples in their 3x3 neighbourhood: first
+ *  channel is averaged, second channel (min) gets the minimum and third
+ *  channel (max) gets the maximum.
+ *
+ *  Optional mask restricts both the source and destination samples. Validity
+ *  mask is updated in place.
+ */
+void fillHeightHoles(cv::Mat &dem, HeightValidity &validity
+                     , const HeightValidity *mask = nullptr);
+
+/** Combines warped value, minimum and maximum rasters (all CV_64FC1) into one
+ *  value/min/max raster (CV_64FC3). Minimum and maximum are fixed to be
+ *  valid and to embrace the value. Invalid value produces nodata in all
+ *  channels.
+ */
+void combineValueMinMax(const cv::Mat &value, const cv::Mat &min
+                        , const cv::Mat &max, double nodata, cv::Mat &out);
+
+#endif // mapproxy_support_heightgrid_hpp_included_
@@ -31,6 +31,8 @@
 
 #include <boost/optional.hpp>
 
+#include "utility/enum-io.hpp"
+
 #include "geometry/mesh.hpp"
 
 #include "vts-libs/vts/nodeinfo.hpp"
@@ -59,6 +61,16 @@ private:
 
 typedef std::function<bool(int, int, double&)> HeightSampler;
 
+/** Mesh simplification algorithm:
+ *
+ *  decimation: full grid mesh simplified by general-purpose decimation
+ *  rtin: right-triangulated irregular network built directly from height grid
+ */
+UTILITY_GENERATE_ENUM(MeshSimplifier,
+    ((decimation))
+    ((rtin))
+)
+
 std::tuple<geometry::Mesh, bool>
 meshFromNode(const vts::NodeInfo &nodeInfo, const math::Size2 &edges
              , const HeightSampler &heights = HeightSampler());
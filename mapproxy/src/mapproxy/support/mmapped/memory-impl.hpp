@@ -28,33 +28,29 @@
 #define mapproxy_support_mmapped_memory_impl_hpp_included_
 
 #include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/iostreams/device/array.hpp>
 
-#include <boost/interprocess/file_mapping.hpp>
-#include <boost/interprocess/mapped_region.hpp>
-
 #include "utility/binaryio.hpp"
 
 #include "./memory.hpp"
 
 namespace mmapped {
 
-struct Memory {
-    Memory(const boost::filesystem::path &path)
-        : size(utility::fileSize(path))
-        , file(path.c_str(), boost::interprocess::read_only)
-        , region(file, boost::interprocess::read_only, 0, size)
-        , data(static_cast<char*>(region.get_address()))
-        , buffer(data, data + size)
-        , stream(&buffer)
-    {}
+struct Memory : boost::noncopyable {
+    Memory(const boost::filesystem::path &path
+           , const MapOptions &options = MapOptions());
+
+    ~Memory();
 
     const char* addr(std::size_t pos) const { return data + pos; }
 
+    /** Number of bytes of mapped file currently resident in memory.
+     */
+    std::size_t resident() const;
+
     std::size_t size;
-    boost::interprocess::file_mapping file;
-    boost::interprocess::mapped_region region;
     const char *data;
 
     boost::iostreams::stream_buffer<boost::iostreams::array_source> buffer;
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <vector>
+#include <system_error>
+
+#include "dbglog/dbglog.hpp"
+
+#include "utility/filesystem.hpp"
+
+#include "./memory-impl.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace mmapped {
+
+namespace {
+
+const char* map(const fs::path &path, std::size_t size
+                , const MapOptions &options)
+{
+    // nothing to map
+    if (!size) { return nullptr; }
+
+    const auto fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot open file " << path << " for mapping: <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    int flags(MAP_SHARED);
+    if (options.prefault == MapPrefault::populate) { flags |= MAP_POPULATE; }
+
+    auto *addr(::mmap(nullptr, size, PROT_READ, flags, fd, 0));
+    const auto err(errno);
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        std::system_error e(err, std::system_category());
+        LOG(err2) << "Cannot map file " << path << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    // advices are best effort only
+    if (options.hugepages) {
+#ifdef MADV_HUGEPAGE
+        if (-1 == ::madvise(addr, size, MADV_HUGEPAGE)) {
+            LOG(info1) << "Huge pages not available for " << path << ".";
+        }
+#endif
+    }
+
+    if (options.prefault == MapPrefault::willneed) {
+        ::madvise(addr, size, MADV_WILLNEED);
+    }
+
+    return static_cast<const char*>(addr);
+}
+
+} // namespace
+
+Memory::Memory(const fs::path &path, const MapOptions &options)
+    : size(utility::fileSize(path))
+    , data(map(path, size, options))
+    , buffer(data, data + size)
+    , stream(&buffer)
+{}
+
+Memory::~Memory()
+{
+    if (data) { ::munmap(const_cast<char*>(data), size); }
+}
+
+std::size_t Memory::resident() const
+{
+    if (!data) { return 0; }
+
+    const std::size_t pageSize(::sysconf(_SC_PAGESIZE));
+    const std::size_t pages((size + pageSize - 1) / pageSize);
+
+    std::vector<unsigned char> vec(pages);
+    if (-1 == ::mincore(const_cast<char*>(data), size, vec.data())) {
+        return 0;
+    }
+
+    std::size_t count(0);
+    for (auto page : vec) { count += (page & 1); }
+
+    return std::min(count * pageSize, size);
+}
+
+} // namespace mmapped
@@ -30,6 +30,8 @@
 #include <array>
 #include <iostream>
 
+#include "utility/enum-io.hpp"
+
 #include "vts-libs/vts/tileindex.hpp"
 #include "vts-libs/vts/tileset/tilesetindex.hpp"
 
@@ -45,6 +47,38 @@ namespace vts = vtslibs::vts;
 
 namespace mmapped {
 
+/** How to prefault mapped memory:
+ *
+ *  none: pages are faulted lazily on first access
+ *  willneed: kernel is advised to read whole file ahead (asynchronous)
+ *  populate: whole file is faulted in when mapped (MAP_POPULATE, synchronous)
+ */
+UTILITY_GENERATE_ENUM(MapPrefault,
+    ((none))
+    ((willneed))
+    ((populate))
+)
+
+/** Memory mapping options.
+ */
+struct MapOptions {
+    MapPrefault prefault;
+
+    /** Advise kernel to back mapping by transparent huge pages (if supported
+     *  by underlying filesystem).
+     */
+    bool hugepages;
+
+    /** Validate checksums of all trees when opening. Faults in whole file,
+     *  i.e. negates lazy mapping.
+     */
+    bool verify;
+
+    MapOptions()
+        : prefault(MapPrefault::none), hugepages(false), verify(false)
+    {}
+};
+
 /** Memory information.
  */
 class Memory;
@@ -1,3 +1,8 @@
+#include <array>
+#include <cstring>
+
+#include <boost/crc.hpp>
+
 #include "dbglog/dbglog.hpp"
 
 #include "utility/filesystem.hpp"
@@ -19,12 +24,43 @@ const char MM_QTREE_MAGIC[4] = { 'M', 'M', 'Q', 'T' };
 
 } // namespace
 
-QTree::QTree(Memory &memory)
-    : depth_(), data_(), dataSize_()
+namespace JumpTable {
+    /** Leaf value is stored in the lowest byte, offsets have this bit unset.
+     */
+    constexpr std::uint32_t leaf(0x80000000);
+} // namespace JumpTable
+
+namespace TreeFlag {
+    /** Data block is terminated by CRC32 of the rest of the data block.
+     */
+    constexpr std::uint8_t checksum(0x01);
+} // namespace TreeFlag
+
+constexpr unsigned int QTree::defaultJumpDepth;
+
+namespace {
+
+std::uint32_t crc32(const char *data, std::size_t size)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+} // namespace
+
+QTree::QTree(Memory &memory, bool requireChecksum, bool verify)
+    : depth_(), data_(), dataSize_(), jumpDepth_(), jumpTable_()
 {
     auto &f(memory.stream);
 
-    checkHeader(f, MM_QTREE_MAGIC, 2, "mmapped qtree");
+    checkHeader(f, MM_QTREE_MAGIC, 0, "mmapped qtree");
+
+    // jump table depth, (0 in files without jump table)
+    jumpDepth_ = bin::read<std::uint8_t>(f);
+
+    // tree flags (0 in old files)
+    const auto flags(bin::read<std::uint8_t>(f));
 
     // read tree depth (i.e. lod)
     depth_ = bin::read<std::uint8_t>(f);
@@ -36,9 +72,57 @@ QTree::QTree(Memory &memory)
     // align start of data block
     std::size_t dataStart(utility::align(f.tellg(), sizeof(std::uint32_t)));
 
+    // check for truncated file
+    if ((dataStart + dataSize_) > memory.size) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Truncated mmapped qtree: data end at "
+            << (dataStart + dataSize_) << " past file size "
+            << memory.size << ".";
+    }
+
     // remember memory
     data_ = memory.addr(dataStart);
 
+    // data block size without trailing checksum
+    std::size_t dataEnd(dataSize_);
+
+    if (flags & TreeFlag::checksum) {
+        if (dataSize_ < sizeof(std::uint32_t)) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Invalid mmapped qtree data size " << dataSize_ << ".";
+        }
+
+        dataEnd -= sizeof(std::uint32_t);
+
+        // verification touches every page of the tree
+        if (verify) {
+            std::uint32_t stored;
+            std::memcpy(&stored, data_ + dataEnd, sizeof(stored));
+            const auto computed(crc32(data_, dataEnd));
+            if (stored != computed) {
+                LOGTHROW(err2, std::runtime_error)
+                    << "Mmapped qtree checksum mismatch (stored: " << stored
+                    << ", computed: " << computed << ").";
+            }
+        }
+    } else if (requireChecksum) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Mmapped qtree without checksum in checksummed file.";
+    }
+
+    if (jumpDepth_) {
+        // jump table occupies the tail of data block
+        const std::size_t tableSize
+            (sizeof(std::uint32_t) << (2 * jumpDepth_));
+        if ((jumpDepth_ >= depth_) || (tableSize > dataEnd)) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Invalid jump table depth " << jumpDepth_
+                << " in mmapped qtree.";
+        }
+        jumpTable_ = reinterpret_cast<const std::uint32_t*>
+            (data_ + dataEnd - tableSize);
+    }
+
     // skip data
     f.seekg(dataStart + dataSize_);
 }
@@ -57,27 +141,140 @@ inline TileFlag::value_type vts2mm(const vts::QTree::opt_value_type &in)
 
 } // namespace
 
-void QTree::write(std::ostream &f, const vts::QTree &tree)
+namespace {
+
+/** Jump table makes sense only for trees with at least 2 levels of internal
+ *  nodes.
+ */
+unsigned int trimJumpDepth(const vts::QTree &tree, unsigned int jumpDepth)
+{
+    return ((tree.order() >= 2)
+            ? std::min<unsigned int>(jumpDepth, tree.order() - 1)
+            : 0);
+}
+
+} // namespace
+
+std::size_t QTree::size(const vts::QTree &tree, unsigned int jumpDepth
+                        , std::size_t position)
+{
+    jumpDepth = trimJumpDepth(tree, jumpDepth);
+
+    // counts bytes of data block written by QTree::write's converter
+    struct Counter {
+        struct IndexTable {};
+
+        void root(const vts::QTree::opt_value_type&) {
+            size += 4 * sizeof(TileFlag::value_type);
+        }
+
+        IndexTable children(const vts::QTree::opt_value_type &ul
+                            , const vts::QTree::opt_value_type &ur
+                            , const vts::QTree::opt_value_type &ll
+                            , const vts::QTree::opt_value_type &lr)
+        {
+            size += 4 * sizeof(TileFlag::value_type);
+
+            // all internal children but the first one are indexed
+            const int internal(int(!ul) + int(!ur) + int(!ll) + int(!lr));
+            if (internal > 1) {
+                size += (internal - 1) * sizeof(std::uint32_t);
+            }
+            return {};
+        }
+
+        void enter(const IndexTable&, int) {}
+        void leave(const IndexTable&, int) {}
+
+        std::size_t size;
+    } counter{0};
+
+    tree.convert(counter);
+
+    // header: magic, jump table depth, flags, order and data size
+    const std::size_t dataStart
+        (utility::align(position + sizeof(MM_QTREE_MAGIC) + 3
+                        + sizeof(std::uint32_t), sizeof(std::uint32_t)));
+
+    // data, jump table and checksum
+    std::size_t dataSize(counter.size + sizeof(std::uint32_t));
+    if (jumpDepth) {
+        dataSize += (sizeof(std::uint32_t) << (2 * jumpDepth));
+    }
+
+    return dataStart + dataSize - position;
+}
+
+void QTree::write(std::iostream &f, const vts::QTree &tree
+                  , unsigned int jumpDepth)
 {
+    jumpDepth = trimJumpDepth(tree, jumpDepth);
+
     bin::write(f, MM_QTREE_MAGIC); // 4 bytes
-    bin::write(f, std::uint8_t(0)); // reserved
-    bin::write(f, std::uint8_t(0)); // reserved
+    bin::write(f, std::uint8_t(jumpDepth)); // jump table depth
+    bin::write(f, TreeFlag::checksum); // flags
 
     // order (lod)
     bin::write(f, std::uint8_t(tree.order()));
 
-    // make room for data size
-    std::size_t sizePlace(f.tellp());
+    // data size placeholder
+    const std::size_t sizePlace(f.tellp());
+    bin::write(f, std::uint32_t(0));
 
-    // align address after size place
-    f.seekp(utility::align(sizePlace + sizeof(std::uint32_t)
-                           , sizeof(std::uint32_t)));
-    std::size_t dataStart(f.tellp());
+    // align start of data block
+    const std::size_t dataStart(utility::align(f.tellp()
+                                               , sizeof(std::uint32_t)));
+    while (std::size_t(f.tellp()) < dataStart) {
+        bin::write(f, std::uint8_t(0));
+    }
 
     struct Converter {
-        Converter(std::ostream &f) : f(f) {}
+        Converter(std::ostream &f, std::size_t dataStart
+                  , unsigned int jumpDepth)
+            : f(f), dataStart(dataStart), jumpDepth(jumpDepth)
+            , jumpTable(std::size_t(1) << (2 * jumpDepth))
+            , stack{Frame()}
+        {}
+
+        /** Current node.
+         */
+        struct Frame {
+            unsigned int depth;
+            unsigned int x;
+            unsigned int y;
+            Frame(unsigned int depth = 0, unsigned int x = 0
+                  , unsigned int y = 0)
+                : depth(depth), x(x), y(y) {}
+
+            Frame child(int index) const {
+                return Frame(depth + 1, (x << 1) + (index & 1)
+                             , (y << 1) + (index >> 1));
+            }
+        };
+
+        /** Fills jump table cells covered by given node.
+         */
+        void fill(const Frame &node, std::uint32_t value) {
+            if (!jumpDepth || (node.depth > jumpDepth)) { return; }
+            const auto shift(jumpDepth - node.depth);
+            const auto count(1u << shift);
+            const auto x0(node.x << shift);
+            const auto y0(node.y << shift);
+            for (unsigned int j(0); j < count; ++j) {
+                auto *row(&jumpTable[((y0 + j) << jumpDepth) + x0]);
+                std::fill(row, row + count, value);
+            }
+        }
+
+        void fill(const Frame &node, const vts::QTree::opt_value_type &value)
+        {
+            if (!value) { return; }
+            fill(node, JumpTable::leaf | vts2mm(value));
+        }
 
         void root(vts::QTree::opt_value_type value) {
+            fill(stack.back(), value);
+
             // write root value in all nodes
             bin::write(f, vts2mm(value));
             bin::write(f, vts2mm(value));
@@ -92,6 +289,18 @@ void QTree::write(std::ostream &f, const vts::QTree &tree)
                             , const vts::QTree::opt_value_type &ll
                             , const vts::QTree::opt_value_type &lr)
         {
+            // internal node at jump table depth -> remember its data offset
+            const auto &node(stack.back());
+            if (node.depth == jumpDepth) {
+                fill(node, std::uint32_t(std::size_t(f.tellp())
+                                         - dataStart));
+            } else if (node.depth < jumpDepth) {
+                fill(node.child(0), ul);
+                fill(node.child(1), ur);
+                fill(node.child(2), ll);
+                fill(node.child(3), lr);
+            }
+
             // write values for all 4 children
             bin::write(f, vts2mm(ul));
             bin::write(f, vts2mm(ur));
@@ -138,12 +347,16 @@ void QTree::write(std::ostream &f, const vts::QTree &tree)
             addIndex(ll, 2);
             addIndex(lr, 3);
 
-            // move past table space and done
-            f.seekp(pos);
+            // fill table space with placeholders and done
+            while (std::size_t(f.tellp()) < pos) {
+                bin::write(f, std::uint32_t(0));
+            }
             return table;
         }
 
         void enter(const IndexTable &table, int index) {
+            stack.push_back(stack.back().child(index));
+
             const auto indexPos(table[index]);
             if (indexPos < 0) { return; }
 
@@ -161,24 +374,50 @@ void QTree::write(std::ostream &f, const vts::QTree &tree)
             f.seekp(end);
         }
 
-        void leave(const IndexTable&, int) {}
+        void leave(const IndexTable&, int) { stack.pop_back(); }
+
+        void writeJumpTable() {
+            if (!jumpDepth) { return; }
+            for (auto value : jumpTable) { bin::write(f, value); }
+        }
 
         std::ostream &f;
+        std::size_t dataStart;
+        unsigned int jumpDepth;
+        std::vector<std::uint32_t> jumpTable;
+        std::vector<Frame> stack;
     };
 
     // convert tree
     {
-        Converter converter(f);
+        Converter converter(f, dataStart, jumpDepth);
         tree.convert(converter);
+        converter.writeJumpTable();
     }
 
-    // compute data size and write to pre-allocated place
-    std::size_t end(f.tellp());
-    f.seekp(sizePlace);
-    std::uint32_t size(end - dataStart);
-    bin::write(f, size);
+    // data block is patched during conversion, checksum is computed by
+    // reading it back in chunks
+    const std::size_t dataEnd(f.tellp());
+    f.flush();
+    f.seekg(dataStart);
+    {
+        boost::crc_32_type crc;
+        std::array<char, 1 << 16> buffer;
+        for (auto left(dataEnd - dataStart); left; ) {
+            const auto size(std::min(left, buffer.size()));
+            f.read(buffer.data(), size);
+            crc.process_bytes(buffer.data(), size);
+            left -= size;
+        }
 
-    // move back to the end
+        f.seekp(dataEnd);
+        bin::write(f, std::uint32_t(crc.checksum()));
+    }
+
+    // write data size (including checksum)
+    const std::size_t end(f.tellp());
+    f.seekp(sizePlace);
+    bin::write(f, std::uint32_t(end - dataStart));
     f.seekp(end);
 }
 
@@ -186,6 +425,9 @@ QTree::value_type QTree::get(unsigned int x, unsigned int y) const
 {
     if ((x >= size_) || (y >= size_)) { return TileFlag::none; }
 
+    // skip most of the descent if possible
+    if (jumpTable_) { return jump(depth_, size_, x, y); }
+
     MemoryReader reader(data_);
 
     // load root value
@@ -212,6 +454,11 @@ QTree::value_type QTree::get(unsigned int depth, unsigned int x
 
     if ((x >= size) || (y >= size)) { return TileFlag::none; }
 
+    // skip most of the descent if possible
+    if (jumpTable_ && (depth > jumpDepth_)) {
+        return jump(depth, size, x, y);
+    }
+
     MemoryReader reader(data_);
 
     // load root value
@@ -227,6 +474,66 @@ QTree::value_type QTree::get(unsigned int depth, unsigned int x
     return get(reader, Node(size), x, y);
 }
 
+void QTree::range(unsigned int order, unsigned int x, unsigned int y
+                  , value_type *raster) const
+{
+    const auto stride(std::size_t(1) << order);
+
+    forEachInWindow(order, x, y, [&](int xs, int ys, int w, int h
+                                     , value_type value)
+    {
+        for (int j(0); j < h; ++j) {
+            auto *row(raster + (ys + j) * stride + xs);
+            std::fill(row, row + w, value);
+        }
+    }, Filter::white);
+}
+
+bool QTree::any(unsigned int order, unsigned int x, unsigned int y
+                , value_type mask) const
+{
+    bool found(false);
+    forEachInWindow(order, x, y, [&](int, int, int, int, value_type value)
+    {
+        if (value & mask) { found = true; }
+    }, Filter::white);
+    return found;
+}
+
+bool QTree::all(unsigned int order, unsigned int x, unsigned int y
+                , value_type mask) const
+{
+    // window larger than tree has tiles outside
+    if (order > depth_) { return false; }
+
+    bool all(true);
+    forEachInWindow(order, x, y, [&](int, int, int, int, value_type value)
+    {
+        if ((value & mask) != mask) { all = false; }
+    }, Filter::both);
+    return all;
+}
+
+QTree::value_type QTree::jump(unsigned int depth, unsigned int size
+                              , unsigned int x, unsigned int y) const
+{
+    // locate jump table cell
+    const auto shift(depth - jumpDepth_);
+    const auto cx(x >> shift);
+    const auto cy(y >> shift);
+    const auto entry(jumpTable_[(cy << jumpDepth_) + cx]);
+
+    // leaf covering whole cell
+    if (entry & JumpTable::leaf) { return value_type(entry); }
+
+    // internal node: descend from here
+    MemoryReader reader(data_);
+    reader.seek(entry);
+    const unsigned int cellSize(size >> jumpDepth_);
+    return get(reader, Node(cellSize, jumpDepth_, cx * cellSize
+                            , cy * cellSize), x, y);
+}
+
 QTree::value_type QTree::get(MemoryReader &reader, const Node &node
                              , unsigned int x, unsigned int y) const
 {
@@ -49,6 +49,13 @@
  *
  *  Non-leaf nodes are marked by invalid combination (mesh=false,
  *  watertight=true)
+ *
+ *  Tree data can be followed by optional jump table: dense grid of
+ *  (2^jumpDepth)^2 entries where each entry holds either leaf value covering
+ *  the grid cell or an offset of the internal node's data. Depth of the table
+ *  is stored in the first (formerly reserved) header byte and the table
+ *  itself is accounted in data size, therefore older readers simply ignore
+ *  it.
  */
 namespace mmapped {
 
@@ -57,9 +64,15 @@ public:
     typedef std::vector<QTree> list;
     typedef TileFlag::value_type value_type;
 
-    /** Loads QTree from memory at current memory position.
+    /** Default jump table depth used by writer: 1024 entries, 4 KiB.
+     */
+    static constexpr unsigned int defaultJumpDepth = 5;
+
+    /** Loads QTree from memory at current memory position. Missing checksum
+     *  is an error if required. Data checksum (if present) is validated only
+     *  if verify is set since it faults in the whole tree.
      */
-    QTree(Memory &memory);
+    QTree(Memory &memory, bool requireChecksum = false, bool verify = false);
 
     value_type get(unsigned int x, unsigned int y) const;
 
@@ -70,7 +83,47 @@ public:
      */
     value_type get(unsigned int depth, unsigned int x, unsigned int y) const;
 
-    static void write(std::ostream &out, const vts::QTree &tree);
+    /** Fills raster with values of all nodes inside window of size
+     *  (2^order x 2^order) with upper-left corner at (x, y). Window must be
+     *  aligned to its size. Raster is row-major with stride 2^order and must
+     *  be zeroed beforehand; parts of the window outside the tree are left
+     *  untouched.
+     */
+    void range(unsigned int order, unsigned int x, unsigned int y
+               , value_type *raster) const;
+
+    /** Returns true if any node inside window (see range) has any flag from
+     *  mask set.
+     */
+    bool any(unsigned int order, unsigned int x, unsigned int y
+             , value_type mask = TileFlag::any) const;
+
+    /** Returns true if all nodes inside window (see range) have all flags
+     *  from mask set.
+     */
+    bool all(unsigned int order, unsigned int x, unsigned int y
+             , value_type mask) const;
+
+    /** Writes tree to output stream. Jump table of given depth is appended
+     *  (trimmed to tree depth), zero disables jump table.
+     *
+     *  Stream must be readable as well: written data are read back to
+     *  compute the checksum.
+     */
+    static void write(std::iostream &out, const vts::QTree &tree
+                      , unsigned int jumpDepth = defaultJumpDepth);
+
+    /** Number of bytes written by write() when called at given stream
+     *  position (only its alignment matters). Computed without serializing
+     *  the tree.
+     */
+    static std::size_t size(const vts::QTree &tree
+                            , unsigned int jumpDepth = defaultJumpDepth
+                            , std::size_t position = 0);
+
+    /** Depth of jump table, 0 if there is none.
+     */
+    unsigned int jumpDepth() const { return jumpDepth_; }
 
     enum class Filter {
         black, white, both
@@ -97,6 +150,18 @@ private:
     value_type get(MemoryReader &reader, const Node &node
                    , unsigned int x, unsigned int y) const;
 
+    /** Lookup through jump table. Tree is virtually trimmed to given size (at
+     *  given depth). Must be called only when depth > jumpDepth_.
+     */
+    value_type jump(unsigned int depth, unsigned int size
+                    , unsigned int x, unsigned int y) const;
+
+    /** Runs forEachNode in window, see range() for window definition.
+     */
+    template <typename Op>
+    void forEachInWindow(unsigned int order, unsigned int x, unsigned int y
+                         , const Op &op, Filter filter) const;
+
     /** Called from forEachQuad */
     template <typename Op>
     void descend(MemoryReader &reader, const Node &node
@@ -107,6 +172,8 @@ private:
     unsigned int size_;
     const char *data_;
     std::size_t dataSize_;
+    unsigned int jumpDepth_;
+    const std::uint32_t *jumpTable_;
 };
 
 struct QTree::Node {
@@ -388,6 +455,21 @@ void QTree::forEachNode(unsigned int depth, unsigned int x, unsigned int y
     descend(reader, rootNode, op, filter, &limit);
 }
 
+template <typename Op>
+void QTree::forEachInWindow(unsigned int order, unsigned int x, unsigned int y
+                            , const Op &op, Filter filter) const
+{
+    if (order < depth_) {
+        // window is a subtree of a node in trimmed tree
+        forEachNode(depth_ - order, x >> order, y >> order, op, filter);
+        return;
+    }
+
+    // window covers whole tree; only window at origin makes sense
+    if (x || y) { return; }
+    forEachNode(0, 0, 0, op, filter);
+}
+
 template <typename Op>
 void QTree::descend(MemoryReader &reader, const Node &node
                     , const Op &op, Filter filter
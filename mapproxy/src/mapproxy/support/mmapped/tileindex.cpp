@@ -1,3 +1,9 @@
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/iostreams/device/array.hpp>
@@ -24,54 +30,227 @@ namespace {
 
 const char MM_TILEINDEX_MAGIC[4] = { 'M', 'M', 'T', 'I' };
 
+/** Format version:
+ *      0: original format (no checksums)
+ *      1: every tree is checksummed
+ */
+const std::uint8_t MM_TILEINDEX_VERSION(1);
+
 } // namespace
 
-TileIndex::TileIndex(const fs::path &path)
-    : memory_(std::make_shared<Memory>(path))
+TileIndex::TileIndex(const fs::path &path, const MapOptions &options)
+    : memory_(std::make_shared<Memory>(path, options))
 {
-    checkHeader(memory_->stream, MM_TILEINDEX_MAGIC, 2, "mmapped tile index");
+    checkHeader(memory_->stream, MM_TILEINDEX_MAGIC, 0, "mmapped tile index");
+
+    // format version (formerly reserved, i.e. 0) and 1 reserved byte
+    const auto version(bin::read<std::uint8_t>(memory_->stream));
+    if (version > MM_TILEINDEX_VERSION) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Unsupported mmapped tile index version " << int(version)
+            << " in " << path << ".";
+    }
+    memory_->stream.seekg(1, std::ios_base::cur);
 
     // memory stream is positioned just after the header
     const int lods(bin::read<uint8_t>(memory_->stream));
 
     trees_.reserve(lods);
-    for (int lod(0); lod < lods; ++lod) {
-        trees_.emplace_back(*memory_);
+    try {
+        for (int lod(0); lod < lods; ++lod) {
+            trees_.emplace_back(*memory_, version >= 1, options.verify);
+        }
+    } catch (const std::exception &e) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Corrupted mmapped tile index " << path << ": <"
+            << e.what() << ">.";
     }
 }
 
-void TileIndex::write(std::ostream &f, const vts::TileIndex &ti)
+std::size_t TileIndex::resident() const
+{
+    return memory_->resident();
+}
+
+std::size_t TileIndex::size() const
+{
+    return memory_->size;
+}
+
+namespace {
+
+/** Writes tile index header, returns number of LODs (0 for empty index).
+ */
+vts::Lod writeHeader(std::ostream &f, const vts::TileIndex &ti)
 {
     bin::write(f, MM_TILEINDEX_MAGIC); // 4 bytes
-    bin::write(f, std::uint8_t(0)); // reserved
+    bin::write(f, MM_TILEINDEX_VERSION); // version
     bin::write(f, std::uint8_t(0)); // reserved
 
-    if (ti.empty()) { return; }
+    if (ti.empty()) { return 0; }
 
     // lod count (max lod + 1)
-    const auto lodCount(ti.maxLod() + 1);
+    const vts::Lod lodCount(ti.maxLod() + 1);
     bin::write(f, std::uint8_t(lodCount));
+    return lodCount;
+}
+
+/** Calls op(tree) for tree of given LOD, empty tree is used if there is no
+ *  such tree.
+ */
+template <typename Op>
+void withTree(const vts::TileIndex &ti, vts::Lod lod, const Op &op)
+{
+    if (const auto *tree = ti.tree(lod)) {
+        op(*tree);
+    } else {
+        op(vts::QTree(lod));
+    }
+}
+
+/** Runs op(index) for every index in [0, count) in given number of threads
+ *  (including the calling one). First exception thrown by op is rethrown.
+ */
+template <typename Op>
+void parallelFor(std::size_t count, unsigned int threads, const Op &op)
+{
+    std::atomic<std::size_t> next(0);
+    std::mutex mutex;
+    std::exception_ptr error;
+
+    auto worker([&]()
+    {
+        for (;;) {
+            const std::size_t index(next++);
+            if (index >= count) { return; }
+
+            try {
+                op(index);
+            } catch (...) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!error) { error = std::current_exception(); }
+                // stop other workers
+                next = count;
+                return;
+            }
+        }
+    });
+
+    std::vector<std::thread> workers;
+    for (unsigned int i(1); i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &w : workers) { w.join(); }
+
+    if (error) { std::rethrow_exception(error); }
+}
+
+/** Parallel writer. Sizes of all trees are computed first (without
+ *  serialization) to lay out the file; then every tree is written directly
+ *  into its place by its own stream. No tree is held in memory.
+ */
+void writeParallel(const fs::path &path, const vts::TileIndex &ti
+                   , const TileIndex::WriteOptions &options)
+{
+    std::size_t start;
+    vts::Lod lodCount;
+    {
+        std::ofstream f;
+        f.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+        f.open(path.string(), std::ios_base::out | std::ios_base::trunc
+               | std::ios_base::binary);
+        lodCount = writeHeader(f, ti);
+        start = f.tellp();
+        f.close();
+    }
+
+    if (!lodCount) { return; }
+
+    // every tree ends aligned, only the first one can start unaligned
+    std::vector<std::size_t> sizes(lodCount);
+    parallelFor(lodCount, options.threads, [&](std::size_t lod)
+    {
+        withTree(ti, lod, [&](const vts::QTree &tree)
+        {
+            sizes[lod] = QTree::size(tree, options.jumpDepth
+                                     , lod ? 0 : start);
+        });
+    });
+
+    std::vector<std::size_t> offsets(lodCount);
+    std::size_t end(start);
+    for (vts::Lod lod(0); lod < lodCount; ++lod) {
+        offsets[lod] = end;
+        end += sizes[lod];
+    }
+    fs::resize_file(path, end);
+
+    std::mutex progressMutex;
+    parallelFor(lodCount, options.threads, [&](std::size_t lod)
+    {
+        // opened for reading as well, tree is read back to compute checksum
+        std::fstream f;
+        f.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+        f.open(path.string(), std::ios_base::in | std::ios_base::out
+               | std::ios_base::binary);
+        f.seekp(offsets[lod]);
+
+        withTree(ti, lod, [&](const vts::QTree &tree)
+        {
+            QTree::write(f, tree, options.jumpDepth);
+        });
+
+        if (std::size_t(f.tellp()) != (offsets[lod] + sizes[lod])) {
+            LOGTHROW(err2, std::logic_error)
+                << "Mmapped qtree at LOD " << lod << " has different size "
+                "than computed.";
+        }
+        f.close();
+
+        if (options.progress) {
+            std::unique_lock<std::mutex> lock(progressMutex);
+            options.progress(lod, sizes[lod]);
+        }
+    });
+}
+
+} // namespace
+
+void TileIndex::write(std::iostream &f, const vts::TileIndex &ti
+                      , const WriteOptions &options)
+{
+    const auto lodCount(writeHeader(f, ti));
 
     // write all trees
     for (vts::Lod lod(0); lod < lodCount; ++lod) {
-        if (const auto *tree = ti.tree(lod)) {
-            // tree exists, write
-            QTree::write(f, *tree);
-        } else {
-            // tree doesn't exist, write empty
-            QTree::write(f, vts::QTree(lod));
+        const std::size_t start(f.tellp());
+        withTree(ti, lod, [&](const vts::QTree &tree)
+        {
+            QTree::write(f, tree, options.jumpDepth);
+        });
+        if (options.progress) {
+            options.progress(lod, std::size_t(f.tellp()) - start);
         }
     }
 }
 
 void TileIndex::write(const boost::filesystem::path &path
-                      , const vts::TileIndex &ti)
+                      , const vts::TileIndex &ti
+                      , const WriteOptions &options)
 {
-    utility::ofstreambuf f;
+    if (options.threads > 1) {
+        writeParallel(path, ti, options);
+        return;
+    }
+
+    // opened for reading as well, trees are read back to compute checksums
+    std::fstream f;
     f.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    f.open(path.string(), std::ifstream::out | std::ifstream::trunc);
+    f.open(path.string(), std::ios_base::in | std::ios_base::out
+           | std::ios_base::trunc | std::ios_base::binary);
 
-    write(f, ti);
+    write(f, ti, options);
 
     f.close();
 }
@@ -104,6 +283,33 @@ bool TileIndex::validSubtree(vts::Lod lod, const vts::TileId &tileId) const
     return false;
 }
 
+void TileIndex::range(const vts::TileId &origin, unsigned int order
+                      , std::vector<value_type> &raster) const
+{
+    raster.assign(std::size_t(1) << (2 * order), TileFlag::none);
+    if (const auto *t = tree(origin.lod)) {
+        t->range(order, origin.x, origin.y, raster.data());
+    }
+}
+
+bool TileIndex::any(const vts::TileId &origin, unsigned int order
+                    , value_type mask) const
+{
+    if (const auto *t = tree(origin.lod)) {
+        return t->any(order, origin.x, origin.y, mask);
+    }
+    return false;
+}
+
+bool TileIndex::all(const vts::TileId &origin, unsigned int order
+                    , value_type mask) const
+{
+    if (const auto *t = tree(origin.lod)) {
+        return t->all(order, origin.x, origin.y, mask);
+    }
+    return false;
+}
+
 bool TileIndex::validSubtree(const vts::TileId &tileId) const
 {
     return validSubtree(tileId.lod, tileId);
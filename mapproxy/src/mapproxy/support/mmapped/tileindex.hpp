@@ -29,6 +29,7 @@
 
 #include <array>
 #include <iostream>
+#include <functional>
 
 #include "vts-libs/vts/tileindex.hpp"
 #include "vts-libs/vts/tileset/tilesetindex.hpp"
@@ -55,7 +56,8 @@ class TileIndex {
 public:
     typedef TileFlag::value_type value_type;
 
-    TileIndex(const boost::filesystem::path &path);
+    TileIndex(const boost::filesystem::path &path
+              , const MapOptions &options = MapOptions());
 
     /** Find tile value.
      */
@@ -63,23 +65,71 @@ public:
 
     bool validSubtree(vts::Lod lod, const vts::TileId &tileId) const;
 
+    /** Fetches flags of all tiles in window of size (2^order x 2^order) at
+     *  origin's LOD in a single tree traversal. Origin must be aligned to
+     *  window size. Raster is row-major with stride 2^order.
+     */
+    void range(const vts::TileId &origin, unsigned int order
+               , std::vector<value_type> &raster) const;
+
+    /** Checks whether any tile in window (see range) has any flag from mask.
+     */
+    bool any(const vts::TileId &origin, unsigned int order
+             , value_type mask = TileFlag::any) const;
+
+    /** Checks whether all tiles in window (see range) have all flags from
+     *  mask.
+     */
+    bool all(const vts::TileId &origin, unsigned int order
+             , value_type mask) const;
+
     bool validSubtree(const vts::TileId &tileId) const;
 
     /** Get quad tree for given lod.
      */
     const QTree* tree(vts::Lod lod) const;
 
+    /** Number of bytes of index file resident in memory.
+     */
+    std::size_t resident() const;
+
+    /** Size of index file.
+     */
+    std::size_t size() const;
+
     value_type checkMask(const vts::TileId &tileId, QTree::value_type mask)
         const;
 
+    struct WriteOptions {
+        /** Jump table depth, see QTree::write.
+         */
+        unsigned int jumpDepth;
+
+        /** Number of threads writing trees in parallel (used only when
+         *  writing to a file). Every tree is written directly into its place
+         *  in the file, no tree is buffered in memory.
+         */
+        unsigned int threads;
+
+        /** Called after each tree is written with its LOD and size.
+         */
+        std::function<void(vts::Lod, std::size_t)> progress;
+
+        WriteOptions()
+            : jumpDepth(QTree::defaultJumpDepth), threads(1)
+        {}
+    };
+
     /** Save vts TileIndex into this mmapped tile index.
      */
-    static void write(std::ostream &out, const vts::TileIndex &ti);
+    static void write(std::iostream &out, const vts::TileIndex &ti
+                      , const WriteOptions &options = WriteOptions());
 
     /** Save vts TileIndex into this mmapped tile index.
      */
     static void write(const boost::filesystem::path &path
-                      , const vts::TileIndex &ti);
+                      , const vts::TileIndex &ti
+                      , const WriteOptions &options = WriteOptions());
 
 private:
     std::shared_ptr<Memory> memory_;
@@ -35,8 +35,9 @@ class Index {
 public:
     typedef std::shared_ptr<Index> pointer;
 
-    Index(unsigned int metaBinaryOrder, const boost::filesystem::path &path)
-        : tileIndex(path)
+    Index(unsigned int metaBinaryOrder, const boost::filesystem::path &path
+          , const MapOptions &options = MapOptions())
+        : tileIndex(path, options)
         , metaBinaryOrder_(metaBinaryOrder)
     {}
 
@@ -0,0 +1,473 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+
+#include "dbglog/dbglog.hpp"
+
+#include "math/math.hpp"
+#include "geo/coordinates.hpp"
+
+#include "vts-libs/vts/math.hpp"
+#include "vts-libs/vts/csconvertor.hpp"
+
+#include "../error.hpp"
+
+#include "./rtin.hpp"
+#include "./srs.hpp"
+
+namespace ublas = boost::numeric::ublas;
+
+namespace {
+
+/** Layout of RTIN triangle hierarchy for given tile size (number of edges per
+ *  side). Triangles are stored in implicit binary tree, each triangle is
+ *  represented by endpoints of its hypotenuse; right-angle vertex is computed
+ *  on the fly.
+ *
+ *  Leaf triangles (with legs of one grid edge) are not stored at all.
+ */
+class RtinLayout {
+public:
+    typedef std::shared_ptr<const RtinLayout> pointer;
+
+    RtinLayout(int tileSize);
+
+    /** Returns (shared) layout for given tile size.
+     */
+    static pointer get(int tileSize);
+
+    const int tileSize;
+    const int gridSize;
+    const int triangleCount;
+    const int parentTriangleCount;
+
+    /** ax, ay, bx, by for each triangle
+     */
+    std::vector<std::uint16_t> coords;
+};
+
+RtinLayout::RtinLayout(int tileSize)
+    : tileSize(tileSize), gridSize(tileSize + 1)
+    , triangleCount(tileSize * tileSize * 2 - 2)
+    , parentTriangleCount(triangleCount - tileSize * tileSize)
+    , coords(4 * triangleCount)
+{
+    for (int i(0); i < triangleCount; ++i) {
+        int id(i + 2);
+        int ax(0), ay(0), bx(0), by(0), cx(0), cy(0);
+
+        if (id & 1) {
+            // bottom-left root triangle
+            bx = by = cx = tileSize;
+        } else {
+            // top-right root triangle
+            ax = ay = cy = tileSize;
+        }
+
+        // descend from root to this triangle
+        while ((id >>= 1) > 1) {
+            const int mx((ax + bx) >> 1);
+            const int my((ay + by) >> 1);
+            if (id & 1) {
+                // left half
+                bx = ax; by = ay;
+                ax = cx; ay = cy;
+            } else {
+                // right half
+                ax = bx; ay = by;
+                bx = cx; by = cy;
+            }
+            cx = mx; cy = my;
+        }
+
+        auto *c(&coords[4 * i]);
+        c[0] = ax; c[1] = ay; c[2] = bx; c[3] = by;
+    }
+}
+
+RtinLayout::pointer RtinLayout::get(int tileSize)
+{
+    static std::mutex mutex;
+    static std::map<int, pointer> layouts;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    auto &layout(layouts[tileSize]);
+    if (!layout) { layout = std::make_shared<RtinLayout>(tileSize); }
+    return layout;
+}
+
+class Rtin {
+public:
+    Rtin(const RtinLayout &layout)
+        : layout_(layout), size_(layout.gridSize)
+        , valid_(size_ * size_, false)
+        , local_(size_ * size_), phys_(size_ * size_)
+        , errors_(size_ * size_, 0.0)
+        , indices_(size_ * size_, -1)
+    {}
+
+    void set(int x, int y, const math::Point3 &local
+             , const math::Point3 &phys)
+    {
+        const auto i(index(x, y));
+        valid_[i] = true;
+        local_[i] = local;
+        phys_[i] = phys;
+    }
+
+    /** Computes 3D area and projected area of full-resolution mesh, i.e. the
+     *  same values simplifyMesh would compute from meshFromNode output.
+     */
+    std::pair<double, double> area() const;
+
+    /** Computes approximation error of all triangles in one pass, from the
+     *  finest level up.
+     */
+    void computeErrors();
+
+    /** Finds lowest error threshold that produces mesh with at most faceCount
+     *  faces.
+     */
+    double threshold(std::size_t faceCount) const;
+
+    /** Generates mesh for given error threshold.
+     */
+    void mesh(geometry::Mesh &mesh, double maxError);
+
+private:
+    int index(int x, int y) const { return y * size_ + x; }
+
+    const math::Point3* local(int x, int y) const {
+        const auto i(index(x, y));
+        return valid_[i] ? &local_[i] : nullptr;
+    }
+
+    bool split(int ax, int ay, int cx, int cy, int mx, int my
+               , double maxError) const
+    {
+        return ((std::abs(ax - cx) + std::abs(ay - cy) > 1)
+                && (errors_[index(mx, my)] > maxError));
+    }
+
+    /** Resolves vertices of unsplit triangle (a, b, c), c being the
+     *  right-angle vertex. Returns false if there is nothing to emit.
+     *
+     *  Leaf triangle with one invalid hypotenuse endpoint is replaced by
+     *  triangle over the other diagonal of its grid cell (as meshFromNode
+     *  does); only one of the cell's two triangles emits it.
+     */
+    bool face(int ax, int ay, int bx, int by, int cx, int cy
+              , int &a, int &b, int &c) const;
+
+    std::size_t count(int ax, int ay, int bx, int by, int cx, int cy
+                      , double maxError) const;
+
+    void mesh(geometry::Mesh &mesh, int ax, int ay, int bx, int by
+              , int cx, int cy, double maxError);
+
+    std::size_t count(double maxError) const {
+        const int max(layout_.tileSize);
+        return (count(0, 0, max, max, max, 0, maxError)
+                + count(max, max, 0, 0, 0, max, maxError));
+    }
+
+    int vertex(geometry::Mesh &mesh, int i) {
+        auto &vi(indices_[i]);
+        if (vi < 0) {
+            vi = mesh.vertices.size();
+            mesh.vertices.push_back(local_[i]);
+        }
+        return vi;
+    }
+
+    const RtinLayout &layout_;
+    const int size_;
+
+    std::vector<bool> valid_;
+    math::Points3d local_;
+    math::Points3d phys_;
+    std::vector<double> errors_;
+    std::vector<int> indices_;
+};
+
+std::pair<double, double> Rtin::area() const
+{
+    std::pair<double, double> res(0.0, 0.0);
+
+    const auto flat([](const math::Point3 *p, math::Point3 &tmp)
+                    -> const math::Point3*
+    {
+        if (!p) { return nullptr; }
+        tmp = *p;
+        tmp(2) = 0.0;
+        return &tmp;
+    });
+
+    math::Point3 f00, f01, f10, f11;
+    for (int j(0), je(layout_.tileSize); j < je; ++j) {
+        for (int i(0), ie(layout_.tileSize); i < ie; ++i) {
+            const auto *v00(local(i, j));
+            const auto *v01(local(i + 1, j));
+            const auto *v10(local(i, j + 1));
+            const auto *v11(local(i + 1, j + 1));
+
+            res.first += std::get<0>(quadArea(v00, v01, v10, v11));
+            res.second += std::get<0>
+                (quadArea(flat(v00, f00), flat(v01, f01)
+                          , flat(v10, f10), flat(v11, f11)));
+        }
+    }
+
+    return res;
+}
+
+void Rtin::computeErrors()
+{
+    const auto invalid(std::numeric_limits<double>::infinity());
+    const auto *coords(layout_.coords.data());
+
+    for (int t(layout_.triangleCount - 1); t >= 0; --t) {
+        const auto *c(coords + 4 * t);
+        const int ax(c[0]), ay(c[1]), bx(c[2]), by(c[3]);
+        const int mx((ax + bx) >> 1), my((ay + by) >> 1);
+        const int cx(mx + my - ay), cy(my + ax - mx);
+
+        const auto a(index(ax, ay));
+        const auto b(index(bx, by));
+        const auto m(index(mx, my));
+        auto &error(errors_[m]);
+
+        if (valid_[a] && valid_[b] && valid_[m] && valid_[index(cx, cy)]) {
+            // distance of real midpoint from the middle of hypotenuse
+            const math::Point3 mid(0.5 * (phys_[a] + phys_[b]));
+            error = std::max(error, double(ublas::norm_2(phys_[m] - mid)));
+        } else {
+            // triangle touches invalid sample -> must be split to the grid
+            // resolution
+            error = invalid;
+        }
+
+        if (t < layout_.parentTriangleCount) {
+            // accumulate error from children
+            error = std::max
+                ({ error
+                   , errors_[index((ax + cx) >> 1, (ay + cy) >> 1)]
+                   , errors_[index((bx + cx) >> 1, (by + cy) >> 1)] });
+        }
+    }
+}
+
+std::size_t Rtin::count(int ax, int ay, int bx, int by, int cx, int cy
+                        , double maxError) const
+{
+    const int mx((ax + bx) >> 1), my((ay + by) >> 1);
+    if (split(ax, ay, cx, cy, mx, my, maxError)) {
+        return (count(cx, cy, ax, ay, mx, my, maxError)
+                + count(bx, by, cx, cy, mx, my, maxError));
+    }
+
+    int a, b, c;
+    return face(ax, ay, bx, by, cx, cy, a, b, c);
+}
+
+bool Rtin::face(int ax, int ay, int bx, int by, int cx, int cy
+                , int &a, int &b, int &c) const
+{
+    a = index(ax, ay);
+    b = index(bx, by);
+    c = index(cx, cy);
+    if (valid_[a] && valid_[b] && valid_[c]) { return true; }
+
+    // only leaf with valid right-angle vertex and exactly one valid
+    // hypotenuse endpoint
+    if ((std::abs(ax - cx) + std::abs(ay - cy) != 1)
+        || !valid_[c] || (valid_[a] == valid_[b]))
+    {
+        return false;
+    }
+
+    // opposite cell corner; sibling triangle has c and d swapped -> emit
+    // only from the one with lower right-angle vertex index
+    const auto d(index(ax + bx - cx, ay + by - cy));
+    if (!valid_[d] || (d < c)) { return false; }
+
+    (valid_[a] ? b : a) = d;
+    return true;
+}
+
+double Rtin::threshold(std::size_t faceCount) const
+{
+    // all finite errors are candidate thresholds
+    std::vector<double> candidates(1, 0.0);
+    for (const auto error : errors_) {
+        if (std::isfinite(error)) { candidates.push_back(error); }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end())
+                     , candidates.end());
+
+    // face count is non-increasing function of threshold; check the coarsest
+    // mesh first since holes can force more faces than budget allows
+    std::size_t lo(0), hi(candidates.size() - 1);
+    if (count(candidates[hi]) > faceCount) { return candidates[hi]; }
+
+    while (lo < hi) {
+        const auto mid((lo + hi) / 2);
+        if (count(candidates[mid]) <= faceCount) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    return candidates[lo];
+}
+
+void Rtin::mesh(geometry::Mesh &mesh, int ax, int ay, int bx, int by
+                , int cx, int cy, double maxError)
+{
+    const int mx((ax + bx) >> 1), my((ay + by) >> 1);
+    if (split(ax, ay, cx, cy, mx, my, maxError)) {
+        this->mesh(mesh, cx, cy, ax, ay, mx, my, maxError);
+        this->mesh(mesh, bx, by, cx, cy, mx, my, maxError);
+        return;
+    }
+
+    int a, b, c;
+    if (!face(ax, ay, bx, by, cx, cy, a, b, c)) { return; }
+
+    // grid's Y axis points down, keep faces counter-clockwise in local space
+    const auto x([this](int i) { return i % size_; });
+    const auto y([this](int i) { return i / size_; });
+    if (((x(b) - x(a)) * (y(c) - y(a)) - (y(b) - y(a)) * (x(c) - x(a))) > 0) {
+        std::swap(b, c);
+    }
+
+    const auto va(vertex(mesh, a));
+    const auto vb(vertex(mesh, b));
+    const auto vc(vertex(mesh, c));
+    mesh.addFace(va, vb, vc);
+}
+
+void Rtin::mesh(geometry::Mesh &mesh, double maxError)
+{
+    const int max(layout_.tileSize);
+    this->mesh(mesh, 0, 0, max, max, max, 0, maxError);
+    this->mesh(mesh, max, max, 0, 0, 0, max, maxError);
+}
+
+} // namespace
+
+bool rtinCompatible(const math::Size2 &edges)
+{
+    return ((edges.width == edges.height)
+            && (edges.width >= 2) && (edges.width <= 4096)
+            && !(edges.width & (edges.width - 1)));
+}
+
+std::tuple<geometry::Mesh, bool>
+rtinMeshFromNode(const vts::NodeInfo &nodeInfo, const math::Size2 &edges
+                 , const HeightSampler &heights
+                 , const TileFacesCalculator &tileFacesCalculator
+                 , const boost::optional<std::string> &geoidGrid)
+{
+    std::tuple<geometry::Mesh, bool> res;
+    auto &fullyCovered(std::get<1>(res) = false);
+
+    if (!rtinCompatible(edges)) {
+        LOGTHROW(err2, Error)
+            << "Grid of " << edges << " edges cannot be meshed via RTIN.";
+    }
+
+    const auto extents(nodeInfo.extents());
+    const auto ts(math::size(extents));
+
+    // one tile pixel
+    math::Size2f px(ts.width / edges.width, ts.height / edges.height);
+
+    // get node coverage
+    auto coverage(nodeInfo.coverageMask
+                  (vts::NodeInfo::CoverageType::grid
+                   , math::Size2(edges.width + 1, edges.height + 1)
+                   , 1));
+
+    if (coverage.empty()) { return res; }
+    fullyCovered = coverage.full();
+
+    const auto layout(RtinLayout::get(edges.width));
+    Rtin rtin(*layout);
+
+    const auto g2l(geo::geo2local(extents));
+    const auto conv(sds2phys(nodeInfo, geoidGrid));
+
+    // sample grid: vertices both in local and physical space
+    bool valid(false);
+    for (int j(0), je(edges.height); j <= je; ++j) {
+        auto y(extents.ur(1) - j * px.height);
+        for (int i(0), ie(edges.width); i <= ie; ++i) {
+            if (!coverage.get(i, j)) { continue; }
+
+            // sample height
+            double height(0.0);
+            if (heights && !heights(i, j, height)) {
+                fullyCovered = false;
+                continue;
+            }
+
+            const math::Point3 p(extents.ll(0) + i * px.width, y, height);
+            rtin.set(i, j, math::transform(g2l, p), conv(p));
+            valid = true;
+        }
+    }
+
+    if (!valid) { return res; }
+
+    // calculate number of faces
+    const auto area(rtin.area());
+    const int faceCount(tileFacesCalculator(area.first, area.second));
+
+    rtin.computeErrors();
+    const auto maxError(rtin.threshold(faceCount));
+
+    auto &lm(std::get<0>(res));
+    rtin.mesh(lm, maxError);
+
+    LOG(info1)
+        << "Generated RTIN mesh with " << lm.faces.size()
+        << " faces (should be at most " << faceCount
+        << ", max error: " << maxError << ").";
+
+    return res;
+}
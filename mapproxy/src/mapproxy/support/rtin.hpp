@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef mapproxy_support_rtin_hpp_included_
+#define mapproxy_support_rtin_hpp_included_
+
+#include <tuple>
+
+#include <boost/optional.hpp>
+
+#include "geometry/mesh.hpp"
+
+#include "vts-libs/vts/nodeinfo.hpp"
+
+#include "./mesh.hpp"
+
+namespace vts = vtslibs::vts;
+
+/** Returns true if grid with given number of edges can be meshed via RTIN,
+ *  i.e. it is square with power-of-two number of edges per side.
+ */
+bool rtinCompatible(const math::Size2 &edges);
+
+/** Generates already simplified mesh directly from height grid using
+ *  right-triangulated irregular network (RTIN).
+ *
+ *  Vertex approximation error is computed in a single bottom-up pass in
+ *  physical space (so it accounts for body curvature) and error threshold is
+ *  chosen to fit into the face budget computed by tileFacesCalculator (same
+ *  metric as in simplifyMesh).
+ *
+ *  Coverage and sample validity is handled as in meshFromNode: triangles
+ *  touching any invalid sample are split down to the grid resolution and only
+ *  fully valid grid triangles are output.
+ *
+ *  Output mesh is in the same local coordinates as the one from
+ *  meshFromNode, i.e. it can be directly used in addSkirt, meshCoverageMask
+ *  and addSubMesh.
+ *
+ *  Grid must be rtinCompatible.
+ */
+std::tuple<geometry::Mesh, bool>
+rtinMeshFromNode(const vts::NodeInfo &nodeInfo, const math::Size2 &edges
+                 , const HeightSampler &heights
+                 , const TileFacesCalculator &tileFacesCalculator
+                 , const boost::optional<std::string> &geoidGrid);
+
+#endif // mapproxy_support_rtin_hpp_included_
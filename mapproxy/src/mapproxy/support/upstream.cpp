@@ -0,0 +1,386 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <list>
+#include <ctime>
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+#include <boost/crc.hpp>
+
+#include "dbglog/dbglog.hpp"
+
+#include "./upstream.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+typedef utility::ResourceFetcher::Query Query;
+typedef utility::ResourceFetcher::MultiQuery MultiQuery;
+
+typedef UpstreamFetcher::Response Response;
+
+/** Temporary files are being written by other threads, never touch them.
+ */
+bool isTmp(const fs::path &path)
+{
+    return path.extension() == ".tmp";
+}
+
+/** Disk cache. Each response is stored in separate file:
+ *      url\n
+ *      expires contentType\n
+ *      data
+ */
+class DiskCache {
+public:
+    DiskCache(const fs::path &root, std::size_t limit)
+        : root_(root), limit_(limit), size_()
+    {
+        if (!limit_) { return; }
+        create_directories(root_);
+
+        // account current content
+        boost::system::error_code ec;
+        for (fs::directory_iterator idir(root_, ec), edir; idir != edir;
+             idir.increment(ec))
+        {
+            if (isTmp(idir->path())) { continue; }
+            size_ += file_size(idir->path(), ec);
+        }
+    }
+
+    Response::pointer load(const std::string &url) const;
+
+    void store(const std::string &url, const Response &response);
+
+private:
+    fs::path filePath(const std::string &url) const {
+        // NB: cache is shared between runs -> no std::hash
+        boost::crc_32_type crc;
+        crc.process_bytes(url.data(), url.size());
+
+        std::ostringstream os;
+        os << std::hex << std::setw(8) << std::setfill('0')
+           << crc.checksum();
+        return root_ / os.str();
+    }
+
+    void shrink();
+
+    const fs::path root_;
+    const std::size_t limit_;
+
+    std::mutex mutex_;
+    std::size_t size_;
+};
+
+Response::pointer DiskCache::load(const std::string &url) const
+{
+    if (!limit_) { return {}; }
+
+    std::ifstream f(filePath(url).string(), std::ios::binary);
+    if (!f) { return {}; }
+
+    // check url to detect hash collisions
+    std::string storedUrl;
+    if (!std::getline(f, storedUrl) || (storedUrl != url)) { return {}; }
+
+    auto response(std::make_shared<Response>());
+    f >> response->expires;
+    f.get();
+    if (!std::getline(f, response->contentType)) { return {}; }
+
+    response->data = std::make_shared<std::string>
+        (std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    if (f.bad()) { return {}; }
+
+    return response;
+}
+
+void DiskCache::store(const std::string &url, const Response &response)
+{
+    if (!limit_) { return; }
+
+    const auto path(filePath(url));
+    const auto tmpPath(fs::unique_path(path.string() + ".%%%%-%%%%.tmp"));
+    std::size_t written(0);
+    try {
+        {
+            std::ofstream f;
+            f.exceptions(std::ios::badbit | std::ios::failbit);
+            f.open(tmpPath.string(), std::ios::binary | std::ios::trunc);
+            f << url << '\n' << response.expires << ' '
+              << response.contentType << '\n';
+            f.write(response.data->data(), response.data->size());
+            written = f.tellp();
+        }
+        fs::rename(tmpPath, path);
+    } catch (const std::exception &e) {
+        LOG(warn2) << "Unable to store upstream content in " << path
+                   << ": <" << e.what() << ">.";
+        boost::system::error_code ec;
+        fs::remove(tmpPath, ec);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_ += written;
+    if (size_ > (limit_ << 20)) { shrink(); }
+}
+
+void DiskCache::shrink()
+{
+    // NB: called under lock; drop oldest files until we get under 90% of
+    // limit
+    typedef std::pair<std::time_t, fs::path> Item;
+    std::vector<Item> items;
+
+    boost::system::error_code ec;
+    std::size_t size(0);
+    for (fs::directory_iterator idir(root_, ec), edir; idir != edir;
+         idir.increment(ec))
+    {
+        if (isTmp(idir->path())) { continue; }
+        size += file_size(idir->path(), ec);
+        items.emplace_back(last_write_time(idir->path(), ec), idir->path());
+    }
+
+    std::sort(items.begin(), items.end());
+
+    const std::size_t target((limit_ << 20) / 10 * 9);
+    for (const auto &item : items) {
+        if (size <= target) { break; }
+        const auto fsize(file_size(item.second, ec));
+        if (fs::remove(item.second, ec)) { size -= fsize; }
+    }
+
+    size_ = size;
+}
+
+/** Memory LRU cache.
+ */
+class MemoryCache {
+public:
+    MemoryCache(std::size_t limit) : limit_(limit << 20), size_() {}
+
+    // NB: both functions must be called under external lock
+    Response::pointer get(const std::string &url);
+    void put(const std::string &url, const Response::pointer &response);
+
+private:
+    typedef std::list<std::pair<std::string, Response::pointer>> Lru;
+
+    const std::size_t limit_;
+    std::size_t size_;
+    Lru lru_;
+    std::unordered_map<std::string, Lru::iterator> index_;
+};
+
+Response::pointer MemoryCache::get(const std::string &url)
+{
+    auto findex(index_.find(url));
+    if (findex == index_.end()) { return {}; }
+    lru_.splice(lru_.begin(), lru_, findex->second);
+    return findex->second->second;
+}
+
+void MemoryCache::put(const std::string &url
+                      , const Response::pointer &response)
+{
+    const auto size(response->data->size());
+    if (size > limit_) { return; }
+
+    auto findex(index_.find(url));
+    if (findex != index_.end()) {
+        size_ -= findex->second->second->data->size();
+        lru_.erase(findex->second);
+        index_.erase(findex);
+    }
+
+    lru_.emplace_front(url, response);
+    index_.emplace(url, lru_.begin());
+    size_ += size;
+
+    while (size_ > limit_) {
+        const auto &last(lru_.back());
+        size_ -= last.second->data->size();
+        index_.erase(last.first);
+        lru_.pop_back();
+    }
+}
+
+} // namespace
+
+struct UpstreamFetcher::Detail
+    : std::enable_shared_from_this<UpstreamFetcher::Detail>
+{
+    Detail(const utility::ResourceFetcher &fetcher, const Options &options)
+        : fetcher(fetcher), options(options)
+        , memory(options.memoryLimit)
+        , disk(options.root, options.diskLimit)
+    {}
+
+    void fetch(const std::string &url, const Callback &callback);
+
+    void fetchUpstream(const std::string &url
+                       , const Response::pointer &stale);
+
+    /** Finishes all pending requests for given url.
+     */
+    void finish(const std::string &url, const Response::pointer &response
+                , const std::exception_ptr &error = {});
+
+    const utility::ResourceFetcher &fetcher;
+    const Options options;
+
+    std::mutex mutex;
+    MemoryCache memory;
+    DiskCache disk;
+
+    /** Requests waiting for upstream data, by url.
+     */
+    std::unordered_map<std::string, std::vector<Callback>> pending;
+};
+
+void UpstreamFetcher::Detail::fetch(const std::string &url
+                                    , const Callback &callback)
+{
+    const auto now(std::time(nullptr));
+
+    Response::pointer stale;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if ((stale = memory.get(url)) && stale->maxAge(now)) {
+            lock.unlock();
+            callback(stale, {});
+            return;
+        }
+
+        // coalesce with running request if any
+        auto &callbacks(pending[url]);
+        callbacks.push_back(callback);
+        if (callbacks.size() > 1) { return; }
+    }
+
+    // first one, try disk cache
+    if (auto response = disk.load(url)) {
+        if (response->maxAge(now)) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                memory.put(url, response);
+            }
+            finish(url, response);
+            return;
+        }
+        if (!stale) { stale = response; }
+    }
+
+    fetchUpstream(url, stale);
+}
+
+void UpstreamFetcher::Detail::fetchUpstream(const std::string &url
+                                            , const Response::pointer &stale)
+{
+    auto self(shared_from_this());
+
+    fetcher.perform(Query(url).reuse(true).timeout(options.timeout)
+                    , [self, url, stale](const MultiQuery &query)
+    {
+        try {
+            const auto &body(query.front().get());
+            const auto now(std::time(nullptr));
+
+            auto response(std::make_shared<Response>());
+            response->data = std::make_shared<std::string>(body.data);
+            response->contentType = body.contentType;
+
+            // honor upstream expiration, use default if not provided
+            response->expires
+                = ((body.expires >= 0) ? body.expires
+                   : (now + self->options.defaultMaxAge));
+
+            if (response->maxAge(now)) {
+                {
+                    std::unique_lock<std::mutex> lock(self->mutex);
+                    self->memory.put(url, response);
+                }
+                self->disk.store(url, *response);
+            }
+
+            self->finish(url, response);
+        } catch (const std::exception &e) {
+            if (stale) {
+                // upstream failure, better than nothing
+                LOG(warn2) << "Upstream fetch of <" << url << "> failed ("
+                           << e.what() << "), using stale content.";
+                self->finish(url, stale);
+                return;
+            }
+            self->finish(url, {}, std::current_exception());
+        }
+    });
+}
+
+void UpstreamFetcher::Detail::finish(const std::string &url
+                                     , const Response::pointer &response
+                                     , const std::exception_ptr &error)
+{
+    std::vector<Callback> callbacks;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto fpending(pending.find(url));
+        if (fpending == pending.end()) { return; }
+        std::swap(callbacks, fpending->second);
+        pending.erase(fpending);
+    }
+
+    for (const auto &callback : callbacks) {
+        try {
+            callback(response, error);
+        } catch (const std::exception &e) {
+            LOG(err2) << "Upstream fetch callback failed: <"
+                      << e.what() << ">.";
+        }
+    }
+}
+
+UpstreamFetcher::UpstreamFetcher(const utility::ResourceFetcher &fetcher
+                                 , const Options &options)
+    : detail_(std::make_shared<Detail>(fetcher, options))
+{}
+
+void UpstreamFetcher::fetch(const std::string &url, const Callback &callback)
+{
+    detail().fetch(url, callback);
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef mapproxy_support_upstream_hpp_included_
+#define mapproxy_support_upstream_hpp_included_
+
+#include <ctime>
+#include <string>
+#include <memory>
+#include <exception>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include "utility/resourcefetcher.hpp"
+
+/** Fetches content from upstream (remote) servers.
+ *
+ *  * fetched content is kept in memory LRU cache and optionally in disk cache
+ *    (shared between all processes and runs using the same cache root)
+ *  * content expiration as reported by upstream (i.e. Cache-Control/Expires)
+ *    is honored; default max age is used when upstream tells nothing
+ *  * concurrent requests for the same URL are coalesced into single upstream
+ *    request
+ *  * upstream connections are reused (keep-alive, per host pools are
+ *    maintained by underlying fetcher)
+ *
+ *  Underlying fetcher is provided by caller; any utility::ResourceFetcher
+ *  implementation can be used.
+ */
+class UpstreamFetcher : boost::noncopyable {
+public:
+    struct Options {
+        /** Memory cache limit (in MB). Zero disables memory cache.
+         */
+        std::size_t memoryLimit;
+
+        /** Disk cache limit (in MB). Zero disables disk cache.
+         */
+        std::size_t diskLimit;
+
+        /** Disk cache root.
+         */
+        boost::filesystem::path root;
+
+        /** Max age (in seconds) used when upstream provides no expiration
+         *  information.
+         */
+        long defaultMaxAge;
+
+        /** Upstream request timeout (in milliseconds).
+         */
+        long timeout;
+
+        Options()
+            : memoryLimit(256), diskLimit(0), defaultMaxAge(3600)
+            , timeout(10000)
+        {}
+    };
+
+    struct Response {
+        typedef std::shared_ptr<const Response> pointer;
+
+        std::shared_ptr<const std::string> data;
+        std::string contentType;
+
+        /** Expiration time. Content is not cached if already expired.
+         */
+        std::time_t expires;
+
+        Response() : expires() {}
+
+        /** Remaining max age (in seconds), at least zero.
+         */
+        long maxAge(std::time_t now = std::time(nullptr)) const {
+            return (expires > now) ? (expires - now) : 0;
+        }
+    };
+
+    /** Completion callback. Called exactly once, either with valid response
+     *  or with an error.
+     */
+    typedef std::function<void(const Response::pointer &response
+                               , const std::exception_ptr &error)> Callback;
+
+    UpstreamFetcher(const utility::ResourceFetcher &fetcher
+                    , const Options &options);
+
+    /** Fetches content at given URL. Callback may be called from any thread
+     *  (even from this call).
+     */
+    void fetch(const std::string &url, const Callback &callback);
+
+    struct Detail;
+
+private:
+    std::shared_ptr<Detail> detail_;
+    Detail& detail() { return *detail_; }
+};
+
+#endif // mapproxy_support_upstream_hpp_included_
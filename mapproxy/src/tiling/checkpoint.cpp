@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstdint>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include "dbglog/dbglog.hpp"
+
+#include "utility/path.hpp"
+
+#include "vts-libs/vts/io.hpp"
+
+#include "./checkpoint.hpp"
+
+namespace fs = boost::filesystem;
+namespace ba = boost::algorithm;
+
+namespace {
+
+const std::string Magic("mapproxy-tiling-checkpoint 1");
+
+fs::path indexPath(const fs::path &dir, unsigned int shard)
+{
+    return dir / ("shard-" + boost::lexical_cast<std::string>(shard) + ".ti");
+}
+
+fs::path checkpointPath(const fs::path &dir, unsigned int shard)
+{
+    return dir / ("shard-" + boost::lexical_cast<std::string>(shard)
+                  + ".checkpoint");
+}
+
+/** Reads checkpoint file. Returns false if file does not exist.
+ */
+bool readCheckpoint(const fs::path &path, ShardState &state)
+{
+    std::ifstream f(path.string());
+    if (!f) { return false; }
+
+    std::string line;
+    if (!std::getline(f, line) || (line != Magic)) {
+        LOGTHROW(err2, std::runtime_error)
+            << "File " << path << " is not a tiling checkpoint.";
+    }
+
+    state.config.clear();
+    state.done.clear();
+    state.complete = false;
+
+    while (std::getline(f, line)) {
+        if (ba::starts_with(line, "config ")) {
+            state.config = line.substr(7);
+        } else if (ba::starts_with(line, "shard ")) {
+            const auto slash(line.find('/'));
+            state.shard = boost::lexical_cast<unsigned int>
+                (line.substr(6, slash - 6));
+            state.count = boost::lexical_cast<unsigned int>
+                (line.substr(slash + 1));
+        } else if (ba::starts_with(line, "done ")) {
+            state.done.insert(boost::lexical_cast<vts::TileId>
+                              (line.substr(5)));
+        } else if (line == "complete") {
+            state.complete = true;
+        }
+    }
+
+    return true;
+}
+
+void checkJob(const fs::path &dir, const ShardState &stored
+              , const std::string &config, unsigned int shard
+              , unsigned int count)
+{
+    if ((stored.config != config) || (stored.shard != shard)
+        || (stored.count != count))
+    {
+        LOGTHROW(err2, std::runtime_error)
+            << "Shard " << shard << " in " << dir
+            << " belongs to a different tiling job; remove the directory "
+            "to start over.";
+    }
+}
+
+} // namespace
+
+bool loadShard(const fs::path &dir, ShardState &state, vts::TileIndex &ti)
+{
+    ShardState stored;
+    if (!readCheckpoint(checkpointPath(dir, state.shard), stored)) {
+        return false;
+    }
+    checkJob(dir, stored, state.config, state.shard, state.count);
+
+    ti.load(indexPath(dir, state.shard));
+    state = stored;
+    return true;
+}
+
+void saveShard(const fs::path &dir, const ShardState &state
+               , const vts::TileIndex &ti)
+{
+    fs::create_directories(dir);
+
+    // tile index first
+    {
+        const auto path(indexPath(dir, state.shard));
+        const auto tmpPath(utility::addExtension(path, ".tmp"));
+        ti.save(tmpPath);
+        fs::rename(tmpPath, path);
+    }
+
+    // then list of subtrees it contains
+    {
+        const auto path(checkpointPath(dir, state.shard));
+        const auto tmpPath(utility::addExtension(path, ".tmp"));
+        {
+            std::ofstream f(tmpPath.string());
+            f.exceptions(std::ios::badbit | std::ios::failbit);
+            f << Magic << '\n'
+              << "config " << state.config << '\n'
+              << "shard " << state.shard << '/' << state.count << '\n';
+            for (const auto &tileId : state.done) {
+                f << "done " << tileId << '\n';
+            }
+            if (state.complete) { f << "complete\n"; }
+        }
+        fs::rename(tmpPath, path);
+    }
+}
+
+vts::TileIndex mergeShards(const fs::path &dir, const std::string &config
+                           , unsigned int count)
+{
+    typedef vts::TileIndex::Flag TiFlag;
+
+    vts::TileIndex ti;
+    for (unsigned int shard(0); shard < count; ++shard) {
+        ShardState stored;
+        if (!readCheckpoint(checkpointPath(dir, shard), stored)) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Shard " << shard << " not found in " << dir << ".";
+        }
+        checkJob(dir, stored, config, shard, count);
+        if (!stored.complete) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Shard " << shard << " in " << dir
+                << " is not complete.";
+        }
+
+        vts::TileIndex shardTi;
+        shardTi.load(indexPath(dir, shard));
+
+        LOG(info3) << "Merging shard " << shard << " ("
+                   << stored.done.size() << " subtrees).";
+
+        // shards overlap only in the part of the tree above the shard LOD
+        // where they computed the same values
+        ti.combine(shardTi, [](TiFlag::value_type o, TiFlag::value_type n)
+                   -> TiFlag::value_type
+        {
+            return o | n;
+        }, shardTi.lodRange());
+    }
+
+    return ti;
+}
+
+unsigned int shardOf(const vts::TileId &root, unsigned int count)
+{
+    // Fibonacci hashing spreads neighbouring subtrees (with similar cost)
+    // among shards
+    const std::uint64_t key((std::uint64_t(root.x) << 32) | root.y);
+    return ((key * 0x9e3779b97f4a7c15ull) >> 32) % count;
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef mapproxy_tiling_checkpoint_hpp_included_
+#define mapproxy_tiling_checkpoint_hpp_included_
+
+#include <set>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+#include "vts-libs/vts/tileindex.hpp"
+
+namespace vts = vtslibs::vts;
+
+/** Persistent state of one shard of distributed tiling job.
+ *
+ *  Shard state is stored in shard directory as a pair of files:
+ *      shard-<index>.ti: tile index generated so far
+ *      shard-<index>.checkpoint: list of completed subtrees
+ *
+ *  Tile index is always written before the checkpoint file therefore every
+ *  subtree listed in the checkpoint is fully present in the tile index.
+ */
+struct ShardState {
+    /** Job configuration, must match when resuming or merging.
+     */
+    std::string config;
+
+    /** Shard index.
+     */
+    unsigned int shard;
+
+    /** Number of shards.
+     */
+    unsigned int count;
+
+    /** Roots of completed subtrees.
+     */
+    std::set<vts::TileId> done;
+
+    /** Whole shard is done.
+     */
+    bool complete;
+
+    ShardState(const std::string &config = "", unsigned int shard = 0
+               , unsigned int count = 1)
+        : config(config), shard(shard), count(count), complete(false)
+    {}
+};
+
+/** Loads shard state and tile index. Returns false if there is nothing to
+ *  resume. Throws if stored state belongs to a different job.
+ */
+bool loadShard(const boost::filesystem::path &dir, ShardState &state
+               , vts::TileIndex &ti);
+
+/** Atomically saves shard state and tile index.
+ */
+void saveShard(const boost::filesystem::path &dir, const ShardState &state
+               , const vts::TileIndex &ti);
+
+/** Merges tile indices of all shards. Throws if any shard is missing,
+ *  incomplete or belongs to a different job.
+ */
+vts::TileIndex mergeShards(const boost::filesystem::path &dir
+                           , const std::string &config, unsigned int count);
+
+/** Deterministic assignment of subtree to shard.
+ */
+unsigned int shardOf(const vts::TileId &root, unsigned int count);
+
+#endif // mapproxy_tiling_checkpoint_hpp_included_
@@ -28,6 +28,14 @@
 #include <utility>
 #include <functional>
 #include <map>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <iomanip>
+#include <condition_variable>
 
 #include <boost/optional.hpp>
 #include <boost/utility/in_place_factory.hpp>
@@ -40,7 +48,7 @@
 #include "utility/streams.hpp"
 #include "utility/tcpendpoint-io.hpp"
 #include "utility/buildsys.hpp"
-#include "utility/openmp.hpp"
+#include "utility/path.hpp"
 #include "service/cmdline.hpp"
 
 #include "geo/geodataset.hpp"
@@ -52,6 +60,13 @@
 #include "vts-libs/vts/tileop.hpp"
 #include "vts-libs/vts/io.hpp"
 #include "vts-libs/vts/tileindex.hpp"
+#include "vts-libs/vts/nodeinfo.hpp"
+#include "vts-libs/vts/csconvertor.hpp"
+
+#include "mapproxy/support/mmapped/tileindex.hpp"
+
+#include "./checkpoint.hpp"
+#include "./scheduler.hpp"
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
@@ -159,7 +174,10 @@ public:
     Tiling()
         : service::Cmdline("mapproxy-tiling", BUILD_TARGET_VERSION
                            , (service::DISABLE_EXCESSIVE_LOGGING))
-        , tileSampling_(128), parallel_(true), forceWatertight_(false)
+        , tileSampling_(128), parallel_(true)
+        , threads_(std::thread::hardware_concurrency())
+        , progressPeriod_(10), forceWatertight_(false)
+        , shard_(0), shardCount_(0), checkpointPeriod_(300), merge_(false)
         , noexcept_(false)
     {}
 
@@ -176,6 +194,12 @@ private:
 
     int runImpl();
 
+    int merge();
+
+    unsigned int threads() const { return parallel_ ? threads_ : 1; }
+
+    std::string jobConfig() const;
+
     fs::path input_;
     fs::path output_;
     std::string referenceFrame_;
@@ -187,8 +211,18 @@ private:
 
     fs::path dataset_;
     bool parallel_;
+    unsigned int threads_;
+    int progressPeriod_;
     bool forceWatertight_;
 
+    unsigned int shard_;
+    unsigned int shardCount_;
+    boost::optional<vts::Lod> shardLod_;
+    fs::path shardDir_;
+    int checkpointPeriod_;
+    bool merge_;
+    boost::optional<fs::path> mmappedOutput_;
+
     bool noexcept_;
 };
 
@@ -216,12 +250,35 @@ void Tiling::configuration(po::options_description &cmdline
          , "Nuber of pixels to break tile into when analyzing its coverage.")
         ("parallel", po::value(&parallel_)
          ->default_value(parallel_)
-         , "Use OpenMP to parallelize work.")
+         , "Process tiles in parallel.")
+        ("threads", po::value(&threads_)->default_value(threads_)
+         , "Number of worker threads used when running in parallel.")
+        ("progressPeriod", po::value(&progressPeriod_)
+         ->default_value(progressPeriod_)
+         , "Period (in seconds) of progress reports, 0 disables them.")
         ("forceWatertight", po::value(&forceWatertight_)
          ->default_value(forceWatertight_)->implicit_value(true)
          , "Treats all partial tiles as watertight. Will lie about the holes "
            "in the dataset.")
 
+        ("shardCount", po::value(&shardCount_)
+         , "Split work into given number of shards; each shard is run "
+         "separately (see --shard) and results are merged using --merge.")
+        ("shard", po::value(&shard_)->default_value(shard_)
+         , "Index of shard to run, in range [0, shardCount).")
+        ("shardLod", po::value<vts::Lod>()
+         , "LOD of subtree roots distributed among shards. Defaults to "
+         "lodRange.min.")
+        ("shardDir", po::value<fs::path>()
+         , "Directory with shard results and checkpoints. Defaults to "
+         "output.shards.")
+        ("checkpointPeriod", po::value(&checkpointPeriod_)
+         ->default_value(checkpointPeriod_)
+         , "Minimum period (in seconds) between shard checkpoints.")
+        ("merge", "Merge results of all (complete) shards into output.")
+        ("mmappedOutput", po::value<fs::path>()
+         , "Path to mmapped tile index to be generated from merged output.")
+
         ("noexcept", "Do not catch exceptions, let the program crash.")
         ;
 
@@ -255,6 +312,33 @@ void Tiling::configure(const po::variables_map &vars)
         throw po::required_option("output");
     }
 
+    merge_ = vars.count("merge");
+    if (vars.count("shardLod")) {
+        shardLod_ = vars["shardLod"].as<vts::Lod>();
+    }
+    if (vars.count("shardDir")) {
+        shardDir_ = vars["shardDir"].as<fs::path>();
+    } else {
+        shardDir_ = utility::addExtension(output_, ".shards");
+    }
+    if (vars.count("mmappedOutput")) {
+        mmappedOutput_ = vars["mmappedOutput"].as<fs::path>();
+    }
+
+    if (shardCount_) {
+        if (shard_ >= shardCount_) {
+            throw po::validation_error
+                (po::validation_error::invalid_option_value, "shard");
+        }
+        if (!shardLod_) { shardLod_ = lodRange_.min; }
+        if (!in(*shardLod_, lodRange_)) {
+            throw po::validation_error
+                (po::validation_error::invalid_option_value, "shardLod");
+        }
+    } else if (merge_) {
+        throw po::required_option("shardCount");
+    }
+
     noexcept_ = vars.count("noexcept");
 
     LOG(info3, log_)
@@ -267,6 +351,16 @@ void Tiling::configure(const po::variables_map &vars)
         << "\n\ttileRange = " << utility::join(tileRanges_, " ")
         << "\n"
         ;
+
+    if (shardCount_) {
+        LOG(info3)
+            << "Sharding:"
+            << "\n\tshard = " << shard_ << "/" << shardCount_
+            << "\n\tshardLod = " << *shardLod_
+            << "\n\tshardDir = " << shardDir_
+            << "\n"
+            ;
+    }
 }
 
 bool Tiling::help(std::ostream &out, const std::string &what) const
@@ -302,6 +396,16 @@ bool Tiling::help(std::ostream &out, const std::string &what) const
                 "        one must explicitely use lodRange starting from zero \n"
                 "        and use --tileRange=0,0:0,0.\n"
                 "\n"
+                "    Sharding:\n"
+                "        Work can be split into --shardCount shards by subtrees\n"
+                "        rooted at --shardLod. Each shard (--shard) can be run\n"
+                "        independently (e.g. on different machines sharing\n"
+                "        --shardDir); it checkpoints its completed subtrees\n"
+                "        and resumes from the last checkpoint when restarted.\n"
+                "        Once all shards are complete, run the tool with\n"
+                "        --merge (and the same options) to produce output\n"
+                "        tile index (and optionally --mmappedOutput).\n"
+                "\n"
                 );
 
         return true;
@@ -321,32 +425,186 @@ math::Extents2 extentsPlusHalfPixel(const math::Extents2 &extents
 
 typedef vts::TileIndex::Flag TiFlag;
 
+/** Sharding setup: subtrees rooted at given LOD are distributed among
+ *  shards, one shard is processed.
+ */
+struct Sharding {
+    unsigned int shard;
+    unsigned int count;
+    vts::Lod lod;
+    fs::path dir;
+    std::string config;
+    std::chrono::seconds checkpointPeriod;
+};
+
+/** Periodically reports processing speed and estimated time to completion.
+ *
+ *  Every processed subtree carries its weight (fraction of the whole tree:
+ *  root has 1, each child gets quarter of its parent); weight of node that
+ *  is not descended is done.
+ */
+class Progress {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    Progress(std::chrono::seconds period)
+        : period_(period), tiles_(0), done_(0.0), start_(clock::now())
+        , stop_(false)
+    {
+        if (period_.count() > 0) {
+            reporter_ = std::thread(&Progress::run, this);
+        }
+    }
+
+    ~Progress() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        if (reporter_.joinable()) { reporter_.join(); }
+    }
+
+    void tile() { ++tiles_; }
+
+    void done(double weight) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_ += weight;
+    }
+
+    /** Starts new phase.
+     */
+    void reset(const std::string &what) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        what_ = what;
+        tiles_ = 0;
+        done_ = 0.0;
+        start_ = clock::now();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cond_.wait_for(lock, period_, [this]() { return stop_; })) {
+            report();
+        }
+    }
+
+    void report() const;
+
+    const std::chrono::seconds period_;
+    std::atomic<std::size_t> tiles_;
+    double done_;
+    clock::time_point start_;
+    std::string what_;
+    bool stop_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread reporter_;
+};
+
+void Progress::report() const
+{
+    const auto elapsed(std::chrono::duration_cast<std::chrono::milliseconds>
+                       (clock::now() - start_).count() / 1000.0);
+    if (elapsed <= 0.0) { return; }
+
+    const auto tiles(tiles_.load());
+    const auto done(std::min(done_, 1.0));
+
+    std::ostringstream os;
+    os << what_ << ": " << tiles << " tiles (" << std::fixed
+       << std::setprecision(1) << (tiles / elapsed) << " tiles/s), "
+       << (100.0 * done) << " % done";
+
+    if (done > 0.0) {
+        const auto eta(long(elapsed * (1.0 - done) / done));
+        os << ", ETA " << (eta / 3600) << ':'
+           << std::setw(2) << std::setfill('0') << ((eta / 60) % 60) << ':'
+           << std::setw(2) << std::setfill('0') << (eta % 60);
+    }
+
+    LOG(info3) << os.str() << ".";
+}
+
 class TreeWalker {
 public:
     TreeWalker(vts::TileIndex &ti, const fs::path &dataset
                , const vts::NodeInfo &root
                , const vts::LodRange &lodRange
                , const vts::LodTileRange::list &tileRanges
-               , int tileSampling, bool parallel, bool forceWatertight);
+               , int tileSampling, unsigned int threads
+               , bool forceWatertight
+               , std::chrono::seconds progressPeriod
+               , const Sharding *sharding = nullptr);
 
 private:
-    void process(bool parentProductive
-                 , const vts::NodeInfo &node, double upscaling = 0.0);
-    void descend(const vts::NodeInfo &node, const vts::TileId &tileId
-                 , double upscaling);
+    /** Subtree root postponed to sharded processing.
+     */
+    struct Root {
+        bool parentProductive;
+        vts::NodeInfo node;
+        double upscaling;
+
+        Root(bool parentProductive, const vts::NodeInfo &node
+             , double upscaling)
+            : parentProductive(parentProductive), node(node)
+            , upscaling(upscaling)
+        {}
+
+        typedef std::vector<Root> list;
+    };
+
+    void runSharded(const vts::NodeInfo &root);
+
+    void processRoots(const Root::list &roots);
+
+    void rootDone(const vts::TileId &tileId);
+
+    void checkpoint(bool complete);
 
-    const geo::GeoDataset& dataset() {
-        return gds_[omp_get_thread_num()];
+    typedef TaskScheduler::Context Context;
+
+    void process(const Context &ctx, bool parentProductive
+                 , const vts::NodeInfo &node, double upscaling
+                 , double weight);
+
+    /** Processes node, returns true if work was passed to children.
+     */
+    bool processImpl(const Context &ctx, bool parentProductive
+                     , const vts::NodeInfo &node, double upscaling
+                     , double weight);
+
+    bool descend(const Context &ctx, const vts::NodeInfo &node
+                 , const vts::TileId &tileId, double upscaling
+                 , double weight);
+
+    /** Spawns processing of the whole tree and waits for its completion.
+     */
+    void walk(const vts::NodeInfo &root);
+
+    const geo::GeoDataset& dataset(const Context &ctx) {
+        return gds_[ctx.worker];
     }
 
     void prepareDataset() {
-        int count(omp_get_num_threads());
+        const auto count(scheduler_.threads());
         gds_.reserve(count);
-        for (int i(0); i < count; ++i) {
+        for (unsigned int i(0); i < count; ++i) {
             gds_.emplace_back(geo::GeoDataset::open(dataset_));
         }
+        dsDescriptor_ = gds_.front().descriptor();
     }
 
+    /** Returns false if node cannot intersect dataset.
+     */
+    bool mayIntersect(const vts::NodeInfo &node);
+
+    /** Extents of dataset in given SRS (none if unknown).
+     */
+    const boost::optional<math::Extents2>& footprint(const std::string &srs);
+
     void buildWorld(const vts::LodRange &lodRange
                     , const vts::LodTileRange::list &tileRanges);
 
@@ -355,11 +613,31 @@ private:
     vts::LodRange lodRange_;
     int tileSampling_;
 
+    TaskScheduler scheduler_;
     std::vector<geo::GeoDataset> gds_;
-    bool parallel_;
+    geo::GeoDataset::Descriptor dsDescriptor_;
     bool forceWatertight_;
 
     vts::TileIndex world_;
+
+    Progress progress_;
+
+    std::mutex tiMutex_;
+    std::mutex rootsMutex_;
+    std::mutex checkpointMutex_;
+
+    std::mutex footprintsMutex_;
+    std::map<std::string, boost::optional<math::Extents2>> footprints_;
+
+    const Sharding *sharding_;
+
+    /** Subtree roots are collected instead of processed when set.
+     */
+    bool collecting_;
+    Root::list roots_;
+
+    ShardState shardState_;
+    std::chrono::steady_clock::time_point lastCheckpoint_;
 };
 
 
@@ -367,24 +645,135 @@ TreeWalker::TreeWalker(vts::TileIndex &ti, const fs::path &dataset
                        , const vts::NodeInfo &root
                        , const vts::LodRange &lodRange
                        , const vts::LodTileRange::list &tileRanges
-                       , int tileSampling, bool parallel, bool forceWatertight)
+                       , int tileSampling, unsigned int threads
+                       , bool forceWatertight
+                       , std::chrono::seconds progressPeriod
+                       , const Sharding *sharding)
     : dataset_(dataset), ti_(ti), lodRange_(lodRange)
-    , tileSampling_(tileSampling)
-    , parallel_(parallel), forceWatertight_(forceWatertight)
+    , tileSampling_(tileSampling), scheduler_(threads)
+    , forceWatertight_(forceWatertight), progress_(progressPeriod)
+    , sharding_(sharding), collecting_(false)
 {
     buildWorld(lodRange, tileRanges);
+    prepareDataset();
 
-    if (parallel_) {
-        UTILITY_OMP(parallel)
-            UTILITY_OMP(single)
-            {
-                prepareDataset();
-                process(false, root);
-            }
-    } else {
-        prepareDataset();
-        process(false, root);
+    if (sharding_) {
+        runSharded(root);
+        return;
     }
+
+    walk(root);
+}
+
+void TreeWalker::walk(const vts::NodeInfo &root)
+{
+    progress_.reset("Tiling");
+    scheduler_.spawn([this, root](const Context &ctx)
+    {
+        process(ctx, false, root, 0.0, 1.0);
+    });
+    scheduler_.run();
+}
+
+void TreeWalker::runSharded(const vts::NodeInfo &root)
+{
+    shardState_ = ShardState(sharding_->config, sharding_->shard
+                             , sharding_->count);
+    if (loadShard(sharding_->dir, shardState_, ti_)) {
+        if (shardState_.complete) {
+            LOG(info3) << "Shard " << sharding_->shard << " already complete.";
+            return;
+        }
+        LOG(info3) << "Resuming shard " << sharding_->shard << " with "
+                   << shardState_.done.size() << " completed subtrees.";
+    }
+    lastCheckpoint_ = std::chrono::steady_clock::now();
+
+    // walk the tree down to shard LOD; every shard computes this part (it is
+    // small) and collects subtree roots
+    collecting_ = true;
+    walk(root);
+    collecting_ = false;
+
+    // keep only not yet processed roots belonging to this shard
+    Root::list roots;
+    for (const auto &r : roots_) {
+        const auto tileId(r.node.nodeId());
+        if (shardOf(tileId, sharding_->count) != sharding_->shard) {
+            continue;
+        }
+        if (shardState_.done.count(tileId)) { continue; }
+        roots.push_back(r);
+    }
+    roots_.clear();
+
+    std::sort(roots.begin(), roots.end(), [](const Root &l, const Root &r)
+    {
+        return l.node.nodeId() < r.node.nodeId();
+    });
+
+    LOG(info3) << "Shard " << sharding_->shard << ": processing "
+               << roots.size() << " subtrees.";
+
+    processRoots(roots);
+
+    checkpoint(true);
+    LOG(info3) << "Shard " << sharding_->shard << " complete.";
+}
+
+void TreeWalker::processRoots(const Root::list &roots)
+{
+    progress_.reset("Shard " + boost::lexical_cast<std::string>
+                    (sharding_->shard));
+    const double weight(1.0 / std::max(roots.size(), std::size_t(1)));
+
+    for (const auto &r : roots) {
+        // subtree is done once all tasks in its group are done
+        const auto tileId(r.node.nodeId());
+        auto group(std::make_shared<TaskScheduler::Group>
+                   ([this, tileId]() { rootDone(tileId); }));
+
+        scheduler_.spawn([this, r, weight](const Context &ctx)
+        {
+            process(ctx, r.parentProductive, r.node, r.upscaling, weight);
+        }, group);
+    }
+
+    scheduler_.run();
+}
+
+void TreeWalker::rootDone(const vts::TileId &tileId)
+{
+    bool save(false);
+    {
+        std::unique_lock<std::mutex> lock(tiMutex_);
+        shardState_.done.insert(tileId);
+        const auto now(std::chrono::steady_clock::now());
+        if ((now - lastCheckpoint_) >= sharding_->checkpointPeriod) {
+            lastCheckpoint_ = now;
+            save = true;
+        }
+    }
+
+    if (save) { checkpoint(false); }
+}
+
+void TreeWalker::checkpoint(bool complete)
+{
+    std::unique_lock<std::mutex> checkpointLock(checkpointMutex_);
+
+    // take consistent snapshot of tile index and list of done subtrees
+    vts::TileIndex ti;
+    ShardState state;
+    {
+        std::unique_lock<std::mutex> lock(tiMutex_);
+        ti = ti_;
+        state = shardState_;
+    }
+    state.complete = complete;
+
+    saveShard(sharding_->dir, state, ti);
+    LOG(info3) << "Checkpoint: " << state.done.size() << " subtrees done.";
 }
 
 void TreeWalker::buildWorld(const vts::LodRange &lodRange
@@ -406,33 +795,97 @@ void TreeWalker::buildWorld(const vts::LodRange &lodRange
     }
 }
 
-void TreeWalker::descend(const vts::NodeInfo &node
-                         , const vts::TileId &tileId, double upscaling)
+const boost::optional<math::Extents2>&
+TreeWalker::footprint(const std::string &srs)
+{
+    std::unique_lock<std::mutex> lock(footprintsMutex_);
+    auto ffootprints(footprints_.find(srs));
+    if (ffootprints != footprints_.end()) { return ffootprints->second; }
+
+    auto &fp(footprints_[srs]);
+
+    // image of dataset border bounds image of whole dataset; sample it
+    const int steps(64);
+    const auto &e(dsDescriptor_.extents);
+    const auto es(math::size(e));
+
+    try {
+        const vts::CsConvertor conv(dsDescriptor_.srs, srs);
+
+        math::Extents2 extents(math::InvalidExtents{});
+        for (int i(0); i <= steps; ++i) {
+            const double x(e.ll(0) + (es.width * i) / steps);
+            const double y(e.ll(1) + (es.height * i) / steps);
+            math::update(extents, conv(math::Point2(x, e.ll(1))));
+            math::update(extents, conv(math::Point2(x, e.ur(1))));
+            math::update(extents, conv(math::Point2(e.ll(0), y)));
+            math::update(extents, conv(math::Point2(e.ur(0), y)));
+        }
+
+        // some slack for sampling error
+        const auto size(math::size(extents));
+        const math::Point2 margin(size.width * 0.05, size.height * 0.05);
+        fp = math::Extents2(extents.ll - margin, extents.ur + margin);
+    } catch (const std::exception &e) {
+        // cannot tell, no pruning in this SRS
+        LOG(info2) << "Unable to compute dataset footprint in SRS <"
+                   << srs << ">: " << e.what() << ".";
+    }
+
+    return fp;
+}
+
+bool TreeWalker::mayIntersect(const vts::NodeInfo &node)
+{
+    const auto &fp(footprint(node.srs()));
+    if (!fp) { return true; }
+
+    const auto &e(node.extents());
+    return ((e.ll(0) <= fp->ur(0)) && (fp->ll(0) <= e.ur(0))
+            && (e.ll(1) <= fp->ur(1)) && (fp->ll(1) <= e.ur(1)));
+}
+
+bool TreeWalker::descend(const Context &ctx, const vts::NodeInfo &node
+                         , const vts::TileId &tileId, double upscaling
+                         , double weight)
 {
     if (tileId.lod == lodRange_.max) {
         // no children down there
-        return;
+        return false;
     }
 
-    // do not use const otherwise OpenMP makes it shared
-    bool parentProductive(node.productive());
+    const bool parentProductive(node.productive());
+    const auto children(vts::children(tileId));
+    const double childWeight(weight / children.size());
 
     // we can proces children -> go down
-    for (auto child : vts::children(tileId)) {
+    for (auto child : children) {
         // compute child node
         auto childNode(node.child(child));
 
-        if (parallel_) {
-            UTILITY_OMP(task)
-                process(parentProductive, childNode, upscaling);
-        } else {
-            process(parentProductive, childNode, upscaling);
-        }
+        scheduler_.spawn(ctx, [=](const Context &childCtx)
+        {
+            process(childCtx, parentProductive, childNode, upscaling
+                    , childWeight);
+        });
+    }
+
+    return true;
+}
+
+void TreeWalker::process(const Context &ctx, bool parentProductive
+                         , const vts::NodeInfo &node, double upscaling
+                         , double weight)
+{
+    if (!processImpl(ctx, parentProductive, node, upscaling, weight)) {
+        // nothing passed to children, whole subtree is done
+        progress_.done(weight);
     }
 }
 
-void TreeWalker::process(bool parentProductive
-                         , const vts::NodeInfo &node, double upscaling)
+bool TreeWalker::processImpl(const Context &ctx, bool parentProductive
+                             , const vts::NodeInfo &node, double upscaling
+                             , double weight)
 {
     struct TIDGuard {
         TIDGuard(const std::string &id)
@@ -448,13 +901,20 @@ void TreeWalker::process(bool parentProductive
     const auto tileId(node.nodeId());
     if ((tileId.lod > lodRange_.max)) {
         // outside of configured area
-        return;
+        return false;
+    }
+
+    if (collecting_ && (tileId.lod == sharding_->lod)) {
+        // subtree root, postpone
+        std::unique_lock<std::mutex> lock(rootsMutex_);
+        roots_.emplace_back(parentProductive, node, upscaling);
+        return false;
     }
 
     auto fullSubtree([&]()
     {
-        UTILITY_OMP(critical(tileIndex))
         {
+            std::unique_lock<std::mutex> lock(tiMutex_);
             ti_.set(vts::LodRange(tileId.lod, lodRange_.max)
                     , vts::tileRange(tileId)
                     , (TiFlag::mesh | TiFlag::watertight));
@@ -482,15 +942,21 @@ void TreeWalker::process(bool parentProductive
                 << ", srs: " << node.srs()
                 << ") [fake watertight subtree in invalid part of a tree].";
         }
-        return;
+        return false;
     }
 
     if (!node.productive()) {
+        if (!world_.get(tileId)) {
+            // outside of defined world, nothing productive down there
+            return false;
+        }
+
         // unproductive node, immediate descend
-        descend(node, tileId, upscaling);
-        return;
+        return descend(ctx, node, tileId, upscaling, weight);
     }
 
+    progress_.tile();
+
     LOG(info2) << "Processing tile " << tileId << ".";
 
     int samples(tileSampling_);
@@ -508,12 +974,22 @@ void TreeWalker::process(bool parentProductive
     if (!flags) {
         // outside of defined world
         LOG(info1) << "outside of defined world";
-        return;
+        return false;
     }
 
     if (flags & Flag::analyze) {
+        if (!mayIntersect(node)) {
+            // no chance to hit dataset, no need to warp
+            LOG(info3)
+                << "Processed tile " << tileId
+                << " (extents: " << std::fixed << node.extents()
+                << ", srs: " << node.srs()
+                << ") [empty, outside of dataset].";
+            return false;
+        }
+
         // warp input dataset into tile
-        const auto &ds(dataset());
+        const auto &ds(dataset(ctx));
         // set some output nodata value to force mask generation
         auto tileDs(geo::GeoDataset::deriveInMemory
                     (ds, node.srsDef(), size
@@ -581,11 +1057,13 @@ void TreeWalker::process(bool parentProductive
                     << " (extents: " << std::fixed << node.extents()
                     << ", srs: " << node.srs()
                     << ") [watertight subtree].";
-                return;
+                return false;
             }
 
-            UTILITY_OMP(critical(tileIndex))
+            {
+                std::unique_lock<std::mutex> lock(tiMutex_);
                 ti_.set(tileId, (baseFlags | TiFlag::watertight));
+            }
             LOG(info3)
                 << "Processed tile " << tileId
                 << " (extents: " << std::fixed << node.extents()
@@ -596,8 +1074,10 @@ void TreeWalker::process(bool parentProductive
 
         case vts::NodeInfo::CoveredArea::some: {
             // partially covered
-            UTILITY_OMP(critical(tileIndex))
+            {
+                std::unique_lock<std::mutex> lock(tiMutex_);
                 ti_.set(tileId, baseFlags);
+            }
             LOG(info3)
                 << "Processed tile " << tileId
                 << " (extents: " << std::fixed << node.extents()
@@ -613,7 +1093,7 @@ void TreeWalker::process(bool parentProductive
                 << " (extents: " << std::fixed << node.extents()
                 << ", srs: " << node.srs()
                 << ") [empty].";
-            return;
+            return false;
         }
         }
 
@@ -628,26 +1108,75 @@ void TreeWalker::process(bool parentProductive
     }
 
     // descend to children
-    descend(node, tileId, upscaling);
-    // done
+    return descend(ctx, node, tileId, upscaling, weight);
+}
+
+std::string Tiling::jobConfig() const
+{
+    std::ostringstream os;
+    os << dataset_.string() << '|' << referenceFrame_ << '|' << lodRange_
+       << '|' << utility::join(tileRanges_, " ") << '|' << tileSampling_
+       << '|' << forceWatertight_ << '|' << *shardLod_;
+    return os.str();
+}
+
+int Tiling::merge()
+{
+    auto ti(mergeShards(shardDir_, jobConfig(), shardCount_));
+
+    LOG(info3) << "Saving merged tile index into " << output_ << ".";
+    ti.save(output_);
+
+    if (mmappedOutput_) {
+        LOG(info3) << "Saving mmapped tile index into "
+                   << *mmappedOutput_ << ".";
+        mmapped::TileIndex::write(*mmappedOutput_, ti);
+    }
+    LOG(info3) << "Tile index saved.";
+
+    return EXIT_SUCCESS;
 }
 
 int Tiling::runImpl()
 {
+    if (merge_) { return merge(); }
+
     auto rf(vr::system.referenceFrames(referenceFrame_));
 
     auto ds(geo::GeoDataset::open(dataset_));
 
     vts::TileIndex ti;
 
+    if (shardCount_) {
+        const Sharding sharding{
+            shard_, shardCount_, *shardLod_, shardDir_, jobConfig()
+            , std::chrono::seconds(checkpointPeriod_)
+        };
+
+        TreeWalker(ti, dataset_, vts::NodeInfo(rf), lodRange_
+                   , asLodTileRangeList(lodRange_.min, tileRanges_)
+                   , tileSampling_, threads(), forceWatertight_
+                   , std::chrono::seconds(progressPeriod_), &sharding);
+
+        // output is produced by merge
+        return EXIT_SUCCESS;
+    }
+
     TreeWalker(ti, dataset_, vts::NodeInfo(rf), lodRange_
                , asLodTileRangeList(lodRange_.min, tileRanges_)
-               , tileSampling_, parallel_, forceWatertight_);
+               , tileSampling_, threads(), forceWatertight_
+               , std::chrono::seconds(progressPeriod_));
 
     LOG(info3) << "Saving generated tile index into " << output_ << ".";
     ti.save(output_);
     LOG(info3) << "Tile index saved.";
 
+    if (mmappedOutput_) {
+        LOG(info3) << "Saving mmapped tile index into "
+                   << *mmappedOutput_ << ".";
+        mmapped::TileIndex::write(*mmappedOutput_, ti);
+    }
+
     return EXIT_SUCCESS;
 }
 
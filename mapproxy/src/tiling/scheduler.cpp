@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <thread>
+
+#include <boost/format.hpp>
+
+#include "dbglog/dbglog.hpp"
+
+#include "./scheduler.hpp"
+
+TaskScheduler::TaskScheduler(unsigned int threads)
+    : pending_(0), queued_(0), next_(0), failed_(false)
+{
+    if (!threads) { threads = 1; }
+    for (unsigned int i(0); i < threads; ++i) {
+        queues_.emplace_back(new Queue());
+    }
+}
+
+void TaskScheduler::spawn(const Task &task, const Group::pointer &group)
+{
+    const auto worker(next_++ % queues_.size());
+    push(worker, Item(task, group));
+}
+
+void TaskScheduler::spawn(const Context &ctx, const Task &task)
+{
+    push(ctx.worker, Item(task, ctx.group));
+}
+
+void TaskScheduler::push(unsigned int worker, Item &&item)
+{
+    if (item.group) { ++item.group->pending; }
+    ++pending_;
+
+    {
+        auto &q(*queues_[worker]);
+        std::unique_lock<std::mutex> lock(q.mutex);
+        q.items.push_back(std::move(item));
+    }
+    ++queued_;
+
+    // lock to avoid lost wakeup
+    { std::unique_lock<std::mutex> lock(mutex_); }
+    cond_.notify_one();
+}
+
+bool TaskScheduler::pop(unsigned int worker, Item &item)
+{
+    auto &q(*queues_[worker]);
+    std::unique_lock<std::mutex> lock(q.mutex);
+    if (q.items.empty()) { return false; }
+    item = std::move(q.items.back());
+    q.items.pop_back();
+    --queued_;
+    return true;
+}
+
+bool TaskScheduler::steal(unsigned int worker, Item &item)
+{
+    const auto size(queues_.size());
+    for (std::size_t i(1); i < size; ++i) {
+        auto &q(*queues_[(worker + i) % size]);
+        std::unique_lock<std::mutex> lock(q.mutex);
+        if (q.items.empty()) { continue; }
+        item = std::move(q.items.front());
+        q.items.pop_front();
+        --queued_;
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::execute(unsigned int worker, Item &item)
+{
+    if (!failed_) {
+        try {
+            item.task(Context{ worker, item.group });
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!failed_) {
+                exception_ = std::current_exception();
+                failed_ = true;
+            }
+        }
+    }
+
+    // group callback is not called when failed, group is not complete
+    if (item.group && !--item.group->pending && !failed_) {
+        item.group->done();
+    }
+
+    // release resources held by task before announcing it is done
+    item = Item();
+
+    if (!--pending_) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.notify_all();
+    }
+}
+
+void TaskScheduler::worker(unsigned int worker)
+{
+    Item item;
+    for (;;) {
+        if (pop(worker, item) || steal(worker, item)) {
+            execute(worker, item);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return queued_ || !pending_; });
+        if (!pending_) { return; }
+    }
+}
+
+void TaskScheduler::run()
+{
+    std::vector<std::thread> workers;
+    for (unsigned int i(1), e(queues_.size()); i < e; ++i) {
+        workers.emplace_back([this, i]()
+        {
+            dbglog::thread_id(str(boost::format("worker:%d") % i));
+            worker(i);
+        });
+    }
+
+    worker(0);
+
+    for (auto &w : workers) { w.join(); }
+
+    if (exception_) {
+        auto e(exception_);
+        exception_ = {};
+        failed_ = false;
+        std::rethrow_exception(e);
+    }
+}
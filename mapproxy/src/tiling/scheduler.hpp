@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef mapproxy_tiling_scheduler_hpp_included_
+#define mapproxy_tiling_scheduler_hpp_included_
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+/** Work-stealing task scheduler.
+ *
+ *  Every worker has its own task queue. Tasks spawned by a task go to the
+ *  queue of the worker running it and are processed in LIFO order (i.e. depth
+ *  first). Idle workers steal the oldest tasks (i.e. the biggest pending
+ *  subtrees) from other workers.
+ */
+class TaskScheduler {
+public:
+    /** Group of tasks. Completion callback is called once all tasks in the
+     *  group, including tasks spawned by them, are done.
+     */
+    struct Group {
+        typedef std::shared_ptr<Group> pointer;
+
+        Group(const std::function<void()> &done)
+            : pending(0), done(done) {}
+
+        std::atomic<std::size_t> pending;
+        std::function<void()> done;
+    };
+
+    /** Execution context of running task.
+     */
+    struct Context {
+        /** Index of worker running the task, in range [0, threads).
+         */
+        unsigned int worker;
+
+        /** Group the task belongs to, can be null.
+         */
+        Group::pointer group;
+    };
+
+    typedef std::function<void(const Context&)> Task;
+
+    TaskScheduler(unsigned int threads);
+
+    unsigned int threads() const { return queues_.size(); }
+
+    /** Spawns task from outside of the scheduler. Tasks are distributed among
+     *  workers in round robin fashion.
+     */
+    void spawn(const Task &task, const Group::pointer &group = {});
+
+    /** Spawns task from running task, inherits its group.
+     */
+    void spawn(const Context &ctx, const Task &task);
+
+    /** Runs workers (calling thread is worker 0) until all tasks are done.
+     *  Rethrows first exception thrown by any task; remaining tasks are
+     *  dropped in such case.
+     */
+    void run();
+
+private:
+    struct Item {
+        Task task;
+        Group::pointer group;
+
+        Item() = default;
+        Item(const Task &task, const Group::pointer &group)
+            : task(task), group(group) {}
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+
+    void push(unsigned int worker, Item &&item);
+    bool pop(unsigned int worker, Item &item);
+    bool steal(unsigned int worker, Item &item);
+
+    void worker(unsigned int worker);
+    void execute(unsigned int worker, Item &item);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    /** Number of spawned but not finished tasks.
+     */
+    std::atomic<std::size_t> pending_;
+
+    /** Number of tasks sitting in queues.
+     */
+    std::atomic<std::size_t> queued_;
+
+    unsigned int next_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+
+    std::atomic<bool> failed_;
+    std::exception_ptr exception_;
+};
+
+#endif // mapproxy_tiling_scheduler_hpp_included_
@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+
+#include <boost/optional.hpp>
+
+#include "utility/buildsys.hpp"
+#include "service/cmdline.hpp"
+
+#include "geo/geodataset.hpp"
+
+#include "vts-libs/registry/po.hpp"
+#include "vts-libs/vts/nodeinfo.hpp"
+
+#include "mapproxy/support/mesh.hpp"
+#include "mapproxy/support/rtin.hpp"
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+namespace vr = vtslibs::registry;
+
+class MeshBench : public service::Cmdline {
+public:
+    MeshBench()
+        : service::Cmdline("mapproxy-mesh-bench", BUILD_TARGET_VERSION)
+        , samplesPerSide_(128), iterations_(10)
+    {
+    }
+
+private:
+    void configuration(po::options_description &cmdline
+                       , po::options_description &config
+                       , po::positional_options_description &pd);
+
+    void configure(const po::variables_map &vars);
+
+    bool help(std::ostream &out, const std::string &what) const;
+
+    int run();
+
+    fs::path dataset_;
+    std::string referenceFrame_;
+    vts::TileId tileId_;
+    boost::optional<std::string> geoidGrid_;
+    int samplesPerSide_;
+    int iterations_;
+};
+
+void MeshBench::configuration(po::options_description &cmdline
+                              , po::options_description &config
+                              , po::positional_options_description &pd)
+{
+    vr::registryConfiguration(cmdline, vr::defaultPath());
+
+    cmdline.add_options()
+        ("dataset", po::value(&dataset_)->required()
+         , "Path to DEM dataset.")
+        ("referenceFrame", po::value(&referenceFrame_)->required()
+         , "Reference frame.")
+        ("tileId", po::value(&tileId_)->required()
+         , "Tile ID to mesh.")
+        ("geoidGrid", po::value<std::string>()
+         , "Optional geoid grid.")
+        ("samplesPerSide", po::value(&samplesPerSide_)
+         ->default_value(samplesPerSide_)
+         , "Number of grid edges per tile side.")
+        ("iterations", po::value(&iterations_)
+         ->default_value(iterations_)
+         , "Number of iterations to run for each simplifier.")
+        ;
+
+    pd.add("dataset", 1)
+        .add("referenceFrame", 1)
+        .add("tileId", 1);
+
+    (void) config;
+}
+
+void MeshBench::configure(const po::variables_map &vars)
+{
+    vr::registryConfigure(vars);
+
+    if (vars.count("geoidGrid")) {
+        geoidGrid_ = vars["geoidGrid"].as<std::string>();
+    }
+}
+
+bool MeshBench::help(std::ostream &out, const std::string &what) const
+{
+    if (what.empty()) {
+        // program help
+        out << ("mapproxy mesh simplifier benchmark\n"
+                "    Meshes given tile from DEM dataset using both decimation\n"
+                "    and RTIN simplifiers and reports their timing.\n"
+                "\n"
+                );
+
+        return true;
+    }
+
+    return false;
+}
+
+namespace {
+
+const auto ForcedNodata(geo::GeoDataset::NodataValue(-1e10));
+
+math::Extents2 extentsPlusHalfPixel(const math::Extents2 &extents
+                                    , int pixels)
+{
+    auto es(math::size(extents));
+    const math::Size2f px(es.width / pixels, es.height / pixels);
+    const math::Point2 hpx(px.width / 2, px.height / 2);
+    return math::Extents2(extents.ll - hpx, extents.ur + hpx);
+}
+
+template <typename Function>
+double measure(int iterations, const Function &function)
+{
+    const auto start(std::chrono::steady_clock::now());
+    for (int i(0); i < iterations; ++i) { function(); }
+    const auto end(std::chrono::steady_clock::now());
+
+    return (std::chrono::duration_cast<std::chrono::microseconds>
+            (end - start).count() / (1000.0 * iterations));
+}
+
+} // namespace
+
+int MeshBench::run()
+{
+    const auto rf(vr::system.referenceFrames(referenceFrame_));
+    const vts::NodeInfo nodeInfo(rf, tileId_);
+    if (!nodeInfo.productive()) {
+        std::cerr << "Tile " << tileId_ << " is not productive." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // warp DEM into tile grid (same as mapproxy does)
+    const math::Size2 edges(samplesPerSide_, samplesPerSide_);
+    const math::Size2 gridSize(edges.width + 1, edges.height + 1);
+
+    auto src(geo::GeoDataset::open(dataset_));
+    auto dem(geo::GeoDataset::deriveInMemory
+             (src, nodeInfo.srsDef(), gridSize
+              , extentsPlusHalfPixel(nodeInfo.extents(), edges.width)
+              , GDT_Float32, ForcedNodata));
+    src.warpInto(dem, geo::GeoDataset::Resampling::dem);
+
+    const auto &data(dem.cdata());
+    const HeightSampler sampler([&](int i, int j, double &h) -> bool
+    {
+        h = data.at<double>(j, i);
+        return (h >= -1e6);
+    });
+
+    const TileFacesCalculator tileFacesCalculator;
+
+    std::size_t decimationFaces(0);
+    const auto decimation(measure(iterations_, [&]()
+    {
+        auto meshInfo(meshFromNode(nodeInfo, edges, sampler));
+        simplifyMesh(std::get<0>(meshInfo), nodeInfo, tileFacesCalculator
+                     , geoidGrid_);
+        decimationFaces = std::get<0>(meshInfo).faces.size();
+    }));
+
+    std::cout << "decimation: " << decimation << " ms/mesh, "
+              << decimationFaces << " faces" << std::endl;
+
+    if (!rtinCompatible(edges)) {
+        std::cout << "rtin: unsupported grid size " << edges << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    std::size_t rtinFaces(0);
+    const auto rtin(measure(iterations_, [&]()
+    {
+        auto meshInfo(rtinMeshFromNode(nodeInfo, edges, sampler
+                                       , tileFacesCalculator, geoidGrid_));
+        rtinFaces = std::get<0>(meshInfo).faces.size();
+    }));
+
+    std::cout << "rtin: " << rtin << " ms/mesh, "
+              << rtinFaces << " faces" << std::endl;
+
+    if (rtin > 0.0) {
+        std::cout << "speedup: " << (decimation / rtin) << "x" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    return MeshBench()(argc, argv);
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <random>
+
+#include "utility/buildsys.hpp"
+#include "utility/filesystem.hpp"
+#include "service/cmdline.hpp"
+
+#include "mapproxy/support/mmapped/tileindex.hpp"
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+class MMappedTileIndexBench : public service::Cmdline {
+public:
+    MMappedTileIndexBench()
+        : service::Cmdline("mapproxy-mmti-bench", BUILD_TARGET_VERSION)
+        , jumpDepth_(mmapped::QTree::defaultJumpDepth)
+        , lookups_(1000000)
+    {
+    }
+
+private:
+    void configuration(po::options_description &cmdline
+                       , po::options_description &config
+                       , po::positional_options_description &pd);
+
+    void configure(const po::variables_map &vars);
+
+    bool help(std::ostream &out, const std::string &what) const;
+
+    int run();
+
+    fs::path input_;
+    fs::path workdir_;
+    unsigned int jumpDepth_;
+    int lookups_;
+};
+
+void MMappedTileIndexBench::configuration(po::options_description &cmdline
+                                          , po::options_description &config
+                                          , po::positional_options_description
+                                          &pd)
+{
+    cmdline.add_options()
+        ("input", po::value(&input_)->required()
+         , "Path to input (vts) tile index.")
+        ("workdir", po::value(&workdir_)->default_value(".")
+         , "Directory where to place temporary mmapped tile indices.")
+        ("jumpDepth", po::value(&jumpDepth_)->default_value(jumpDepth_)
+         , "Depth of per-tree lookup jump table.")
+        ("lookups", po::value(&lookups_)->default_value(lookups_)
+         , "Number of random lookups per tree.")
+        ;
+
+    pd.add("input", 1);
+
+    (void) config;
+}
+
+void MMappedTileIndexBench::configure(const po::variables_map &vars)
+{
+    (void) vars;
+}
+
+bool MMappedTileIndexBench::help(std::ostream &out
+                                 , const std::string &what) const
+{
+    if (what.empty()) {
+        // program help
+        out << ("mapproxy mmapped tileindex lookup benchmark\n"
+                "    Converts tile index to mmapped tile index both with and\n"
+                "    without jump tables and compares lookup throughput.\n"
+                "\n"
+                );
+
+        return true;
+    }
+
+    return false;
+}
+
+namespace {
+
+template <typename Function>
+double measure(const Function &function)
+{
+    const auto start(std::chrono::steady_clock::now());
+    function();
+    const auto end(std::chrono::steady_clock::now());
+
+    return (std::chrono::duration_cast<std::chrono::microseconds>
+            (end - start).count() / 1000.0);
+}
+
+} // namespace
+
+int MMappedTileIndexBench::run()
+{
+    vts::TileIndex ti;
+    ti.load(input_);
+
+    const auto plainPath(workdir_ / "mmti-bench.plain");
+    const auto jumpPath(workdir_ / "mmti-bench.jump");
+    mmapped::TileIndex::WriteOptions wo;
+    wo.jumpDepth = 0;
+    mmapped::TileIndex::write(plainPath, ti, wo);
+    wo.jumpDepth = jumpDepth_;
+    mmapped::TileIndex::write(jumpPath, ti, wo);
+
+    std::cout << "size: plain " << utility::fileSize(plainPath)
+              << " B, with jump table " << utility::fileSize(jumpPath)
+              << " B" << std::endl;
+
+    const mmapped::TileIndex plain(plainPath);
+    const mmapped::TileIndex jump(jumpPath);
+
+    fs::remove(plainPath);
+    fs::remove(jumpPath);
+
+    std::mt19937 gen;
+    int mismatches(0);
+
+    for (vts::Lod lod(0); lod <= ti.maxLod(); ++lod) {
+        // generate random tile IDs inside this lod
+        std::uniform_int_distribution<unsigned int> dist(0, (1u << lod) - 1);
+        std::vector<vts::TileId> tiles;
+        tiles.reserve(lookups_);
+        for (int i(0); i < lookups_; ++i) {
+            tiles.emplace_back(lod, dist(gen), dist(gen));
+        }
+
+        unsigned int plainSum(0), jumpSum(0);
+        const auto plainTime(measure([&]()
+        {
+            for (const auto &tileId : tiles) { plainSum += plain.get(tileId); }
+        }));
+        const auto jumpTime(measure([&]()
+        {
+            for (const auto &tileId : tiles) { jumpSum += jump.get(tileId); }
+        }));
+
+        for (const auto &tileId : tiles) {
+            mismatches += (plain.get(tileId) != jump.get(tileId));
+        }
+
+        std::cout << "lod " << lod << ": plain " << plainTime
+                  << " ms, jump " << jumpTime << " ms";
+        if (jumpTime > 0.0) {
+            std::cout << ", speedup " << (plainTime / jumpTime) << "x";
+        }
+        std::cout << " (checksums " << plainSum << "/" << jumpSum << ")"
+                  << std::endl;
+    }
+
+    if (mismatches) {
+        std::cerr << "Lookup mismatches: " << mismatches << "." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    return MMappedTileIndexBench()(argc, argv);
+}
@@ -1,3 +1,7 @@
+#include <chrono>
+#include <algorithm>
+#include <thread>
+
 #include "utility/buildsys.hpp"
 #include "service/cmdline.hpp"
 
@@ -10,6 +14,8 @@ class TileIndex2MMappedTileIndex : public service::Cmdline {
 public:
     TileIndex2MMappedTileIndex()
         : service::Cmdline("mapproxy-ti2mmti", BUILD_TARGET_VERSION)
+        , jumpDepth_(mmapped::QTree::defaultJumpDepth)
+        , threads_(std::max(1u, std::thread::hardware_concurrency()))
     {
     }
 
@@ -26,6 +32,8 @@ private:
 
     fs::path input_;
     fs::path output_;
+    unsigned int jumpDepth_;
+    unsigned int threads_;
 };
 
 void TileIndex2MMappedTileIndex
@@ -38,6 +46,10 @@ void TileIndex2MMappedTileIndex
          , "Path to input tile index.")
         ("output", po::value(&output_)->required()
          , "Path to output mmapped tile index.")
+        ("jumpDepth", po::value(&jumpDepth_)->default_value(jumpDepth_)
+         , "Depth of per-tree lookup jump table, 0 disables it.")
+        ("threads", po::value(&threads_)->default_value(threads_)
+         , "Number of threads writing trees in parallel.")
         ;
 
     pd.add("input", 1)
@@ -68,9 +80,42 @@ bool TileIndex2MMappedTileIndex::help(std::ostream &out
 
 int TileIndex2MMappedTileIndex::run()
 {
+    typedef std::chrono::steady_clock clock;
+    const auto seconds([](clock::duration d) -> double
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>
+            (d).count() / 1000.0;
+    });
+
+    const auto start(clock::now());
+
     vts::TileIndex ti;
     ti.load(input_);
-    mmapped::TileIndex::write(output_, ti);
+
+    const auto loaded(clock::now());
+    std::cout << "Loaded " << input_ << " in " << seconds(loaded - start)
+              << " s." << std::endl;
+
+    std::size_t total(0);
+    mmapped::TileIndex::WriteOptions wo;
+    wo.jumpDepth = jumpDepth_;
+    wo.threads = threads_;
+    wo.progress = [&](vts::Lod lod, std::size_t size)
+    {
+        total += size;
+        std::cout << "    lod " << lod << ": " << size << " B" << std::endl;
+    };
+
+    mmapped::TileIndex::write(output_, ti, wo);
+
+    const auto elapsed(seconds(clock::now() - loaded));
+    std::cout << "Written " << total << " B in " << elapsed << " s";
+    if (elapsed > 0.0) {
+        std::cout << " (" << (total / (1024.0 * 1024.0 * elapsed))
+                  << " MB/s, " << threads_ << " thread(s))";
+    }
+    std::cout << "." << std::endl;
+
     return EXIT_SUCCESS;
 }
 